@@ -9,7 +9,7 @@ my @instances =
 {	name => 'intsym.h'
 ,	guard => 'MPG123_INTSYM_H'
 ,	dir => 'src/libmpg123'
-,	headers => [qw(../compat/compat decode dither frame getbits getcpuflags huffman icy2utf8 icy id3 index mpg123lib_intern optimize parse reader)]
+,	headers => [qw(../compat/compat decode dither frame getbits getcpuflags huffman icy2utf8 icy id3 index mpg123lib_intern optimize parse pipeline reader)]
 ,	prefix => 'INT123_'
 ,	apiprefix => 'mpg123_'
 ,	conditional => { strerror=>'HAVE_STRERROR', strdup=>'HAVE_STRDUP' }
@@ -0,0 +1,336 @@
+/*
+	checkpoint: decoder state snapshots for exact seeking
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	See checkpoint.h for the idea. What makes up the state before decoding frame n:
+	- the end of frame n-1 in the bitstream buffer, where set_pointer() takes the
+	  bit reservoir from, plus the count of valid reservoir bytes,
+	- the halves of fr->hybrid_block that III_hybrid() adds to the next granule,
+	- the synth buffers in fr->rawbuffs (whatever layout the decoder uses) and the
+	  position fr->bo in them, dither position.
+	NtoM state is a function of the frame number and gets set by the seek anyway.
+	The sinc resampler history is not included, snapshots are not used with it.
+*/
+
+#include "mpg123lib_intern.h"
+#include "checkpoint.h"
+#include "debug.h"
+
+/* The bit reservoir reaches back at most 511 bytes. */
+#define CP_RESERVOIR 512
+/* Most snapshots to keep for a track, about 19M for stereo Layer III.
+   That covers some minutes with the suggested intervals; for longer tracks, the list
+   is thinned out to every other snapshot whenever it is full. */
+#define CP_MAX 2048
+
+struct checkpoint
+{
+	off_t frame;
+	enum optdec type;        /* decoder the synth buffers belong to */
+	unsigned char *rawbuffs; /* ... and their place, for the alignment */
+	size_t buffs;            /* bytes of synth buffers */
+	size_t reservoir;        /* bytes of bitstream, 0 for Layer I/II */
+	size_t hybrid;           /* bytes of overlap-add data per channel, 0 for Layer I/II */
+	int fsizeold;
+	unsigned int bitreservoir;
+	int hybrid_blc[2];
+	int bo;
+#ifdef OPT_I486
+	int i486bo[2];
+#endif
+#ifdef OPT_DITHER
+	int ditherindex;
+#endif
+	/* Followed by reservoir, hybrid and synth buffer data. */
+};
+
+struct checkpoints
+{
+	struct checkpoint **list; /* ascending frames */
+	size_t fill;
+	size_t size;
+	off_t stride; /* Snapshots are taken every stride*n frames, it doubles with each thinning. */
+};
+
+static int checkpoint_usable(mpg123_handle *fr)
+{
+#ifdef SINC_RESAMPLE
+	if(fr->resampler != NULL && fr->down_sample == 3) return FALSE;
+#endif
+	return fr->p.checkpoints > 0 && fr->rawbuffs != NULL;
+}
+
+/* Number of snapshots at or before the frame. */
+static size_t checkpoint_bound(struct checkpoints *cps, off_t frame)
+{
+	size_t lo = 0;
+	size_t hi = cps->fill;
+	while(lo < hi)
+	{
+		size_t mid = lo + (hi-lo)/2;
+		if(cps->list[mid]->frame <= frame) lo = mid+1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+/* Drop the snapshots that do not fit a doubled stride, making room for the rest of the track. */
+static void checkpoint_thin(struct checkpoints *cps, long interval)
+{
+	size_t i, fill = 0;
+	cps->stride *= 2;
+	for(i=0; i<cps->fill; ++i)
+	{
+		if((cps->list[i]->frame/interval) % cps->stride) free(cps->list[i]);
+		else cps->list[fill++] = cps->list[i];
+	}
+	debug3("thinned checkpoints to stride %"OFF_P": %"SIZE_P" of %"SIZE_P, (off_p)cps->stride, (size_p)fill, (size_p)cps->fill);
+	cps->fill = fill;
+}
+
+static int checkpoint_fits(mpg123_handle *fr, struct checkpoint *cp)
+{
+	return cp->type == fr->cpu_opts.type && cp->rawbuffs == fr->rawbuffs
+	&&	cp->buffs == (size_t)fr->rawbuffss;
+}
+
+void checkpoint_save(mpg123_handle *fr)
+{
+	struct checkpoints *cps = fr->checkpoints;
+	struct checkpoint *cp;
+	unsigned char *data;
+	size_t pos, reservoir, hybrid;
+	int ch;
+
+	/* Only decoding every frame from the start (or a restored snapshot) on gives the exact state. */
+	if(fr->num != fr->checkpoint_next)
+	{
+		fr->checkpoint_next = -1;
+		return;
+	}
+	++fr->checkpoint_next;
+	if(!checkpoint_usable(fr) || fr->num % fr->p.checkpoints) return;
+
+	if(cps == NULL)
+	{
+		cps = malloc(sizeof(struct checkpoints));
+		if(cps == NULL) return;
+		cps->list = NULL;
+		cps->fill = cps->size = 0;
+		cps->stride = 1;
+		fr->checkpoints = cps;
+	}
+	if((fr->num/fr->p.checkpoints) % cps->stride) return;
+	pos = checkpoint_bound(cps, fr->num);
+	if(pos && cps->list[pos-1]->frame == fr->num) return;
+	if(cps->fill >= CP_MAX)
+	{
+		checkpoint_thin(cps, fr->p.checkpoints);
+		if((fr->num/fr->p.checkpoints) % cps->stride) return;
+		pos = checkpoint_bound(cps, fr->num);
+	}
+	if(cps->fill == cps->size)
+	{
+		size_t newsize = cps->size ? 2*cps->size : 64;
+		struct checkpoint **newlist = safe_realloc(cps->list, newsize*sizeof(struct checkpoint*));
+		if(newlist == NULL) return;
+		cps->list = newlist;
+		cps->size = newsize;
+	}
+
+	reservoir = (fr->lay == 3 && fr->bsbufold != NULL) ? CP_RESERVOIR : 0;
+	hybrid = (fr->lay == 3 && fr->hybrid_block != NULL) ? sizeof(real)*SBLIMIT*SSLIMIT : 0;
+	cp = malloc(sizeof(struct checkpoint) + reservoir + 2*hybrid + fr->rawbuffss);
+	if(cp == NULL) return;
+	cp->frame = fr->num;
+	cp->type = fr->cpu_opts.type;
+	cp->rawbuffs = fr->rawbuffs;
+	cp->buffs = fr->rawbuffss;
+	cp->reservoir = reservoir;
+	cp->hybrid = hybrid;
+	cp->fsizeold = fr->fsizeold;
+	cp->bitreservoir = fr->bitreservoir;
+	cp->bo = fr->bo;
+#ifdef OPT_I486
+	cp->i486bo[0] = fr->i486bo[0];
+	cp->i486bo[1] = fr->i486bo[1];
+#endif
+#ifdef OPT_DITHER
+	cp->ditherindex = fr->ditherindex;
+#endif
+	data = (unsigned char*)(cp+1);
+	if(reservoir)
+	{
+		memcpy(data, fr->bsbufold+fr->fsizeold-CP_RESERVOIR, CP_RESERVOIR);
+		data += CP_RESERVOIR;
+	}
+	for(ch=0; ch<2; ++ch)
+	{
+		cp->hybrid_blc[ch] = fr->hybrid_blc[ch];
+		if(!hybrid) continue;
+		memcpy(data, fr->hybrid_block[fr->hybrid_blc[ch]][ch], hybrid);
+		data += hybrid;
+	}
+	memcpy(data, fr->rawbuffs, cp->buffs);
+
+	memmove(cps->list+pos+1, cps->list+pos, (cps->fill-pos)*sizeof(struct checkpoint*));
+	cps->list[pos] = cp;
+	++cps->fill;
+	debug2("checkpoint %"OFF_P" (%"SIZE_P" in total)", (off_p)cp->frame, (size_p)cps->fill);
+}
+
+off_t checkpoint_find(mpg123_handle *fr, off_t frame)
+{
+	struct checkpoints *cps = fr->checkpoints;
+	struct checkpoint *cp;
+	size_t pos;
+
+	if(cps == NULL || !checkpoint_usable(fr)) return -1;
+	pos = checkpoint_bound(cps, frame);
+	if(!pos) return -1;
+	cp = cps->list[pos-1];
+	/* Decoding from much further back than the interval says is not what the user wants. */
+	if(frame - cp->frame >= fr->p.checkpoints || !checkpoint_fits(fr, cp)) return -1;
+	return cp->frame;
+}
+
+void checkpoint_restore(mpg123_handle *fr, off_t frame)
+{
+	struct checkpoints *cps = fr->checkpoints;
+	struct checkpoint *cp;
+	unsigned char *data;
+	size_t pos;
+	int ch;
+
+	fr->checkpoint_next = -1;
+	if(frame < 0 || fr->num != frame || cps == NULL) return;
+	pos = checkpoint_bound(cps, frame);
+	if(!pos || cps->list[pos-1]->frame != frame) return;
+	cp = cps->list[pos-1];
+	if( !checkpoint_fits(fr, cp)
+	||  (cp->reservoir && (fr->lay != 3 || fr->bsspace == NULL))
+	||  (cp->hybrid && fr->hybrid_block == NULL) )
+	return;
+
+	data = (unsigned char*)(cp+1);
+	if(cp->reservoir)
+	{
+		/* read_frame() just put the frame into the one buffer, the other one holds the past. */
+		fr->bsbufold = fr->bsspace[fr->bsnum]+512;
+		fr->fsizeold = cp->fsizeold;
+		memcpy(fr->bsbufold+fr->fsizeold-CP_RESERVOIR, data, CP_RESERVOIR);
+		data += CP_RESERVOIR;
+	}
+	fr->bitreservoir = cp->bitreservoir;
+	for(ch=0; ch<2; ++ch)
+	{
+		fr->hybrid_blc[ch] = cp->hybrid_blc[ch];
+		if(!cp->hybrid) continue;
+		memcpy(fr->hybrid_block[fr->hybrid_blc[ch]][ch], data, cp->hybrid);
+		data += cp->hybrid;
+	}
+	memcpy(fr->rawbuffs, data, cp->buffs);
+	fr->bo = cp->bo;
+#ifdef OPT_I486
+	fr->i486bo[0] = cp->i486bo[0];
+	fr->i486bo[1] = cp->i486bo[1];
+#endif
+#ifdef OPT_DITHER
+	fr->ditherindex = cp->ditherindex;
+#endif
+	fr->checkpoint_next = frame;
+	debug1("restored checkpoint %"OFF_P, (off_p)frame);
+}
+
+/* The synth buffers without the alignment slack, the same for every instance of a decoder. */
+static unsigned char *synth_state(mpg123_handle *fr, size_t *bytes)
+{
+	*bytes = fr->rawbuffss - 15;
+#ifdef OPT_I486
+	if(fr->cpu_opts.type == ivier) return fr->rawbuffs;
+#endif
+#ifdef OPT_ALTIVEC
+	if(fr->cpu_opts.type == altivec) return fr->rawbuffs;
+#endif
+	return (unsigned char*)fr->real_buffs[0][0];
+}
+
+static size_t hybrid_state(mpg123_handle *fr)
+{
+	return (fr->lay == 3 && fr->hybrid_block != NULL) ? sizeof(real)*SBLIMIT*SSLIMIT : 0;
+}
+
+/* Both bitstream buffers as they are: broken frames make the decoders read past their end. */
+#define CP_BSSPACE (2*(MAXFRAMESIZE+512))
+
+size_t checkpoint_state_size(mpg123_handle *fr)
+{
+	size_t bytes;
+	if(fr->rawbuffs == NULL || fr->bsspace == NULL) return 0;
+#ifdef SINC_RESAMPLE
+	if(fr->resampler != NULL && fr->down_sample == 3) return 0;
+#endif
+	synth_state(fr, &bytes);
+	return CP_BSSPACE + 2*hybrid_state(fr) + bytes;
+}
+
+void checkpoint_state_get(mpg123_handle *fr, unsigned char *data)
+{
+	size_t hybrid = hybrid_state(fr);
+	size_t bytes;
+	unsigned char *synth = synth_state(fr, &bytes);
+	int ch;
+
+	memcpy(data, fr->bsspace, CP_BSSPACE);
+	data += CP_BSSPACE;
+	for(ch=0; ch<2; ++ch)
+	{
+		if(!hybrid) continue;
+		memcpy(data, fr->hybrid_block[fr->hybrid_blc[ch]][ch], hybrid);
+		data += hybrid;
+	}
+	memcpy(data, synth, bytes);
+}
+
+int checkpoint_state_set(mpg123_handle *fr, const unsigned char *data)
+{
+	size_t hybrid = hybrid_state(fr);
+	size_t bytes;
+	unsigned char *synth = synth_state(fr, &bytes);
+	int ch;
+
+	if(frame_bitstream_buffers(fr) < 0) return -1;
+	memcpy(fr->bsspace, data, CP_BSSPACE);
+	data += CP_BSSPACE;
+	/* The last frame is in the buffer that read_frame() did not pick next. */
+	fr->bsbuf = fr->bsbufold = fr->bsspace[(fr->bsnum+1)&1]+512;
+	fr->bsbuf_lent = 0;
+	for(ch=0; ch<2; ++ch)
+	{
+		if(!hybrid) continue;
+		memcpy(fr->hybrid_block[fr->hybrid_blc[ch]][ch], data, hybrid);
+		data += hybrid;
+	}
+	memcpy(synth, data, bytes);
+	return 0;
+}
+
+void checkpoint_reset(mpg123_handle *fr)
+{
+	struct checkpoints *cps = fr->checkpoints;
+	fr->checkpoint_next = 0;
+	if(cps == NULL) return;
+	while(cps->fill) free(cps->list[--cps->fill]);
+	cps->stride = 1;
+}
+
+void checkpoint_exit(mpg123_handle *fr)
+{
+	checkpoint_reset(fr);
+	if(fr->checkpoints == NULL) return;
+	if(fr->checkpoints->list != NULL) free(fr->checkpoints->list);
+	free(fr->checkpoints);
+	fr->checkpoints = NULL;
+}
@@ -0,0 +1,46 @@
+/*
+	checkpoint: decoder state snapshots for exact seeking
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	With MPG123_CHECKPOINTS set to n > 0, the decoder state before every n-th frame is
+	stored while a track is decoded without seeking in between: the Layer III bit reservoir,
+	the overlap-add halves of the hybrid filter bank and the synth buffers, about 9.5K for
+	stereo Layer III. A seek then restores the snapshot at or before the wanted frame and
+	decodes from there, instead of decoding MPG123_PREFRAMES frames from an empty state.
+	The output after the seek is exactly the same as when decoding straight from the start.
+	At most CP_MAX snapshots are kept; on longer tracks only every second (fourth, ...)
+	n-th frame keeps one, so fewer seek targets are close enough to a snapshot.
+*/
+
+#ifndef MPG123_CHECKPOINT_H
+#define MPG123_CHECKPOINT_H
+
+#include "frame.h"
+
+struct checkpoints;
+
+/* Call before decoding the current frame: take a snapshot if one is due. */
+void checkpoint_save(mpg123_handle *fr);
+/* Frame of the best snapshot to seek to for the given frame, -1 if there is none. */
+off_t checkpoint_find(mpg123_handle *fr, off_t frame);
+/* After seeking to the frame from checkpoint_find(), bring back its decoder state.
+   Without that, the decoder state is not exact anymore until the next open. */
+void checkpoint_restore(mpg123_handle *fr, off_t frame);
+/* Drop all snapshots, for a new track. */
+void checkpoint_reset(mpg123_handle *fr);
+/* Free everything. */
+void checkpoint_exit(mpg123_handle *fr);
+
+/* For mpg123_export_state(): the decoder state after decoding the current frame, with all
+   of the bitstream buffers instead of just the reservoir, in the layout of this build and
+   decoder. The scalar parts (bsnum, hybrid_blc, bo, ...) are up to the caller, fr->bsnum
+   has to be set before checkpoint_state_set(). Size 0 means there is no such state to get
+   (decoder not set up, sinc resampler). */
+size_t checkpoint_state_size(mpg123_handle *fr);
+void checkpoint_state_get(mpg123_handle *fr, unsigned char *data);
+/* Put that back once decode_update() set up the decoder for the stored header. Returns 0 on success. */
+int checkpoint_state_set(mpg123_handle *fr, const unsigned char *data);
+
+#endif
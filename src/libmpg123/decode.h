@@ -40,7 +40,9 @@ void ntom_set_ntom(mpg123_handle *fr, off_t num);
 #ifndef NO_16BIT
 /* The signed-16bit-producing variants. */
 int synth_1to1            (real*, int, mpg123_handle*, int);
+int synth_1to1_stereo     (real*, real*, mpg123_handle*);
 int synth_1to1_dither     (real*, int, mpg123_handle*, int);
+int synth_1to1_dither_stereo(real*, real*, mpg123_handle*);
 int synth_1to1_i386       (real*, int, mpg123_handle*, int);
 int synth_1to1_i586       (real*, int, mpg123_handle*, int);
 int synth_1to1_i586_dither(real*, int, mpg123_handle*, int);
@@ -53,6 +55,8 @@ int synth_1to1_altivec    (real*, int, mpg123_handle*, int);
 int synth_1to1_stereo_altivec(real*, real*, mpg123_handle*);
 int synth_1to1_x86_64     (real*, int, mpg123_handle*, int);
 int synth_1to1_stereo_x86_64(real*, real*, mpg123_handle*);
+int synth_1to1_x86_64_dither(real*, int, mpg123_handle*, int);
+int synth_1to1_stereo_x86_64_dither(real*, real*, mpg123_handle*);
 int synth_1to1_avx        (real*, int, mpg123_handle*, int);
 int synth_1to1_stereo_avx (real*, real*, mpg123_handle*);
 int synth_1to1_arm        (real*, int, mpg123_handle*, int);
@@ -71,12 +75,16 @@ int synth_1to1_m2s(real*, mpg123_handle*);
 /* Sample rate decimation comes in less flavours. */
 #ifndef NO_DOWNSAMPLE
 int synth_2to1            (real*, int, mpg123_handle*, int);
+int synth_2to1_stereo     (real*, real*, mpg123_handle*);
 int synth_2to1_dither     (real*, int, mpg123_handle*, int);
+int synth_2to1_dither_stereo(real*, real*, mpg123_handle*);
 int synth_2to1_i386       (real*, int, mpg123_handle*, int);
 int synth_2to1_mono       (real*, mpg123_handle*);
 int synth_2to1_m2s(real*, mpg123_handle*);
 int synth_4to1            (real *,int, mpg123_handle*, int);
+int synth_4to1_stereo     (real*, real*, mpg123_handle*);
 int synth_4to1_dither     (real *,int, mpg123_handle*, int);
+int synth_4to1_dither_stereo(real*, real*, mpg123_handle*);
 int synth_4to1_i386       (real*, int, mpg123_handle*, int);
 int synth_4to1_mono       (real*, mpg123_handle*);
 int synth_4to1_m2s(real*, mpg123_handle*);
@@ -84,6 +92,7 @@ int synth_4to1_m2s(real*, mpg123_handle*);
 #ifndef NO_NTOM
 /* NtoM is really just one implementation. */
 int synth_ntom (real *,int, mpg123_handle*, int);
+int synth_ntom_stereo (real *, real *, mpg123_handle*);
 int synth_ntom_mono (real *, mpg123_handle *);
 int synth_ntom_m2s (real *, mpg123_handle *);
 #endif
@@ -93,9 +102,11 @@ int synth_ntom_m2s (real *, mpg123_handle *);
 /* The 8bit-producing variants. */
 /* There are direct 8-bit synths and wrappers over a possibly optimized 16bit one. */
 int synth_1to1_8bit            (real*, int, mpg123_handle*, int);
+int synth_1to1_8bit_stereo     (real*, real*, mpg123_handle*);
 int synth_1to1_8bit_i386       (real*, int, mpg123_handle*, int);
 #ifndef NO_16BIT
 int synth_1to1_8bit_wrap       (real*, int, mpg123_handle*, int);
+int synth_1to1_8bit_wrap_stereo(real*, real*, mpg123_handle*);
 int synth_1to1_8bit_mono       (real*, mpg123_handle*);
 #endif
 int synth_1to1_8bit_m2s(real*, mpg123_handle*);
@@ -105,16 +116,19 @@ int synth_1to1_8bit_wrap_m2s(real*, mpg123_handle*);
 #endif
 #ifndef NO_DOWNSAMPLE
 int synth_2to1_8bit            (real*, int, mpg123_handle*, int);
+int synth_2to1_8bit_stereo     (real*, real*, mpg123_handle*);
 int synth_2to1_8bit_i386       (real*, int, mpg123_handle*, int);
 int synth_2to1_8bit_mono       (real*, mpg123_handle*);
 int synth_2to1_8bit_m2s(real*, mpg123_handle*);
 int synth_4to1_8bit            (real*, int, mpg123_handle*, int);
+int synth_4to1_8bit_stereo     (real*, real*, mpg123_handle*);
 int synth_4to1_8bit_i386       (real*, int, mpg123_handle*, int);
 int synth_4to1_8bit_mono       (real*, mpg123_handle*);
 int synth_4to1_8bit_m2s(real*, mpg123_handle*);
 #endif
 #ifndef NO_NTOM
 int synth_ntom_8bit            (real*, int, mpg123_handle*, int);
+int synth_ntom_8bit_stereo     (real*, real*, mpg123_handle*);
 int synth_ntom_8bit_mono       (real*, mpg123_handle*);
 int synth_ntom_8bit_m2s(real*, mpg123_handle*);
 #endif
@@ -125,6 +139,7 @@ int synth_ntom_8bit_m2s(real*, mpg123_handle*);
 #ifndef NO_REAL
 /* The real-producing variants. */
 int synth_1to1_real            (real*, int, mpg123_handle*, int);
+int synth_1to1_real_stereo     (real*, real*, mpg123_handle*);
 int synth_1to1_real_i386       (real*, int, mpg123_handle*, int);
 int synth_1to1_real_sse        (real*, int, mpg123_handle*, int);
 int synth_1to1_real_stereo_sse (real*, real*, mpg123_handle*);
@@ -142,16 +157,19 @@ int synth_1to1_real_mono       (real*, mpg123_handle*);
 int synth_1to1_real_m2s(real*, mpg123_handle*);
 #ifndef NO_DOWNSAMPLE
 int synth_2to1_real            (real*, int, mpg123_handle*, int);
+int synth_2to1_real_stereo     (real*, real*, mpg123_handle*);
 int synth_2to1_real_i386       (real*, int, mpg123_handle*, int);
 int synth_2to1_real_mono       (real*, mpg123_handle*);
 int synth_2to1_real_m2s(real*, mpg123_handle*);
 int synth_4to1_real            (real*, int, mpg123_handle*, int);
+int synth_4to1_real_stereo     (real*, real*, mpg123_handle*);
 int synth_4to1_real_i386       (real*, int, mpg123_handle*, int);
 int synth_4to1_real_mono       (real*, mpg123_handle*);
 int synth_4to1_real_m2s(real*, mpg123_handle*);
 #endif
 #ifndef NO_NTOM
 int synth_ntom_real            (real*, int, mpg123_handle*, int);
+int synth_ntom_real_stereo     (real*, real*, mpg123_handle*);
 int synth_ntom_real_mono       (real*, mpg123_handle*);
 int synth_ntom_real_m2s(real*, mpg123_handle*);
 #endif
@@ -160,6 +178,7 @@ int synth_ntom_real_m2s(real*, mpg123_handle*);
 #ifndef NO_32BIT
 /* 32bit integer */
 int synth_1to1_s32            (real*, int, mpg123_handle*, int);
+int synth_1to1_s32_stereo     (real*, real*, mpg123_handle*);
 int synth_1to1_s32_i386       (real*, int, mpg123_handle*, int);
 int synth_1to1_s32_sse        (real*, int, mpg123_handle*, int);
 int synth_1to1_s32_stereo_sse (real*, real*, mpg123_handle*);
@@ -177,19 +196,46 @@ int synth_1to1_s32_mono       (real*, mpg123_handle*);
 int synth_1to1_s32_m2s(real*, mpg123_handle*);
 #ifndef NO_DOWNSAMPLE
 int synth_2to1_s32            (real*, int, mpg123_handle*, int);
+int synth_2to1_s32_stereo     (real*, real*, mpg123_handle*);
 int synth_2to1_s32_i386       (real*, int, mpg123_handle*, int);
 int synth_2to1_s32_mono       (real*, mpg123_handle*);
 int synth_2to1_s32_m2s(real*, mpg123_handle*);
 int synth_4to1_s32            (real*, int, mpg123_handle*, int);
+int synth_4to1_s32_stereo     (real*, real*, mpg123_handle*);
 int synth_4to1_s32_i386       (real*, int, mpg123_handle*, int);
 int synth_4to1_s32_mono       (real*, mpg123_handle*);
 int synth_4to1_s32_m2s(real*, mpg123_handle*);
 #endif
 #ifndef NO_NTOM
 int synth_ntom_s32            (real*, int, mpg123_handle*, int);
+int synth_ntom_s32_stereo     (real*, real*, mpg123_handle*);
 int synth_ntom_s32_mono       (real*, mpg123_handle*);
 int synth_ntom_s32_m2s(real*, mpg123_handle*);
 #endif
+/* packed 24bit integer */
+int synth_1to1_s24            (real*, int, mpg123_handle*, int);
+int synth_1to1_s24_stereo     (real*, real*, mpg123_handle*);
+int synth_1to1_s24_i386       (real*, int, mpg123_handle*, int);
+int synth_1to1_s24_mono       (real*, mpg123_handle*);
+int synth_1to1_s24_m2s(real*, mpg123_handle*);
+#ifndef NO_DOWNSAMPLE
+int synth_2to1_s24            (real*, int, mpg123_handle*, int);
+int synth_2to1_s24_stereo     (real*, real*, mpg123_handle*);
+int synth_2to1_s24_i386       (real*, int, mpg123_handle*, int);
+int synth_2to1_s24_mono       (real*, mpg123_handle*);
+int synth_2to1_s24_m2s(real*, mpg123_handle*);
+int synth_4to1_s24            (real*, int, mpg123_handle*, int);
+int synth_4to1_s24_stereo     (real*, real*, mpg123_handle*);
+int synth_4to1_s24_i386       (real*, int, mpg123_handle*, int);
+int synth_4to1_s24_mono       (real*, mpg123_handle*);
+int synth_4to1_s24_m2s(real*, mpg123_handle*);
+#endif
+#ifndef NO_NTOM
+int synth_ntom_s24            (real*, int, mpg123_handle*, int);
+int synth_ntom_s24_stereo     (real*, real*, mpg123_handle*);
+int synth_ntom_s24_mono       (real*, mpg123_handle*);
+int synth_ntom_s24_m2s(real*, mpg123_handle*);
+#endif
 #endif
 
 #endif /* FIXED */
@@ -213,6 +259,35 @@ void dct36_avx     (real *,real *,real *,real *,real *);
 void dct36_neon    (real *,real *,real *,real *,real *);
 void dct36_neon64  (real *,real *,real *,real *,real *);
 
+/* Layer 3 alias reduction, generic and AVX. */
+void antialias    (real *, int);
+void antialias_avx(real *, int);
+
+/* Stereo output in one plane per channel, wrapping the synth chosen for the format; defined in planar.c . */
+int synth_planar_stereo(real*, real*, mpg123_handle*);
+int synth_planar_m2s   (real*, mpg123_handle*);
+
+#ifdef SINC_RESAMPLE
+/* Windowed-sinc resampling on top of the 1to1 float synth, defined in resample.c . */
+int  resample_init(mpg123_handle *fr, int format); /* (re)build filter for current rates, clear history */
+void resample_exit(mpg123_handle *fr);
+int  resample_delay(mpg123_handle *fr); /* input samples the output lags behind, 0 if not active */
+int synth_sinc       (real*, int, mpg123_handle*, int);
+int synth_sinc_stereo(real*, real*, mpg123_handle*);
+int synth_sinc_mono  (real*, mpg123_handle*);
+int synth_sinc_m2s   (real*, mpg123_handle*);
+/* sums[0] = x*c, sums[1] = x*(c+taps), for taps being a multiple of 8 */
+void resample_dot       (const real *x, const real *c, int taps, real *sums);
+void resample_dot_x86_64(const real *x, const real *c, int taps, real *sums);
+void resample_dot_avx   (const real *x, const real *c, int taps, real *sums);
+#endif
+
+#ifndef NO_32BIT
+/* In-place 32 to 24 bit conversion after xor with flip, defined in format.c . */
+void conv_s32_to_24    (unsigned char *data, size_t count, uint32_t flip);
+void conv_s32_to_24_avx(unsigned char *data, size_t count, uint32_t flip);
+#endif
+
 /* Tools for NtoM resampling synth, defined in ntom.c . */
 int synth_ntom_set_step(mpg123_handle *fr); /* prepare ntom decoding */
 unsigned long ntom_val(mpg123_handle *fr, off_t frame); /* compute ntom_val for frame offset */
@@ -233,13 +308,12 @@ off_t ntom_frameoff(mpg123_handle *fr, off_t soff);
    Make sure you call these once before it is too late. */
 #ifndef NO_LAYER3
 void init_layer3(void);
-real init_layer3_gainpow2(mpg123_handle *fr, int i);
-void init_layer3_stuff(mpg123_handle *fr, real (*gainpow2)(mpg123_handle *fr, int i));
+/* Point the handle to the shared tables for its decoder and resampling setup. */
+void init_layer3_stuff(mpg123_handle *fr, int mmx);
 #endif
 #ifndef NO_LAYER12
 void  init_layer12(void);
-real* init_layer12_table(mpg123_handle *fr, real *table, int m);
-void  init_layer12_stuff(mpg123_handle *fr, real* (*init_table)(mpg123_handle *fr, real *table, int m));
+void  init_layer12_stuff(mpg123_handle *fr, int mmx);
 #endif
 
 void prepare_decode_tables(void);
@@ -253,12 +327,6 @@ void make_decode_tables(mpg123_handle *fr); /* For every volume change. */
 #ifdef OPT_MMXORSSE
 /* Special treatment for mmx-like decoders, these functions go into the slots below. */
 void make_decode_tables_mmx(mpg123_handle *fr);
-#ifndef NO_LAYER3
-real init_layer3_gainpow2_mmx(mpg123_handle *fr, int i);
-#endif
-#ifndef NO_LAYER12
-real* init_layer12_table_mmx(mpg123_handle *fr, real *table, int m);
-#endif
 #endif
 
 #ifndef NO_8BIT
@@ -279,7 +347,9 @@ int do_layer2(mpg123_handle *fr);
 #ifndef NO_LAYER1
 int do_layer1(mpg123_handle *fr);
 #endif
-/* There's an 3DNow counterpart in asm. */
-void do_equalizer(real *bandPtr,int channel, real equalizer[2][32]);
+/* Multiply blocks of SBLIMIT subband samples with the gains of one channel, in place. */
+void do_equalizer       (real *bands, int blocks, real *equalizer);
+void do_equalizer_x86_64(real *bands, int blocks, real *equalizer);
+void do_equalizer_avx   (real *bands, int blocks, real *equalizer);
 
 #endif
@@ -1,3 +1,44 @@
 /* Hack to allow building the same code with and without libtool. */
 #include "intsym.h"
 #include "dither_impl.h"
+
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+/*
+	One table of noise for everyone. It only depends on the constant seed, so
+	there is no point in every handle computing and storing its own 256K copy.
+	It is generated when the first dithered decoder is chosen; the pages of the
+	static array are not touched before.
+*/
+static float dithernoise[DITHERSIZE];
+
+static void dither_table_fill(void)
+{
+	highpass_tpdf_noise(dithernoise, DITHERSIZE);
+}
+
+#ifndef NO_THREADS
+static pthread_once_t dither_once = PTHREAD_ONCE_INIT;
+
+const float* dither_table(void)
+{
+	pthread_once(&dither_once, dither_table_fill);
+	return dithernoise;
+}
+#else
+/* Without pthread_once(), choosing the first dithered decoders in several
+   threads at once needs the same care as calling mpg123_init(). */
+static int dither_done = 0;
+
+const float* dither_table(void)
+{
+	if(!dither_done)
+	{
+		dither_table_fill();
+		dither_done = 1;
+	}
+	return dithernoise;
+}
+#endif
@@ -18,6 +18,8 @@ enum mpg123_noise_type
 };
 
 void mpg123_noise(float* table, size_t count, enum mpg123_noise_type noisetype);
-void dither_table_init(float *dithertable);
+/* The shaped noise of DITHERSIZE values for the dithered synths, computed on
+   first use and shared read-only by all handles. */
+const float* dither_table(void);
 
 #endif
@@ -111,9 +111,3 @@ void mpg123_noise(float* table, size_t count, enum mpg123_noise_type noisetype)
 		break;
 	}
 }
-
-/* Generate white noise and shape it with a high pass filter. */
-void dither_table_init(float *dithertable)
-{
-	highpass_tpdf_noise(dithertable, DITHERSIZE);
-}
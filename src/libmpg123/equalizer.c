@@ -4,14 +4,18 @@
 	copyright ?-2006 by the mpg123 project - free software under the terms of the LGPL 2.1
 	see COPYING and AUTHORS files in distribution or http://mpg123.org
 	initially written by Michael Hipp
+
+	The layer decoders apply this to all subband samples of a frame (or granule) and
+	channel in one go, before synthesis. There are SSE and AVX versions for x86-64.
 */
 
 
 #include "mpg123lib_intern.h"
 
-void do_equalizer(real *bandPtr,int channel, real equalizer[2][32]) 
+void do_equalizer(real *bands, int blocks, real *equalizer)
 {
 	int i;
-	for(i=0;i<32;i++)
-	bandPtr[i] = REAL_MUL(bandPtr[i], equalizer[channel][i]);
+	for(; blocks > 0; --blocks, bands += SBLIMIT)
+	for(i=0;i<SBLIMIT;i++)
+	bands[i] = REAL_MUL(bands[i], equalizer[i]);
 }
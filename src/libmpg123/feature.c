@@ -107,6 +107,20 @@ int mpg123_feature(const enum mpg123_feature_set key)
 		return 0;
 #endif
 
+		case MPG123_FEATURE_THREADS:
+#ifndef NO_THREADS
+		return 1;
+#else
+		return 0;
+#endif
+
+		case MPG123_FEATURE_RESAMPLE_SINC:
+#ifdef SINC_RESAMPLE
+		return 1;
+#else
+		return 0;
+#endif
+
 		default: return 0;
 	}
 }
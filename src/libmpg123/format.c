@@ -210,6 +210,44 @@ static int freq_fit(mpg123_handle *fr, struct audioformat *nf, int f0, int f2)
 	return 0;
 }
 
+/* Set up the decoder synth format for the output encoding. Might differ. */
+static void decoder_encoding(mpg123_handle *fr)
+{
+#ifdef NO_SYNTH32
+	/* Without high-precision synths, 16 bit signed is the basis for
+	   everything higher than 8 bit. */
+	if(fr->af.encsize > 2)
+	fr->af.dec_enc = MPG123_ENC_SIGNED_16;
+	else
+	{
+#endif
+		switch(fr->af.encoding)
+		{
+#ifndef NO_32BIT
+		case MPG123_ENC_SIGNED_24:
+		case MPG123_ENC_UNSIGNED_24:
+			/* Straight from the synth if the decoder offers that. */
+			fr->af.dec_enc = fr->synths.plain[r_1to1][f_24] != NULL
+			?	fr->af.encoding : MPG123_ENC_SIGNED_32;
+		break;
+		case MPG123_ENC_UNSIGNED_32:
+			fr->af.dec_enc = MPG123_ENC_SIGNED_32;
+		break;
+#endif
+#ifndef NO_16BIT
+		case MPG123_ENC_UNSIGNED_16:
+			fr->af.dec_enc = MPG123_ENC_SIGNED_16;
+		break;
+#endif
+		default:
+			fr->af.dec_enc = fr->af.encoding;
+		}
+#ifdef NO_SYNTH32
+	}
+#endif
+	fr->af.dec_encsize = mpg123_encsize(fr->af.dec_enc);
+}
+
 /* match constraints against supported audio formats, store possible setup in frame
   return: -1: error; 0: no format change; 1: format change */
 int frame_output_format(mpg123_handle *fr)
@@ -293,6 +331,8 @@ end: /* Here is the _good_ end. */
 	if(nf.rate == fr->af.rate && nf.channels == fr->af.channels && nf.encoding == fr->af.encoding)
 	{
 		debug2("Old format with %i channels, and FORCE_MONO=%li", nf.channels, p->flags & MPG123_FORCE_MONO);
+		/* The decoder might have changed, though. */
+		decoder_encoding(fr);
 		return 0; /* the same format as before */
 	}
 	else /* a new format */
@@ -310,36 +350,7 @@ end: /* Here is the _good_ end. */
 			fr->err = MPG123_BAD_OUTFORMAT;
 			return -1;
 		}
-		/* Set up the decoder synth format. Might differ. */
-#ifdef NO_SYNTH32
-		/* Without high-precision synths, 16 bit signed is the basis for
-		   everything higher than 8 bit. */
-		if(fr->af.encsize > 2)
-		fr->af.dec_enc = MPG123_ENC_SIGNED_16;
-		else
-		{
-#endif
-			switch(fr->af.encoding)
-			{
-#ifndef NO_32BIT
-			case MPG123_ENC_SIGNED_24:
-			case MPG123_ENC_UNSIGNED_24:
-			case MPG123_ENC_UNSIGNED_32:
-				fr->af.dec_enc = MPG123_ENC_SIGNED_32;
-			break;
-#endif
-#ifndef NO_16BIT
-			case MPG123_ENC_UNSIGNED_16:
-				fr->af.dec_enc = MPG123_ENC_SIGNED_16;
-			break;
-#endif
-			default:
-				fr->af.dec_enc = fr->af.encoding;
-			}
-#ifdef NO_SYNTH32
-		}
-#endif
-		fr->af.dec_encsize = mpg123_encsize(fr->af.dec_enc);
+		decoder_encoding(fr);
 		return 1;
 	}
 }
@@ -483,61 +494,53 @@ off_t outblock_bytes(mpg123_handle *fr, off_t s)
 	return s * encsize * fr->af.channels;
 }
 
+/*
+	Each conversion is a single pass over the buffer, also for the ones that
+	used to be chains like s16 -> s32 -> u32 -> u24. Unsigned output is just
+	signed output with the sign bit flipped, that is what the flip masks do.
+*/
+
 #ifndef NO_32BIT
-/* Remove every fourth byte, facilitating conversion from 32 bit to 24 bit integers.
-   This has to be aware of endianness, of course. */
-static void chop_fourth_byte(struct outbuffer *buf)
+/* Keep the upper 3 bytes of each 32 bit sample (after flipping the given bits),
+   in place. The output is smaller, so this goes forward. */
+void conv_s32_to_24(unsigned char *data, size_t count, uint32_t flip)
 {
-	unsigned char *wpos = buf->data;
-	unsigned char *rpos = buf->data;
-#ifdef WORDS_BIGENDIAN
-	while((size_t) (rpos - buf->data + 4) <= buf->fill)
+	size_t i;
+	uint32_t *in = (uint32_t*)data;
+
+	for(i=0; i<count; ++i)
 	{
-		/* Really stupid: Copy, increment. Byte per byte. */
-		*wpos = *rpos;
-		wpos++; rpos++;
-		*wpos = *rpos;
-		wpos++; rpos++;
-		*wpos = *rpos;
-		wpos++; rpos++;
-		rpos++; /* Skip the lowest byte (last). */
-	}
+		uint32_t v = in[i] ^ flip;
+		unsigned char *out = data + 3*i;
+#ifdef WORDS_BIGENDIAN
+		out[0] = (unsigned char)(v>>24);
+		out[1] = (unsigned char)(v>>16);
+		out[2] = (unsigned char)(v>>8);
 #else
-	while((size_t) (rpos - buf->data + 4) <= buf->fill)
-	{
-		/* Really stupid: Copy, increment. Byte per byte. */
-		rpos++; /* Skip the lowest byte (first). */
-		*wpos = *rpos;
-		wpos++; rpos++;
-		*wpos = *rpos;
-		wpos++; rpos++;
-		*wpos = *rpos;
-		wpos++; rpos++;
-	}
+		out[0] = (unsigned char)(v>>8);
+		out[1] = (unsigned char)(v>>16);
+		out[2] = (unsigned char)(v>>24);
 #endif
-	buf->fill = wpos-buf->data;
+	}
 }
 
 static void conv_s32_to_u32(struct outbuffer *buf)
 {
 	size_t i;
-	int32_t  *ssamples = (int32_t*)  buf->data;
-	uint32_t *usamples = (uint32_t*) buf->data;
+	uint32_t *samples = (uint32_t*) buf->data;
 	size_t count = buf->fill/sizeof(int32_t);
 
+	/* The same as adding 2^31 in modular arithmetic. */
 	for(i=0; i<count; ++i)
-	{
-		/* Different strategy since we don't have a larger type at hand.
-			 Also watch out for silly +-1 fun because integer constants are signed in C90! */
-		if(ssamples[i] >= 0)
-		usamples[i] = (uint32_t)ssamples[i] + 2147483647+1;
-		/* The smallest value goes zero. */
-		else if(ssamples[i] == ((int32_t)-2147483647-1))
-		usamples[i] = 0;
-		/* Now -value is in the positive range of signed int ... so it's a possible value at all. */
-		else
-		usamples[i] = (uint32_t)2147483647+1 - (uint32_t)(-ssamples[i]);
-	}
+	samples[i] ^= 0x80000000UL;
+}
+
+static void conv_s32_to_x24(mpg123_handle *fr, uint32_t flip)
+{
+	size_t count = fr->buffer.fill/sizeof(int32_t);
+
+	opt_conv_s32_to_24(fr)(fr->buffer.data, count, flip);
+	fr->buffer.fill = count*3;
 }
 
 #endif
@@ -554,15 +557,11 @@ static const char *bufsizeerr = "Fatal: Buffer too small for postprocessing!";
 static void conv_s16_to_u16(struct outbuffer *buf)
 {
 	size_t i;
-	int16_t  *ssamples = (int16_t*) buf->data;
-	uint16_t *usamples = (uint16_t*)buf->data;
+	uint16_t *samples = (uint16_t*)buf->data;
 	size_t count = buf->fill/sizeof(int16_t);
 
 	for(i=0; i<count; ++i)
-	{
-		long tmp = (long)ssamples[i]+32768;
-		usamples[i] = (uint16_t)tmp;
-	}
+	samples[i] ^= 0x8000;
 }
 
 #ifndef NO_REAL
@@ -592,11 +591,12 @@ static void conv_s16_to_f32(struct outbuffer *buf)
 #endif
 
 #ifndef NO_32BIT
-static void conv_s16_to_s32(struct outbuffer *buf)
+/* Signed or unsigned 32 bit, the 16 bits going to the top. */
+static void conv_s16_to_x32(struct outbuffer *buf, uint16_t flip)
 {
 	ssize_t i;
-	int16_t  *in = (int16_t*) buf->data;
-	int32_t *out = (int32_t*) buf->data;
+	uint16_t *in = (uint16_t*) buf->data;
+	uint32_t *out = (uint32_t*) buf->data;
 	size_t count = buf->fill/sizeof(int16_t);
 
 	if(buf->size < count*sizeof(int32_t))
@@ -607,13 +607,41 @@ static void conv_s16_to_s32(struct outbuffer *buf)
 
 	/* Work from the back since output is bigger. */
 	for(i=count-1; i>=0; --i)
+	out[i] = (uint32_t)(in[i] ^ flip) << 16;
+
+	buf->fill = count*sizeof(int32_t);
+}
+
+/* Signed or unsigned 24 bit, the 16 bits going to the top, lowest byte zero. */
+static void conv_s16_to_x24(struct outbuffer *buf, uint16_t flip)
+{
+	ssize_t i;
+	uint16_t *in = (uint16_t*) buf->data;
+	size_t count = buf->fill/sizeof(int16_t);
+
+	if(buf->size < count*3)
 	{
-		out[i] = in[i];
-		/* Could just shift bytes, but would have to mess with sign bit. */
-		out[i] *= S32_RESCALE;
+		error1("%s", bufsizeerr);
+		return;
 	}
 
-	buf->fill = count*sizeof(int32_t);
+	/* Work from the back since output is bigger. */
+	for(i=count-1; i>=0; --i)
+	{
+		uint16_t v = in[i] ^ flip;
+		unsigned char *out = buf->data + 3*i;
+#ifdef WORDS_BIGENDIAN
+		out[0] = (unsigned char)(v>>8);
+		out[1] = (unsigned char)v;
+		out[2] = 0;
+#else
+		out[0] = 0;
+		out[1] = (unsigned char)v;
+		out[2] = (unsigned char)(v>>8);
+#endif
+	}
+
+	buf->fill = count*3;
 }
 #endif
 #endif
@@ -637,11 +665,10 @@ void postprocess_buffer(mpg123_handle *fr)
 			conv_s32_to_u32(&fr->buffer);
 		break;
 		case MPG123_ENC_UNSIGNED_24:
-			conv_s32_to_u32(&fr->buffer);
-			chop_fourth_byte(&fr->buffer);
+			conv_s32_to_x24(fr, 0x80000000UL);
 		break;
 		case MPG123_ENC_SIGNED_24:
-			chop_fourth_byte(&fr->buffer);
+			conv_s32_to_x24(fr, 0);
 		break;
 		}
 	break;
@@ -660,20 +687,16 @@ void postprocess_buffer(mpg123_handle *fr)
 #endif
 #ifndef NO_32BIT
 		case MPG123_ENC_SIGNED_32:
-			conv_s16_to_s32(&fr->buffer);
+			conv_s16_to_x32(&fr->buffer, 0);
 		break;
 		case MPG123_ENC_UNSIGNED_32:
-			conv_s16_to_s32(&fr->buffer);
-			conv_s32_to_u32(&fr->buffer);
+			conv_s16_to_x32(&fr->buffer, 0x8000);
 		break;
 		case MPG123_ENC_UNSIGNED_24:
-			conv_s16_to_s32(&fr->buffer);
-			conv_s32_to_u32(&fr->buffer);
-			chop_fourth_byte(&fr->buffer);
+			conv_s16_to_x24(&fr->buffer, 0x8000);
 		break;
 		case MPG123_ENC_SIGNED_24:
-			conv_s16_to_s32(&fr->buffer);
-			chop_fourth_byte(&fr->buffer);
+			conv_s16_to_x24(&fr->buffer, 0);
 		break;
 #endif
 		}
@@ -8,6 +8,8 @@
 
 #include "mpg123lib_intern.h"
 #include "getcpuflags.h"
+#include "pipeline.h"
+#include "checkpoint.h"
 #include "debug.h"
 
 static void frame_fixed_reset(mpg123_handle *fr);
@@ -64,6 +66,11 @@ static void frame_default_pars(mpg123_pars *mp)
 	mp->feedpool = 5; 
 	mp->feedbuffer = 4096;
 #endif
+#ifdef SINC_RESAMPLE
+	mp->resample = MPG123_RESAMPLE_NTOM;
+#endif
+	mp->checkpoints = 0;
+	mp->readahead = 0;
 }
 
 void frame_init(mpg123_handle *fr)
@@ -78,6 +85,8 @@ void frame_init_par(mpg123_handle *fr, mpg123_pars *mp)
 	fr->buffer.rdata = NULL;
 	fr->buffer.fill = 0;
 	fr->buffer.size = 0;
+	fr->buffer.plane = 0;
+	fr->outhalf = 0;
 	fr->rawbuffs = NULL;
 	fr->rawbuffss = 0;
 	fr->rawdecwin = NULL;
@@ -89,7 +98,21 @@ void frame_init_par(mpg123_handle *fr, mpg123_pars *mp)
 	fr->dithernoise = NULL;
 #endif
 	fr->layerscratch = NULL;
+#ifndef NO_LAYER3
+	fr->layer3.scratch = NULL;
+#endif
+	fr->hybrid_block = NULL;
+	fr->bsspace = NULL;
 	fr->xing_toc = NULL;
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+	fr->pipeline = NULL;
+	fr->pipeline_failed = 0;
+#endif
+#ifdef SINC_RESAMPLE
+	fr->resampler = NULL;
+#endif
+	fr->checkpoints = NULL;
+	fr->checkpoint_next = 0;
 	fr->cpu_opts.type = defdec();
 	fr->cpu_opts.class = decclass(fr->cpu_opts.type);
 #ifndef NO_NTOM
@@ -112,6 +135,9 @@ void frame_init_par(mpg123_handle *fr, mpg123_pars *mp)
 	fr->rdat.r_read_handle = NULL;
 	fr->rdat.r_lseek_handle = NULL;
 	fr->rdat.cleanup_handle = NULL;
+#ifndef NO_THREADS
+	fr->rdat.readahead = NULL;
+#endif
 	fr->wrapperdata = NULL;
 	fr->wrapperclean = NULL;
 	fr->decoder_change = 1;
@@ -130,24 +156,20 @@ void frame_init_par(mpg123_handle *fr, mpg123_pars *mp)
 	fr->make_decode_tables = NULL;
 #ifdef FRAME_INDEX
 	fi_init(&fr->index);
+	ei_init(&fr->exact);
 	frame_index_setup(fr); /* Apply the size setting. */
 #endif
 }
 
 #ifdef OPT_DITHER
-/* Also, only allocate the memory for the table on demand.
+/* The noise table is shared by all handles and only generated on demand.
    In future, one could create special noise for different sampling frequencies(?). */
 int frame_dither_init(mpg123_handle *fr)
 {
-	/* run-time dither noise table generation */
 	if(fr->dithernoise == NULL)
-	{
-		fr->dithernoise = malloc(sizeof(float)*DITHERSIZE);
-		if(fr->dithernoise == NULL) return 0;
+	fr->dithernoise = dither_table();
 
-		dither_table_init(fr->dithernoise);
-	}
-	return 1;
+	return fr->dithernoise != NULL;
 }
 #endif
 
@@ -178,16 +200,6 @@ int attribute_align_arg mpg123_reset_eq(mpg123_handle *mh)
 int frame_outbuffer(mpg123_handle *fr)
 {
 	size_t size = fr->outblock;
-	if(!fr->own_buffer)
-	{
-		if(fr->buffer.size < size)
-		{
-			fr->err = MPG123_BAD_BUFFER;
-			if(NOQUIET) error2("have external buffer of size %"SIZE_P", need %"SIZE_P, (size_p)fr->buffer.size, (size_p)size);
-
-			return MPG123_ERR;
-		}
-	}
 
 	debug1("need frame buffer of %"SIZE_P, (size_p)size);
 	if(fr->buffer.rdata != NULL && fr->buffer.size != size)
@@ -205,6 +217,9 @@ int frame_outbuffer(mpg123_handle *fr)
 		return MPG123_ERR;
 	}
 	fr->buffer.data = aligned_pointer(fr->buffer.rdata, unsigned char*, 16);
+	/* An external buffer is given up here in any case, also if it is too small
+	   for the new format. Failing in the middle of a stream helps nobody, the
+	   next mpg123_replace_buffer() brings in a fitting one. */
 	fr->own_buffer = TRUE;
 	fr->buffer.fill = 0;
 	return MPG123_OK;
@@ -256,7 +271,7 @@ int frame_index_setup(mpg123_handle *fr)
 
 static void frame_decode_buffers_reset(mpg123_handle *fr)
 {
-	memset(fr->rawbuffs, 0, fr->rawbuffss);
+	if(fr->rawbuffs != NULL) memset(fr->rawbuffs, 0, fr->rawbuffss);
 }
 
 int frame_buffers(mpg123_handle *fr)
@@ -392,10 +407,6 @@ int frame_buffers(mpg123_handle *fr)
 #endif
 #ifndef NO_LAYER2
 		scratchsize += sizeof(real) * 2 * 4 * SBLIMIT;
-#endif
-#ifndef NO_LAYER3
-		scratchsize += sizeof(real) * 2 * SBLIMIT * SSLIMIT; /* hybrid_in */
-		scratchsize += sizeof(real) * 2 * SSLIMIT * SBLIMIT; /* hybrid_out */
 #endif
 		/*
 			Now figure out correct alignment:
@@ -416,14 +427,32 @@ int frame_buffers(mpg123_handle *fr)
 		fr->layer2.fraction = (real(*)[4][SBLIMIT])scratcher;
 		scratcher += 2 * 4 * SBLIMIT;
 #endif
+		/* Note: These buffers don't need resetting here. */
+	}
 #ifndef NO_LAYER3
+	/* Same for Layer 3, just bigger and only allocated when really needed in lazy mode. */
+	if(fr->layer3.scratch == NULL && (fr->lay == 3 || !(fr->p.flags & MPG123_LAZY_BUFFERS)))
+	{
+		real *scratcher;
+		size_t scratchsize = 0;
+		scratchsize += sizeof(real) * 2 * SBLIMIT * SSLIMIT; /* hybrid_in */
+		scratchsize += sizeof(real) * 2 * SSLIMIT * SBLIMIT; /* hybrid_out */
+		scratchsize += sizeof(real) * 2 * 2 * SBLIMIT * SSLIMIT; /* hybrid_block */
+
+		fr->layer3.scratch = malloc(scratchsize+63);
+		if(fr->layer3.scratch == NULL) return -1;
+
+		scratcher = aligned_pointer(fr->layer3.scratch,real,64);
 		fr->layer3.hybrid_in = (real(*)[SBLIMIT][SSLIMIT])scratcher;
 		scratcher += 2 * SBLIMIT * SSLIMIT;
 		fr->layer3.hybrid_out = (real(*)[SSLIMIT][SBLIMIT])scratcher;
 		scratcher += 2 * SSLIMIT * SBLIMIT;
-#endif
-		/* Note: These buffers don't need resetting here. */
+		fr->hybrid_block = (real(*)[2][SBLIMIT*SSLIMIT])scratcher;
+		/* The hybrid_block carries state from frame to frame, that needs to start at zero. */
+		fr->hybrid_blc[0] = fr->hybrid_blc[1] = 0;
+		memset(fr->hybrid_block, 0, sizeof(real)*2*2*SBLIMIT*SSLIMIT);
 	}
+#endif
 
 	/* Only reset the buffers we created just now. */
 	frame_decode_buffers_reset(fr);
@@ -437,17 +466,37 @@ int frame_buffers_reset(mpg123_handle *fr)
 	fr->buffer.fill = 0; /* hm, reset buffer fill... did we do a flush? */
 	fr->bsnum = 0;
 	/* Wondering: could it be actually _wanted_ to retain buffer contents over different files? (special gapless / cut stuff) */
-	fr->bsbuf = fr->bsspace[1];
+	fr->bsbuf = fr->bsspace != NULL ? fr->bsspace[1] : NULL;
 	fr->bsbufold = fr->bsbuf;
+	fr->bsbuf_lent = 0;
 	fr->bitreservoir = 0;
 	frame_decode_buffers_reset(fr);
-	memset(fr->bsspace, 0, 2*(MAXFRAMESIZE+512));
+	if(fr->bsspace != NULL) memset(fr->bsspace, 0, 2*(MAXFRAMESIZE+512));
 	memset(fr->ssave, 0, 34);
 	fr->hybrid_blc[0] = fr->hybrid_blc[1] = 0;
+	if(fr->hybrid_block != NULL)
 	memset(fr->hybrid_block, 0, sizeof(real)*2*2*SBLIMIT*SSLIMIT);
 	return 0;
 }
 
+int frame_bitstream_buffers(mpg123_handle *fr)
+{
+	if(fr->bsspace != NULL) return MPG123_OK;
+
+	fr->bsspace = malloc(2*(MAXFRAMESIZE+512));
+	if(fr->bsspace == NULL)
+	{
+		fr->err = MPG123_OUT_OF_MEM;
+		return MPG123_ERR;
+	}
+	memset(fr->bsspace, 0, 2*(MAXFRAMESIZE+512));
+	fr->bsnum = 0;
+	fr->bsbuf = fr->bsspace[1];
+	fr->bsbufold = fr->bsbuf;
+	fr->bsbuf_lent = 0;
+	return MPG123_OK;
+}
+
 static void frame_icy_reset(mpg123_handle* fr)
 {
 #ifndef NO_ICY
@@ -492,7 +541,9 @@ int frame_reset(mpg123_handle* fr)
 	frame_free_toc(fr);
 #ifdef FRAME_INDEX
 	fi_reset(&fr->index);
+	ei_reset(&fr->exact);
 #endif
+	checkpoint_reset(fr);
 
 	return 0;
 }
@@ -574,10 +625,52 @@ static void frame_free_buffers(mpg123_handle *fr)
 	fr->conv16to8_buf = NULL;
 #endif
 	if(fr->layerscratch != NULL) free(fr->layerscratch);
+	fr->layerscratch = NULL;
+#ifndef NO_LAYER3
+	if(fr->layer3.scratch != NULL) free(fr->layer3.scratch);
+	fr->layer3.scratch = NULL;
+#endif
+	fr->hybrid_block = NULL;
+}
+
+/*
+	Give back what a parked handle does not need, it all comes back with the next
+	decode_update() and read_frame(). Not touched: the frame index (has its own size setting)
+	and the dither noise (set up with the decoder choice).
+*/
+void frame_release_buffers(mpg123_handle *fr)
+{
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+	pipeline_exit(fr);
+#endif
+	if(fr->own_buffer && fr->buffer.rdata != NULL)
+	{
+		free(fr->buffer.rdata);
+		fr->buffer.rdata = NULL;
+		fr->buffer.data = NULL;
+		fr->buffer.size = 0;
+	}
+	fr->buffer.fill = 0;
+	frame_free_buffers(fr);
+#ifdef SINC_RESAMPLE
+	resample_exit(fr);
+#endif
+	fr->decwin = NULL;
+	if(fr->bsspace != NULL) free(fr->bsspace);
+	fr->bsspace = NULL;
+	fr->bsbuf = fr->bsbufold = NULL;
+	fr->bsbuf_lent = 0;
+#ifdef FRAME_INDEX
+	ei_exit(&fr->exact);
+#endif
+	checkpoint_exit(fr);
 }
 
 void frame_exit(mpg123_handle *fr)
 {
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+	pipeline_exit(fr);
+#endif
 	if(fr->buffer.rdata != NULL)
 	{
 		debug1("freeing buffer at %p", (void*)fr->buffer.rdata);
@@ -585,16 +678,19 @@ void frame_exit(mpg123_handle *fr)
 	}
 	fr->buffer.rdata = NULL;
 	frame_free_buffers(fr);
+#ifdef SINC_RESAMPLE
+	resample_exit(fr);
+#endif
+	if(fr->bsspace != NULL) free(fr->bsspace);
+	fr->bsspace = NULL;
 	frame_free_toc(fr);
 #ifdef FRAME_INDEX
 	fi_exit(&fr->index);
+	ei_exit(&fr->exact);
 #endif
+	checkpoint_exit(fr);
 #ifdef OPT_DITHER
-	if(fr->dithernoise != NULL)
-	{
-		free(fr->dithernoise);
-		fr->dithernoise = NULL;
-	}
+	fr->dithernoise = NULL; /* Not ours to free. */
 #endif
 	exit_id3(fr);
 	clear_icy(&fr->icy);
@@ -684,7 +780,13 @@ off_t frame_index_find(mpg123_handle *fr, off_t want_frame, off_t* get_frame)
 	*get_frame = 0;
 #ifdef FRAME_INDEX
 	/* Possibly use VBRI index, too? I'd need an example for this... */
-	if(fr->index.fill)
+	if((fr->p.flags & MPG123_EXACT_INDEX) && want_frame < (off_t)fr->exact.fill)
+	{
+		*get_frame = want_frame;
+		gopos = ei_find(&fr->exact, want_frame);
+		fr->state_flags |= FRAME_ACCURATE;
+	}
+	else if(fr->index.fill)
 	{
 		/* find in index */
 		size_t fi;
@@ -825,8 +927,13 @@ void frame_gapless_init(mpg123_handle *fr, off_t framecount, off_t bskip, off_t
 
 void frame_gapless_realinit(mpg123_handle *fr)
 {
-	fr->begin_os = frame_ins2outs(fr, fr->begin_s);
-	fr->end_os   = frame_ins2outs(fr, fr->end_s);
+	off_t delay = 0;
+#ifdef SINC_RESAMPLE
+	/* The sinc resampler delays its output on top of the decoder delay. */
+	if(fr->gapless_frames > 0) delay = resample_delay(fr);
+#endif
+	fr->begin_os = frame_ins2outs(fr, fr->begin_s+delay);
+	fr->end_os   = frame_ins2outs(fr, fr->end_s+delay);
 	if(fr->gapless_frames > 0)
 	fr->fullend_os = frame_ins2outs(fr, fr->gapless_frames*fr->spf);
 	else fr->fullend_os = 0;
@@ -1001,7 +1108,8 @@ void do_rva(mpg123_handle *fr)
 		debug3("changing scale value from %f to %f (peak estimated to %f)", fr->lastscale != -1 ? fr->lastscale : fr->p.outscale, newscale, (double) (newscale*peak));
 		fr->lastscale = newscale;
 		/* It may be too early, actually. */
-		if(fr->make_decode_tables != NULL) fr->make_decode_tables(fr); /* the actual work */
+		/* Without decwin (released buffers), the next decoder setup takes care. */
+		if(fr->make_decode_tables != NULL && fr->rawdecwin != NULL) fr->make_decode_tables(fr); /* the actual work */
 	}
 }
 
@@ -42,6 +42,7 @@ struct outbuffer
 	unsigned char *p; /* read pointer  */
 	size_t fill; /* fill from read pointer */
 	size_t size;
+	size_t plane; /* distance of the channel planes from p with MPG123_PLANAR, 0 for interleaved */
 	unsigned char *rdata; /* unaligned base pointer */
 };
 
@@ -84,6 +85,11 @@ struct mpg123_pars_struct
 	long feedpool;
 	long feedbuffer;
 #endif
+#ifdef SINC_RESAMPLE
+	int resample; /* MPG123_RESAMPLE_NTOM or MPG123_RESAMPLE_SINC */
+#endif
+	long checkpoints; /* decoder state snapshot every that many frames, 0: none */
+	long readahead; /* bytes to read ahead on a thread, 0: none */
 };
 
 enum frame_state_flags
@@ -91,6 +97,8 @@ enum frame_state_flags
 	 FRAME_ACCURATE      = 0x1  /**<     0001 Positions are considered accurate. */
 	,FRAME_FRANKENSTEIN  = 0x2  /**<     0010 This stream is concatenated. */
 	,FRAME_FRESH_DECODER = 0x4  /**<     0100 Decoder is fleshly initialized. */
+	,FRAME_SCANNING      = 0x8  /**<     1000 mpg123_scan() at work, read_frame() skips frame bodies. */
+	,FRAME_DAMAGED       = 0x10 /**<    10000 A frame was too broken to decode, the decoder state misses its share. */
 };
 
 /* There is a lot to condense here... many ints can be merged as flags; though the main space is still consumed by buffers. */
@@ -98,7 +106,7 @@ struct mpg123_handle_struct
 {
 	int fresh; /* to be moved into flags */
 	int new_format;
-	real hybrid_block[2][2][SBLIMIT*SSLIMIT];
+	real (*hybrid_block)[2][SBLIMIT*SSLIMIT]; /* real hybrid_block[2][2][SBLIMIT*SSLIMIT], in layer3.scratch */
 	int hybrid_blc[2];
 	/* the scratch vars for the decoders, sometimes real, sometimes short... sometimes int/long */ 
 	short *short_buffs[2][2];
@@ -111,7 +119,7 @@ struct mpg123_handle_struct
 	int bo; /* Just have it always here. */
 #ifdef OPT_DITHER
 	int ditherindex;
-	float *dithernoise;
+	const float *dithernoise; /* shared, see dither_table() */
 #endif
 	unsigned char* rawdecwin; /* the block with all decwins */
 	int rawdecwins; /* size of rawdecwin memory */
@@ -133,15 +141,19 @@ struct mpg123_handle_struct
 	unsigned char *conv16to8_buf;
 	unsigned char *conv16to8;
 #endif
-	/* There's some possible memory saving for stuff that is not _really_ dynamic. */
+#ifndef NO_32BIT
+	/* xor on the 24 bit synth output: 0 or the sign bit for unsigned */
+	uint32_t s24_flip;
+#endif
+	/* Tables that are not _really_ dynamic, shared among handles (see init_layer3_stuff() and init_layer12_stuff()). */
 
 	/* layer3 */
-	int longLimit[9][23];
-	int shortLimit[9][14];
-	real gainpow2[256+118+4]; /* not really dynamic, just different for mmx */
+	const unsigned char (*longLimit)[23];
+	const unsigned char (*shortLimit)[14];
+	const real *gainpow2; /* not really dynamic, just different for mmx */
 
 	/* layer2 */
-	real muls[27][64];	/* also used by layer 1 */
+	const real (*muls)[64];	/* also used by layer 1 */
 
 #ifndef NO_NTOM
 	/* decode_ntom */
@@ -165,6 +177,18 @@ struct mpg123_handle_struct
 #if (defined OPT_3DNOW_VINTAGE || defined OPT_3DNOWEXT_VINTAGE || defined OPT_SSE || defined OPT_X86_64 || defined OPT_AVX || defined OPT_NEON || defined OPT_NEON64)
 		void (*the_dct36)(real *,real *,real *,real *,real *);
 #endif
+#ifdef OPT_AVX
+		void (*the_antialias)(real *, int);
+#endif
+#endif
+#if defined(SINC_RESAMPLE) && (defined OPT_X86_64 || defined OPT_AVX)
+		void (*the_resample_dot)(const real *, const real *, int, real *);
+#endif
+#if !defined(NO_32BIT) && defined(OPT_AVX)
+		void (*the_conv_s32_to_24)(unsigned char *, size_t, uint32_t);
+#endif
+#if !defined(NO_EQUALIZER) && (defined OPT_X86_64 || defined OPT_AVX)
+		void (*the_equalizer)(real *, int, real *);
 #endif
 
 #endif
@@ -179,6 +203,9 @@ struct mpg123_handle_struct
 	func_synth synth;
 	func_synth_stereo synth_stereo;
 	func_synth_mono synth_mono;
+	/* The ones wrapped by the above for MPG123_PLANAR, see planar.c . */
+	func_synth_stereo planar_stereo;
+	func_synth_mono planar_mono;
 	/* Yes, this function is runtime-switched, too. */
 	void (*make_decode_tables)(mpg123_handle *fr); /* That is the volume control. */
 
@@ -248,10 +275,11 @@ struct mpg123_handle_struct
 	int fsizeold;
 	int ssize;
 	unsigned int bitreservoir;
-	unsigned char bsspace[2][MAXFRAMESIZE+512]; /* MAXFRAMESIZE */
+	unsigned char (*bsspace)[MAXFRAMESIZE+512]; /* [2][MAXFRAMESIZE+512], allocated on first frame read */
 	unsigned char *bsbuf;
 	unsigned char *bsbufold;
 	int bsnum;
+	int bsbuf_lent; /* bsbuf points into reader memory (lent buffer, file mapping), not bsspace */
 	/* That is the header matching the last read frame body. */
 	unsigned long oldhead;
 	/* That is the header that is supposedly the first of the stream. */
@@ -259,12 +287,14 @@ struct mpg123_handle_struct
 	int abr_rate;
 #ifdef FRAME_INDEX
 	struct frame_index index;
+	struct exact_index exact; /* every frame, with MPG123_EXACT_INDEX */
 #endif
 
 	/* output data */
 	struct outbuffer buffer;
 	struct audioformat af;
 	int own_buffer;
+	size_t outhalf; /* part of the caller's buffer for one channel during a call with planar output */
 	size_t outblock; /* number of bytes that this frame produces (upper bound) */
 	int to_decode;   /* this frame holds data to be decoded */
 	int to_ignore;   /* the same, somehow */
@@ -306,6 +336,7 @@ struct mpg123_handle_struct
 	/*
 		Those layer-specific structs could actually share memory, as they are not in use simultaneously. One might allocate on decoder switch, too.
 		They all reside in one lump of memory (after each other), allocated to layerscratch.
+		Layer 3 is much bigger and gets its own lump, so that MPG123_LAZY_BUFFERS can leave it out for other layers.
 	*/
 	real *layerscratch;
 #ifndef NO_LAYER1
@@ -326,8 +357,21 @@ struct mpg123_handle_struct
 	{
 		real (*hybrid_in)[SBLIMIT][SSLIMIT];  /* ALIGNED(16) real hybridIn[2][SBLIMIT][SSLIMIT]; */
 		real (*hybrid_out)[SSLIMIT][SBLIMIT]; /* ALIGNED(16) real hybridOut[2][SSLIMIT][SBLIMIT]; */
+		real *scratch; /* hybrid_in, hybrid_out and hybrid_block */
 	} layer3;
 #endif
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+	/* Synth thread for MPG123_PIPELINE, see pipeline.h. */
+	struct pipeline *pipeline;
+	int pipeline_failed;
+#endif
+#ifdef SINC_RESAMPLE
+	/* Filter tables and history for MPG123_RESAMPLE_SINC, see resample.c. */
+	struct resampler *resampler;
+#endif
+	/* Decoder state snapshots for MPG123_CHECKPOINTS, see checkpoint.h. */
+	struct checkpoints *checkpoints;
+	off_t checkpoint_next; /* frame to decode next for an exact state, -1 after seeking without snapshot */
 	/* A place for storing additional data for the large file wrapper.
 	   This is cruft! */
 	void *wrapperdata;
@@ -345,6 +389,8 @@ int  frame_output_format(mpg123_handle *fr);
 int frame_buffers(mpg123_handle *fr); /* various decoder buffers, needed once */
 int frame_reset(mpg123_handle* fr);   /* reset for next track */
 int frame_buffers_reset(mpg123_handle *fr);
+int frame_bitstream_buffers(mpg123_handle *fr); /* bsspace, needed before reading a frame */
+void frame_release_buffers(mpg123_handle *fr); /* drop decoder buffers while idle (MPG123_LAZY_BUFFERS) */
 void frame_exit(mpg123_handle *fr);   /* end, free all buffers */
 
 /* Index functions... */
@@ -92,7 +92,18 @@ static void frame_buffercheck(mpg123_handle *fr)
 			/* buffer.p != buffer.data only for own buffer */
 			debug6("cutting %li samples/%li bytes on begin, own_buffer=%i at %p=%p, buf[1]=%i",
 			        (long)fr->firstoff, (long)byteoff, fr->own_buffer, (void*)fr->buffer.p, (void*)fr->buffer.data, ((short*)fr->buffer.p)[2]);
-			if(fr->own_buffer) fr->buffer.p = fr->buffer.data + byteoff;
+			if(fr->buffer.plane)
+			{ /* Both channel planes lose their beginning, keeping their distance. */
+				byteoff /= 2;
+				if(fr->own_buffer) fr->buffer.p = fr->buffer.data + byteoff;
+				else
+				{
+					memmove(fr->buffer.data, fr->buffer.data + byteoff, fr->buffer.fill/2);
+					memmove( fr->buffer.data + fr->buffer.plane
+					,	fr->buffer.data + fr->buffer.plane + byteoff, fr->buffer.fill/2 );
+				}
+			}
+			else if(fr->own_buffer) fr->buffer.p = fr->buffer.data + byteoff;
 			else memmove(fr->buffer.data, fr->buffer.data + byteoff, fr->buffer.fill);
 			debug3("done cutting, buffer at %p =? %p, buf[1]=%i",
 			        (void*)fr->buffer.p, (void*)fr->buffer.data, ((short*)fr->buffer.p)[2]);
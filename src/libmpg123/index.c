@@ -134,3 +134,112 @@ void fi_reset(struct frame_index *fi)
 	fi->step = 1;
 	fi->next = fi_next(fi);
 }
+
+void ei_init(struct exact_index *ei)
+{
+	ei->base = NULL;
+	ei->delta = NULL;
+	ei->far_frame = NULL;
+	ei->far_pos = NULL;
+	ei->last = 0;
+	ei->fill = 0;
+	ei->size = 0;
+	ei->far_fill = 0;
+	ei->far_size = 0;
+}
+
+void ei_exit(struct exact_index *ei)
+{
+	if(ei->base != NULL) free(ei->base);
+	if(ei->delta != NULL) free(ei->delta);
+	if(ei->far_frame != NULL) free(ei->far_frame);
+	if(ei->far_pos != NULL) free(ei->far_pos);
+	ei_init(ei);
+}
+
+void ei_reset(struct exact_index *ei)
+{
+	ei->last = 0;
+	ei->fill = 0;
+	ei->far_fill = 0;
+}
+
+static int ei_add_far(struct exact_index *ei, off_t pos)
+{
+	if(ei->far_fill == ei->far_size)
+	{
+		size_t newsize = ei->far_size ? 2*ei->far_size : 16;
+		off_t *newframe, *newpos;
+		newframe = safe_realloc(ei->far_frame, newsize*sizeof(off_t));
+		if(newframe == NULL) return -1;
+		ei->far_frame = newframe;
+		newpos = safe_realloc(ei->far_pos, newsize*sizeof(off_t));
+		if(newpos == NULL) return -1;
+		ei->far_pos = newpos;
+		ei->far_size = newsize;
+	}
+	ei->far_frame[ei->far_fill] = (off_t)ei->fill;
+	ei->far_pos[ei->far_fill] = pos;
+	++ei->far_fill;
+	return 0;
+}
+
+int ei_add(struct exact_index *ei, off_t pos)
+{
+	size_t block = ei->fill % EI_BLOCK;
+	if(ei->fill == ei->size)
+	{ /* Double the room, starting with about a minute of audio. */
+		size_t newsize = ei->size ? 2*ei->size : 32*EI_BLOCK;
+		unsigned short *newdelta;
+		off_t *newbase;
+		newdelta = safe_realloc(ei->delta, newsize*sizeof(unsigned short));
+		if(newdelta == NULL) return -1;
+		ei->delta = newdelta;
+		newbase = safe_realloc(ei->base, newsize/EI_BLOCK*sizeof(off_t));
+		if(newbase == NULL) return -1;
+		ei->base = newbase;
+		ei->size = newsize;
+		debug1("exact index grown to %lu frames", (unsigned long)ei->size);
+	}
+	if(block == 0)
+	{
+		ei->base[ei->fill/EI_BLOCK] = pos;
+		ei->delta[ei->fill] = 0;
+	}
+	else if(pos > ei->last && pos - ei->last < EI_FAR)
+	ei->delta[ei->fill] = (unsigned short)(pos - ei->last);
+	else
+	{
+		if(ei_add_far(ei, pos)) return -1;
+		ei->delta[ei->fill] = EI_FAR;
+	}
+	ei->last = pos;
+	++ei->fill;
+	return 0;
+}
+
+/* Binary search in the far list, the frame is in there. */
+static off_t ei_far(struct exact_index *ei, off_t frame)
+{
+	size_t lo = 0;
+	size_t hi = ei->far_fill;
+	while(hi - lo > 1)
+	{
+		size_t mid = lo + (hi-lo)/2;
+		if(ei->far_frame[mid] > frame) hi = mid;
+		else lo = mid;
+	}
+	return ei->far_pos[lo];
+}
+
+off_t ei_find(struct exact_index *ei, off_t frame)
+{
+	size_t i = (size_t)frame;
+	size_t first = i - i % EI_BLOCK;
+	off_t pos;
+	/* Add up the distances back to the last full position in the block. */
+	while(i > first && ei->delta[i] != EI_FAR) --i;
+	pos = i > first ? ei_far(ei, (off_t)i) : ei->base[first/EI_BLOCK];
+	for(++i; i <= (size_t)frame; ++i) pos += ei->delta[i];
+	return pos;
+}
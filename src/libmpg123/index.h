@@ -56,4 +56,39 @@ int fi_set(struct frame_index *fi, off_t *offsets, off_t step, size_t fill);
 /* Empty the index (setting fill=0 and step=1), but keep current size. */
 void fi_reset(struct frame_index *fi);
 
+/*
+	The exact index (MPG123_EXACT_INDEX) records the position of every frame.
+	Every EI_BLOCK-th position is stored in full, the others as distance to the
+	frame before, which fits into 16 bits for any sane stream (only junk
+	between frames makes it bigger). Those rare far positions are kept in a
+	separate list sorted by frame number. That makes about 2.1 bytes per frame,
+	less than 300K for an hour of 44.1 kHz audio.
+*/
+#define EI_BLOCK 64
+#define EI_FAR 0xffff
+
+struct exact_index
+{
+	off_t *base;           /* position of frame i*EI_BLOCK */
+	unsigned short *delta; /* distance to the frame before, EI_FAR: look in the far list */
+	off_t *far_frame;      /* frames with EI_FAR, ascending */
+	off_t *far_pos;        /* ... and their positions */
+	off_t  last;           /* position of the last added frame */
+	size_t fill;           /* number of frames recorded, the next one to add */
+	size_t size;           /* room in delta, a multiple of EI_BLOCK */
+	size_t far_fill;
+	size_t far_size;
+};
+
+#define EI_NEXT(ei, framenum) ((off_t)(ei).fill == (framenum))
+
+void ei_init(struct exact_index *ei);
+void ei_exit(struct exact_index *ei);
+/* Forget the positions, keep the memory. */
+void ei_reset(struct exact_index *ei);
+/* Append the position of frame number fill. Return 0 on success. */
+int ei_add(struct exact_index *ei, off_t pos);
+/* Position of the given frame, which must be < fill. */
+off_t ei_find(struct exact_index *ei, off_t frame);
+
 #endif
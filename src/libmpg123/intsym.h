@@ -17,7 +17,9 @@
 #define unintr_read INT123_unintr_read
 #define ntom_set_ntom INT123_ntom_set_ntom
 #define synth_1to1 INT123_synth_1to1
+#define synth_1to1_stereo INT123_synth_1to1_stereo
 #define synth_1to1_dither INT123_synth_1to1_dither
+#define synth_1to1_dither_stereo INT123_synth_1to1_dither_stereo
 #define synth_1to1_i386 INT123_synth_1to1_i386
 #define synth_1to1_i586 INT123_synth_1to1_i586
 #define synth_1to1_i586_dither INT123_synth_1to1_i586_dither
@@ -30,6 +32,8 @@
 #define synth_1to1_stereo_altivec INT123_synth_1to1_stereo_altivec
 #define synth_1to1_x86_64 INT123_synth_1to1_x86_64
 #define synth_1to1_stereo_x86_64 INT123_synth_1to1_stereo_x86_64
+#define synth_1to1_x86_64_dither INT123_synth_1to1_x86_64_dither
+#define synth_1to1_stereo_x86_64_dither INT123_synth_1to1_stereo_x86_64_dither
 #define synth_1to1_avx INT123_synth_1to1_avx
 #define synth_1to1_stereo_avx INT123_synth_1to1_stereo_avx
 #define synth_1to1_arm INT123_synth_1to1_arm
@@ -41,37 +45,48 @@
 #define synth_1to1_mono INT123_synth_1to1_mono
 #define synth_1to1_m2s INT123_synth_1to1_m2s
 #define synth_2to1 INT123_synth_2to1
+#define synth_2to1_stereo INT123_synth_2to1_stereo
 #define synth_2to1_dither INT123_synth_2to1_dither
+#define synth_2to1_dither_stereo INT123_synth_2to1_dither_stereo
 #define synth_2to1_i386 INT123_synth_2to1_i386
 #define synth_2to1_mono INT123_synth_2to1_mono
 #define synth_2to1_m2s INT123_synth_2to1_m2s
 #define synth_4to1 INT123_synth_4to1
+#define synth_4to1_stereo INT123_synth_4to1_stereo
 #define synth_4to1_dither INT123_synth_4to1_dither
+#define synth_4to1_dither_stereo INT123_synth_4to1_dither_stereo
 #define synth_4to1_i386 INT123_synth_4to1_i386
 #define synth_4to1_mono INT123_synth_4to1_mono
 #define synth_4to1_m2s INT123_synth_4to1_m2s
 #define synth_ntom INT123_synth_ntom
+#define synth_ntom_stereo INT123_synth_ntom_stereo
 #define synth_ntom_mono INT123_synth_ntom_mono
 #define synth_ntom_m2s INT123_synth_ntom_m2s
 #define synth_1to1_8bit INT123_synth_1to1_8bit
+#define synth_1to1_8bit_stereo INT123_synth_1to1_8bit_stereo
 #define synth_1to1_8bit_i386 INT123_synth_1to1_8bit_i386
 #define synth_1to1_8bit_wrap INT123_synth_1to1_8bit_wrap
+#define synth_1to1_8bit_wrap_stereo INT123_synth_1to1_8bit_wrap_stereo
 #define synth_1to1_8bit_mono INT123_synth_1to1_8bit_mono
 #define synth_1to1_8bit_m2s INT123_synth_1to1_8bit_m2s
 #define synth_1to1_8bit_wrap_mono INT123_synth_1to1_8bit_wrap_mono
 #define synth_1to1_8bit_wrap_m2s INT123_synth_1to1_8bit_wrap_m2s
 #define synth_2to1_8bit INT123_synth_2to1_8bit
+#define synth_2to1_8bit_stereo INT123_synth_2to1_8bit_stereo
 #define synth_2to1_8bit_i386 INT123_synth_2to1_8bit_i386
 #define synth_2to1_8bit_mono INT123_synth_2to1_8bit_mono
 #define synth_2to1_8bit_m2s INT123_synth_2to1_8bit_m2s
 #define synth_4to1_8bit INT123_synth_4to1_8bit
+#define synth_4to1_8bit_stereo INT123_synth_4to1_8bit_stereo
 #define synth_4to1_8bit_i386 INT123_synth_4to1_8bit_i386
 #define synth_4to1_8bit_mono INT123_synth_4to1_8bit_mono
 #define synth_4to1_8bit_m2s INT123_synth_4to1_8bit_m2s
 #define synth_ntom_8bit INT123_synth_ntom_8bit
+#define synth_ntom_8bit_stereo INT123_synth_ntom_8bit_stereo
 #define synth_ntom_8bit_mono INT123_synth_ntom_8bit_mono
 #define synth_ntom_8bit_m2s INT123_synth_ntom_8bit_m2s
 #define synth_1to1_real INT123_synth_1to1_real
+#define synth_1to1_real_stereo INT123_synth_1to1_real_stereo
 #define synth_1to1_real_i386 INT123_synth_1to1_real_i386
 #define synth_1to1_real_sse INT123_synth_1to1_real_sse
 #define synth_1to1_real_stereo_sse INT123_synth_1to1_real_stereo_sse
@@ -88,17 +103,21 @@
 #define synth_1to1_real_mono INT123_synth_1to1_real_mono
 #define synth_1to1_real_m2s INT123_synth_1to1_real_m2s
 #define synth_2to1_real INT123_synth_2to1_real
+#define synth_2to1_real_stereo INT123_synth_2to1_real_stereo
 #define synth_2to1_real_i386 INT123_synth_2to1_real_i386
 #define synth_2to1_real_mono INT123_synth_2to1_real_mono
 #define synth_2to1_real_m2s INT123_synth_2to1_real_m2s
 #define synth_4to1_real INT123_synth_4to1_real
+#define synth_4to1_real_stereo INT123_synth_4to1_real_stereo
 #define synth_4to1_real_i386 INT123_synth_4to1_real_i386
 #define synth_4to1_real_mono INT123_synth_4to1_real_mono
 #define synth_4to1_real_m2s INT123_synth_4to1_real_m2s
 #define synth_ntom_real INT123_synth_ntom_real
+#define synth_ntom_real_stereo INT123_synth_ntom_real_stereo
 #define synth_ntom_real_mono INT123_synth_ntom_real_mono
 #define synth_ntom_real_m2s INT123_synth_ntom_real_m2s
 #define synth_1to1_s32 INT123_synth_1to1_s32
+#define synth_1to1_s32_stereo INT123_synth_1to1_s32_stereo
 #define synth_1to1_s32_i386 INT123_synth_1to1_s32_i386
 #define synth_1to1_s32_sse INT123_synth_1to1_s32_sse
 #define synth_1to1_s32_stereo_sse INT123_synth_1to1_s32_stereo_sse
@@ -115,16 +134,38 @@
 #define synth_1to1_s32_mono INT123_synth_1to1_s32_mono
 #define synth_1to1_s32_m2s INT123_synth_1to1_s32_m2s
 #define synth_2to1_s32 INT123_synth_2to1_s32
+#define synth_2to1_s32_stereo INT123_synth_2to1_s32_stereo
 #define synth_2to1_s32_i386 INT123_synth_2to1_s32_i386
 #define synth_2to1_s32_mono INT123_synth_2to1_s32_mono
 #define synth_2to1_s32_m2s INT123_synth_2to1_s32_m2s
 #define synth_4to1_s32 INT123_synth_4to1_s32
+#define synth_4to1_s32_stereo INT123_synth_4to1_s32_stereo
 #define synth_4to1_s32_i386 INT123_synth_4to1_s32_i386
 #define synth_4to1_s32_mono INT123_synth_4to1_s32_mono
 #define synth_4to1_s32_m2s INT123_synth_4to1_s32_m2s
 #define synth_ntom_s32 INT123_synth_ntom_s32
+#define synth_ntom_s32_stereo INT123_synth_ntom_s32_stereo
 #define synth_ntom_s32_mono INT123_synth_ntom_s32_mono
 #define synth_ntom_s32_m2s INT123_synth_ntom_s32_m2s
+#define synth_1to1_s24 INT123_synth_1to1_s24
+#define synth_1to1_s24_stereo INT123_synth_1to1_s24_stereo
+#define synth_1to1_s24_i386 INT123_synth_1to1_s24_i386
+#define synth_1to1_s24_mono INT123_synth_1to1_s24_mono
+#define synth_1to1_s24_m2s INT123_synth_1to1_s24_m2s
+#define synth_2to1_s24 INT123_synth_2to1_s24
+#define synth_2to1_s24_stereo INT123_synth_2to1_s24_stereo
+#define synth_2to1_s24_i386 INT123_synth_2to1_s24_i386
+#define synth_2to1_s24_mono INT123_synth_2to1_s24_mono
+#define synth_2to1_s24_m2s INT123_synth_2to1_s24_m2s
+#define synth_4to1_s24 INT123_synth_4to1_s24
+#define synth_4to1_s24_stereo INT123_synth_4to1_s24_stereo
+#define synth_4to1_s24_i386 INT123_synth_4to1_s24_i386
+#define synth_4to1_s24_mono INT123_synth_4to1_s24_mono
+#define synth_4to1_s24_m2s INT123_synth_4to1_s24_m2s
+#define synth_ntom_s24 INT123_synth_ntom_s24
+#define synth_ntom_s24_stereo INT123_synth_ntom_s24_stereo
+#define synth_ntom_s24_mono INT123_synth_ntom_s24_mono
+#define synth_ntom_s24_m2s INT123_synth_ntom_s24_m2s
 #define dct64 INT123_dct64
 #define dct64_i386 INT123_dct64_i386
 #define dct64_altivec INT123_dct64_altivec
@@ -137,6 +178,22 @@
 #define dct36_avx INT123_dct36_avx
 #define dct36_neon INT123_dct36_neon
 #define dct36_neon64 INT123_dct36_neon64
+#define antialias INT123_antialias
+#define antialias_avx INT123_antialias_avx
+#define synth_planar_stereo INT123_synth_planar_stereo
+#define synth_planar_m2s INT123_synth_planar_m2s
+#define resample_init INT123_resample_init
+#define resample_exit INT123_resample_exit
+#define resample_delay INT123_resample_delay
+#define synth_sinc INT123_synth_sinc
+#define synth_sinc_stereo INT123_synth_sinc_stereo
+#define synth_sinc_mono INT123_synth_sinc_mono
+#define synth_sinc_m2s INT123_synth_sinc_m2s
+#define resample_dot INT123_resample_dot
+#define resample_dot_x86_64 INT123_resample_dot_x86_64
+#define resample_dot_avx INT123_resample_dot_avx
+#define conv_s32_to_24 INT123_conv_s32_to_24
+#define conv_s32_to_24_avx INT123_conv_s32_to_24_avx
 #define synth_ntom_set_step INT123_synth_ntom_set_step
 #define ntom_val INT123_ntom_val
 #define ntom_frame_outsamples INT123_ntom_frame_outsamples
@@ -144,22 +201,20 @@
 #define ntom_ins2outs INT123_ntom_ins2outs
 #define ntom_frameoff INT123_ntom_frameoff
 #define init_layer3 INT123_init_layer3
-#define init_layer3_gainpow2 INT123_init_layer3_gainpow2
 #define init_layer3_stuff INT123_init_layer3_stuff
 #define init_layer12 INT123_init_layer12
-#define init_layer12_table INT123_init_layer12_table
 #define init_layer12_stuff INT123_init_layer12_stuff
 #define prepare_decode_tables INT123_prepare_decode_tables
 #define make_decode_tables INT123_make_decode_tables
 #define make_decode_tables_mmx INT123_make_decode_tables_mmx
-#define init_layer3_gainpow2_mmx INT123_init_layer3_gainpow2_mmx
-#define init_layer12_table_mmx INT123_init_layer12_table_mmx
 #define make_conv16to8_table INT123_make_conv16to8_table
 #define do_layer3 INT123_do_layer3
 #define do_layer2 INT123_do_layer2
 #define do_layer1 INT123_do_layer1
 #define do_equalizer INT123_do_equalizer
-#define dither_table_init INT123_dither_table_init
+#define do_equalizer_x86_64 INT123_do_equalizer_x86_64
+#define do_equalizer_avx INT123_do_equalizer_avx
+#define dither_table INT123_dither_table
 #define frame_dither_init INT123_frame_dither_init
 #define invalidate_format INT123_invalidate_format
 #define frame_init INT123_frame_init
@@ -169,6 +224,8 @@
 #define frame_buffers INT123_frame_buffers
 #define frame_reset INT123_frame_reset
 #define frame_buffers_reset INT123_frame_buffers_reset
+#define frame_bitstream_buffers INT123_frame_bitstream_buffers
+#define frame_release_buffers INT123_frame_release_buffers
 #define frame_exit INT123_frame_exit
 #define frame_index_find INT123_frame_index_find
 #define frame_index_setup INT123_frame_index_setup
@@ -207,6 +264,11 @@
 #define fi_add INT123_fi_add
 #define fi_set INT123_fi_set
 #define fi_reset INT123_fi_reset
+#define ei_init INT123_ei_init
+#define ei_exit INT123_ei_exit
+#define ei_reset INT123_ei_reset
+#define ei_add INT123_ei_add
+#define ei_find INT123_ei_find
 #define double_to_long_rounded INT123_double_to_long_rounded
 #define scale_rounded INT123_scale_rounded
 #define decode_update INT123_decode_update
@@ -226,11 +288,29 @@
 #define frame_freq INT123_frame_freq
 #define read_frame_recover INT123_read_frame_recover
 #define read_frame INT123_read_frame
+#define read_frame_restore INT123_read_frame_restore
 #define set_pointer INT123_set_pointer
 #define position_info INT123_position_info
 #define compute_bpf INT123_compute_bpf
 #define time_to_frame INT123_time_to_frame
 #define get_songlen INT123_get_songlen
+#define pipeline_use INT123_pipeline_use
+#define pipeline_slot INT123_pipeline_slot
+#define pipeline_push INT123_pipeline_push
+#define pipeline_sync INT123_pipeline_sync
+#define pipeline_exit INT123_pipeline_exit
+#define checkpoint_save INT123_checkpoint_save
+#define checkpoint_find INT123_checkpoint_find
+#define checkpoint_restore INT123_checkpoint_restore
+#define checkpoint_reset INT123_checkpoint_reset
+#define checkpoint_exit INT123_checkpoint_exit
+#define checkpoint_state_size INT123_checkpoint_state_size
+#define checkpoint_state_get INT123_checkpoint_state_get
+#define checkpoint_state_set INT123_checkpoint_state_set
+#define readahead_new INT123_readahead_new
+#define readahead_read INT123_readahead_read
+#define readahead_seek INT123_readahead_seek
+#define readahead_del INT123_readahead_del
 #define bc_prepare INT123_bc_prepare
 #define bc_cleanup INT123_bc_cleanup
 #define bc_poolsize INT123_bc_poolsize
@@ -239,8 +319,10 @@
 #define open_stream_handle INT123_open_stream_handle
 #define open_feed INT123_open_feed
 #define feed_more INT123_feed_more
+#define feed_lend INT123_feed_lend
 #define feed_forget INT123_feed_forget
 #define feed_set_pos INT123_feed_set_pos
+#define feed_pending INT123_feed_pending
 #define open_bad INT123_open_bad
 #define check_neon INT123_check_neon
 #define dct64_3dnow INT123_dct64_3dnow
@@ -257,7 +339,6 @@
 #define dct64_real_sse INT123_dct64_real_sse
 #define dct64_x86_64 INT123_dct64_x86_64
 #define dct64_real_x86_64 INT123_dct64_real_x86_64
-#define do_equalizer_3dnow INT123_do_equalizer_3dnow
 #define synth_1to1_3dnow_asm INT123_synth_1to1_3dnow_asm
 #define synth_1to1_arm_asm INT123_synth_1to1_arm_asm
 #define synth_1to1_arm_accurate_asm INT123_synth_1to1_arm_accurate_asm
@@ -298,6 +379,8 @@
 #define synth_1to1_x86_64_accurate_asm INT123_synth_1to1_x86_64_accurate_asm
 #define synth_1to1_real_x86_64_asm INT123_synth_1to1_real_x86_64_asm
 #define synth_1to1_s32_x86_64_asm INT123_synth_1to1_s32_x86_64_asm
+#define dither_s16_x86_64 INT123_dither_s16_x86_64
+#define dither_s16_s_x86_64 INT123_dither_s16_s_x86_64
 #define costab_mmxsse INT123_costab_mmxsse
 #define make_decode_tables_mmx_asm INT123_make_decode_tables_mmx_asm
 #ifndef HAVE_STRDUP
@@ -175,6 +175,18 @@ int do_layer1(mpg123_handle *fr)
 	for(i=0;i<SCALE_BLOCK;i++)
 	{
 		I_step_two(fraction,balloc,scale_index,fr);
+#ifndef NO_EQUALIZER
+		if(fr->have_eq_settings)
+		{
+			if(single != SINGLE_STEREO)
+			opt_equalizer(fr)(fraction[single], 1, fr->equalizer[0]);
+			else
+			{
+				opt_equalizer(fr)(fraction[0], 1, fr->equalizer[0]);
+				opt_equalizer(fr)(fraction[1], 1, fr->equalizer[1]);
+			}
+		}
+#endif
 
 		if(single != SINGLE_STEREO)
 		clip += (fr->synth_mono)(fraction[single], fr);
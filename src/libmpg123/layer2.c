@@ -36,6 +36,60 @@ static const double mulmul[27] =
 };
 #endif
 
+#ifdef OPT_MMXORSSE
+#define MULS_TABS 3
+#else
+#define MULS_TABS 1
+#endif
+/* Read-only tables shared by all handles, init_layer12_stuff() picks the variant. */
+static real muls_tabs[MULS_TABS][27][64];
+
+static real* init_layer12_table(real *table, int m)
+{
+#if defined(REAL_IS_FIXED) && defined(PRECALC_TABLES)
+	int i;
+	for(i=0;i<63;i++)
+	*table++ = layer12_table[m][i];
+#else
+	int i,j;
+	for(j=3,i=0;i<63;i++,j--)
+	*table++ = DOUBLE_TO_REAL_SCALE_LAYER12(mulmul[m] * pow(2.0,(double) j / 3.0));
+#endif
+
+	return table;
+}
+
+#ifdef OPT_MMXORSSE
+static real* init_layer12_table_mmx(real *table, int m, int down_sample)
+{
+	int i,j;
+	if(!down_sample) 
+	{
+		for(j=3,i=0;i<63;i++,j--)
+			*table++ = DOUBLE_TO_REAL(16384 * mulmul[m] * pow(2.0,(double) j / 3.0));
+	}
+	else
+	{
+		for(j=3,i=0;i<63;i++,j--)
+		*table++ = DOUBLE_TO_REAL(mulmul[m] * pow(2.0,(double) j / 3.0));
+	}
+	return table;
+}
+#endif
+
+static void init_muls(void)
+{
+	int k;
+	for(k=0;k<27;k++)
+	{
+		*init_layer12_table(muls_tabs[0][k], k) = 0.0;
+#ifdef OPT_MMXORSSE
+		*init_layer12_table_mmx(muls_tabs[1][k], k, 0) = 0.0;
+		*init_layer12_table_mmx(muls_tabs[2][k], k, 1) = 0.0;
+#endif
+	}
+}
+
 void init_layer12(void)
 {
 	const int base[3][9] =
@@ -62,51 +116,18 @@ void init_layer12(void)
 			*itable++ = base[i][j];
 		}
 	}
-}
 
-void init_layer12_stuff(mpg123_handle *fr, real* (*init_table)(mpg123_handle *fr, real *table, int m))
-{
-	int k;
-	real *table;
-	for(k=0;k<27;k++)
-	{
-		table = init_table(fr, fr->muls[k], k);
-		*table++ = 0.0;
-	}
+	init_muls();
 }
 
-real* init_layer12_table(mpg123_handle *fr, real *table, int m)
+void init_layer12_stuff(mpg123_handle *fr, int mmx)
 {
-#if defined(REAL_IS_FIXED) && defined(PRECALC_TABLES)
-	int i;
-	for(i=0;i<63;i++)
-	*table++ = layer12_table[m][i];
-#else
-	int i,j;
-	for(j=3,i=0;i<63;i++,j--)
-	*table++ = DOUBLE_TO_REAL_SCALE_LAYER12(mulmul[m] * pow(2.0,(double) j / 3.0));
-#endif
-
-	return table;
-}
-
 #ifdef OPT_MMXORSSE
-real* init_layer12_table_mmx(mpg123_handle *fr, real *table, int m)
-{
-	int i,j;
-	if(!fr->p.down_sample) 
-	{
-		for(j=3,i=0;i<63;i++,j--)
-			*table++ = DOUBLE_TO_REAL(16384 * mulmul[m] * pow(2.0,(double) j / 3.0));
-	}
+	if(mmx) fr->muls = (const real (*)[64])muls_tabs[fr->p.down_sample ? 2 : 1];
 	else
-	{
-		for(j=3,i=0;i<63;i++,j--)
-		*table++ = DOUBLE_TO_REAL(mulmul[m] * pow(2.0,(double) j / 3.0));
-	}
-	return table;
-}
 #endif
+	fr->muls = (const real (*)[64])muls_tabs[0];
+}
 
 #endif /* NO_LAYER12 */
 
@@ -356,6 +377,18 @@ int do_layer2(mpg123_handle *fr)
 	for(i=0;i<SCALE_BLOCK;i++)
 	{
 		II_step_two(bit_alloc,fraction,scale,fr,i>>2);
+#ifndef NO_EQUALIZER
+		if(fr->have_eq_settings)
+		{
+			if(single != SINGLE_STEREO)
+			opt_equalizer(fr)(fraction[single][0], 3, fr->equalizer[0]);
+			else
+			{
+				opt_equalizer(fr)(fraction[0][0], 3, fr->equalizer[0]);
+				opt_equalizer(fr)(fraction[1][0], 3, fr->equalizer[1]);
+			}
+		}
+#endif
 		for(j=0;j<3;j++) 
 		{
 			if(single != SINGLE_STEREO)
@@ -21,6 +21,7 @@
 #include "huffman.h"
 #endif
 #include "getbits.h"
+#include "pipeline.h"
 #include "debug.h"
 
 
@@ -71,8 +72,8 @@ struct gr_info_s
 	unsigned preflag;
 	unsigned scalefac_scale;
 	unsigned count1table_select;
-	real *full_gain[3];
-	real *pow2gain;
+	const real *full_gain[3];
+	const real *pow2gain;
 };
 
 struct III_sideinfo
@@ -159,17 +160,50 @@ static int *mapend[9][3];
 static unsigned int n_slen2[512]; /* MPEG 2.0 slen for 'normal' mode */
 static unsigned int i_slen2[256]; /* MPEG 2.0 slen for intensity stereo */
 
+/*
+	Read-only tables shared by all handles, init_layer3_stuff() picks the variant.
+	The MMX-style decoders want gainpow2 scaled differently, depending on
+	downsampling. The band limits depend on the subband limit for resampling.
+	Scalefactors of broken streams can index gainpow2 beyond the 256+118+4 gains,
+	up to 256+4+(7<<3)+(31<<2) (MS gain, subblock gain, shifted scalefactor).
+	Such gains are below 2^-68; the padding keeps them zero, in the same row.
+*/
+#ifdef OPT_MMXORSSE
+#define GAINPOW2_TABS 3
+#else
+#define GAINPOW2_TABS 1
+#endif
+#define GAINPOW2_PAD 63
+static real gainpow2_tabs[GAINPOW2_TABS][256+118+4+GAINPOW2_PAD];
+static unsigned char longLimit_tabs[SBLIMIT+1][9][23];
+static unsigned char shortLimit_tabs[SBLIMIT+1][9][14];
+
+/*
+	One-step lookup of Huffman codes: the next HUFF_LUT_BITS bits of big values give
+	(code length<<8) | (x<<4) | y, or HUFF_LUT_MISS for longer codes that need the
+	table walk. When the sign bits of x and y also fit in, the entry has HUFF_LUT_SIGNS
+	set, the length includes them and HUFF_LUT_NEGX/HUFF_LUT_NEGY carry them.
+	The count1 codes (up to 6 bits) always resolve to (length<<4) | quad.
+*/
+#define HUFF_LUT_BITS 8
+#define HUFF_LUT_MISS 0x8000
+#define HUFF_LUT_SIGNS 0x4000
+#define HUFF_LUT_NEGX 0x2000
+#define HUFF_LUT_NEGY 0x1000
+static unsigned short huff_lut[32][1<<HUFF_LUT_BITS];
+static unsigned char huff_lut_c[2][64];
+
 /* Some helpers used in init_layer3 */
 
 #ifdef OPT_MMXORSSE
-real init_layer3_gainpow2_mmx(mpg123_handle *fr, int i)
+static real init_layer3_gainpow2_mmx(int down_sample, int i)
 {
-	if(!fr->p.down_sample) return DOUBLE_TO_REAL(16384.0 * pow((double)2.0,-0.25 * (double) (i+210) ));
+	if(!down_sample) return DOUBLE_TO_REAL(16384.0 * pow((double)2.0,-0.25 * (double) (i+210) ));
 	else return DOUBLE_TO_REAL(pow((double)2.0,-0.25 * (double) (i+210)));
 }
 #endif
 
-real init_layer3_gainpow2(mpg123_handle *fr, int i)
+static real init_layer3_gainpow2(int i)
 {
 #if defined(REAL_IS_FIXED) && defined(PRECALC_TABLES)
 	return gainpow2[i+256];
@@ -179,6 +213,36 @@ real init_layer3_gainpow2(mpg123_handle *fr, int i)
 }
 
 
+/*
+	Walk a Huffman table for the code at the top of the 24 bit value q, just like
+	III_dequantize_sample() does. Returns (code length<<8) | value.
+*/
+static unsigned int huff_walk(const short *val, unsigned long q, int radix4)
+{
+	int bits = 0;
+	short y;
+
+	if(radix4)
+	{
+		while((y=val[(q>>(20-bits)) & 0xf])<0)
+		{
+			val -= y;
+			bits += 4;
+		}
+		bits += y >> 8;
+	}
+	else
+	{
+		while((y=*val++)<0)
+		{
+			if(q & (1UL<<(23-bits))) val -= y;
+
+			bits++;
+		}
+	}
+	return ((unsigned int)bits<<8) | (y & 0xff);
+}
+
 /* init tables for layer-3 ... specific with the downsampling... */
 void init_layer3(void)
 {
@@ -365,32 +429,87 @@ void init_layer3(void)
 		int n = k + j * 4 + i * 20;
 		n_slen2[n+400] = i|(j<<3)|(k<<6)|(1<<12);
 	}
-}
-
-
-void init_layer3_stuff(mpg123_handle *fr, real (*gainpow2)(mpg123_handle *fr, int i))
-{
-	int i,j;
 
-	for(i=-256;i<118+4;i++)	fr->gainpow2[i+256] = gainpow2(fr,i);
+	for(i=-256;i<118+4;i++)
+	{
+		gainpow2_tabs[0][i+256] = init_layer3_gainpow2(i);
+#ifdef OPT_MMXORSSE
+		gainpow2_tabs[1][i+256] = init_layer3_gainpow2_mmx(0, i);
+		gainpow2_tabs[2][i+256] = init_layer3_gainpow2_mmx(1, i);
+#endif
+	}
 
+	for(l=0;l<=SBLIMIT;l++)
 	for(j=0;j<9;j++)
 	{
 		for(i=0;i<23;i++)
 		{
-			fr->longLimit[j][i] = (bandInfo[j].longIdx[i] - 1 + 8) / 18 + 1;
-			if(fr->longLimit[j][i] > (fr->down_sample_sblimit) )
-			fr->longLimit[j][i] = fr->down_sample_sblimit;
+			k = (bandInfo[j].longIdx[i] - 1 + 8) / 18 + 1;
+			longLimit_tabs[l][j][i] = k > l ? l : k;
 		}
 		for(i=0;i<14;i++)
 		{
-			fr->shortLimit[j][i] = (bandInfo[j].shortIdx[i] - 1) / 18 + 1;
-			if(fr->shortLimit[j][i] > (fr->down_sample_sblimit) )
-			fr->shortLimit[j][i] = fr->down_sample_sblimit;
+			k = (bandInfo[j].shortIdx[i] - 1) / 18 + 1;
+			shortLimit_tabs[l][j][i] = k > l ? l : k;
+		}
+	}
+
+	for(j=0;j<32;j++)
+	for(i=0;i<(1<<HUFF_LUT_BITS);i++)
+	{
+#ifdef USE_NEW_HUFFTABLE
+		unsigned int e = huff_walk(ht[j].table, (unsigned long)i<<(24-HUFF_LUT_BITS), TRUE);
+#else
+		unsigned int e = huff_walk(ht[j].table, (unsigned long)i<<(24-HUFF_LUT_BITS), FALSE);
+#endif
+		int len = e>>8;
+		int val[2];
+		int signs = 0;
+
+		if(len > HUFF_LUT_BITS)
+		{
+			huff_lut[j][i] = HUFF_LUT_MISS;
+			continue;
+		}
+		huff_lut[j][i] = e;
+		/* Sign bits follow the code, one for each nonzero value without linbits. */
+		val[0] = (e>>4) & 0xf;
+		val[1] = e & 0xf;
+		for(k=0;k<2;k++)
+		{
+			if(val[k] == 15 && ht[j].linbits) break;
+			if(!val[k]) continue;
+			if(len >= HUFF_LUT_BITS) break;
+			if(i & (1<<(HUFF_LUT_BITS-1-len))) signs |= k ? HUFF_LUT_NEGY : HUFF_LUT_NEGX;
+			len++;
 		}
+		if(k == 2)
+		huff_lut[j][i] = HUFF_LUT_SIGNS | signs | (len<<8) | (e & 0xff);
+	}
+	for(j=0;j<2;j++)
+	for(i=0;i<64;i++)
+	{
+		unsigned int e = huff_walk(htc[j].table, (unsigned long)i<<18, FALSE);
+		huff_lut_c[j][i] = ((e>>8)<<4) | (e & 0xf);
 	}
 }
 
+
+void init_layer3_stuff(mpg123_handle *fr, int mmx)
+{
+	int sblimit = fr->down_sample_sblimit;
+	if(sblimit < 0) sblimit = 0;
+	if(sblimit > SBLIMIT) sblimit = SBLIMIT;
+
+#ifdef OPT_MMXORSSE
+	if(mmx) fr->gainpow2 = gainpow2_tabs[fr->p.down_sample ? 2 : 1];
+	else
+#endif
+	fr->gainpow2 = gainpow2_tabs[0];
+	fr->longLimit  = (const unsigned char (*)[23])longLimit_tabs[sblimit];
+	fr->shortLimit = (const unsigned char (*)[14])shortLimit_tabs[sblimit];
+}
+
 /*
 	Observe!
 	Now come the actualy decoding routines.
@@ -1000,6 +1119,205 @@ static int III_dequantize_sample(mpg123_handle *fr, real xr[SBLIMIT][SSLIMIT],in
 		}
 
 	}
+	else if(!(fr->p.flags & MPG123_PLAIN_HUFFMAN))
+	{
+		/*
+			decoding with 'long' BandIndex table (block_type != 2), using the lookup tables:
+			All big values are decoded to signed integers first, then requantized band by
+			band in a simple loop. Same results as the code below.
+		*/
+		const unsigned char *pretab = pretab_choice[gr_info->preflag];
+		int i,max = -1;
+		int cb = 0;
+		int *m = map[sfreq][2];
+		register real v = 0.0;
+		int mc = 0;
+		int bv = l[0]+l[1]+l[2];
+		int iq[SBLIMIT*SSLIMIT];
+		int *iqp = iq;
+
+		for(i=0;i<3;i++)
+		{
+			int lp = l[i];
+			const struct newhuff *h = ht+gr_info->table_select[i];
+			const unsigned short *lut = huff_lut[gr_info->table_select[i]];
+
+			for(;lp;lp--)
+			{
+				long x,y;
+				REFRESH_MASK;
+				y = lut[(unsigned long)mask>>BITSHIFT];
+				if(y & HUFF_LUT_SIGNS)
+				{
+					num -= (y >> 8) & 0xf;
+					mask <<= (y >> 8) & 0xf;
+					x = (y >> 4) & 0xf;
+					*iqp++ = y & HUFF_LUT_NEGX ? -x : x;
+					x = y & 0xf;
+					*iqp++ = y & HUFF_LUT_NEGY ? -x : x;
+					continue;
+				}
+				else if(y != HUFF_LUT_MISS)
+				{
+					num -= (y >> 8);
+					mask <<= (y >> 8);
+					x = (y >> 4) & 0xf;
+					y &= 0xf;
+				}
+				else
+				{
+					const short *val = h->table;
+#ifdef USE_NEW_HUFFTABLE
+					while((y=val[(unsigned long)mask>>(BITSHIFT+4)])<0)
+					{
+						val -= y;
+						num -= 4;
+						mask <<= 4;
+					}
+					num -= (y >> 8);
+					mask <<= (y >> 8);
+					x = (y >> 4) & 0xf;
+					y &= 0xf;
+#else
+					while((y=*val++)<0)
+					{
+						if (mask < 0) val -= y;
+
+						num--;
+						mask <<= 1;
+					}
+					x = y >> 4;
+					y &= 0xf;
+#endif
+				}
+
+				if(x == 15 && h->linbits)
+				{
+					REFRESH_MASK;
+					x += ((unsigned long) mask) >> (BITSHIFT+8-h->linbits);
+					num -= h->linbits+1;
+					mask <<= h->linbits;
+					*iqp++ = mask < 0 ? -x : x;
+					mask <<= 1;
+				}
+				else if(x)
+				{
+					*iqp++ = mask < 0 ? -x : x;
+					num--;
+					mask <<= 1;
+				}
+				else *iqp++ = 0;
+
+				if(y == 15 && h->linbits)
+				{
+					REFRESH_MASK;
+					y += ((unsigned long) mask) >> (BITSHIFT+8-h->linbits);
+					num -= h->linbits+1;
+					mask <<= h->linbits;
+					*iqp++ = mask < 0 ? -y : y;
+					mask <<= 1;
+				}
+				else if(y)
+				{
+					*iqp++ = mask < 0 ? -y : y;
+					num--;
+					mask <<= 1;
+				}
+				else *iqp++ = 0;
+			}
+		}
+
+		/* Requantization, leaving band state behind as the value loop would. */
+		for(iqp=iq; bv; )
+		{
+			int n, nz = 0;
+			if(!mc)
+			{
+				mc = *m++;
+				cb = *m++;
+#ifdef CUT_SFB21
+				if(cb == 21)
+					v = 0.0;
+				else
+#endif
+				{
+#ifdef REAL_IS_FIXED
+					gainpow2_scale_idx = (int)(gr_info->pow2gain + (*scf << shift) - fr->gainpow2);
+#endif
+					v = gr_info->pow2gain[(*(scf++) + (*pretab++)) << shift];
+				}
+			}
+			n = mc < bv ? mc : bv;
+			mc -= n;
+			bv -= n;
+			for(n*=2; n; n--)
+			{
+				int q = *iqp++;
+				real t = ispow[q < 0 ? -q : q];
+				*xrpnt++ = REAL_MUL_SCALE_LAYER3(q < 0 ? -t : t, v, gainpow2_scale_idx);
+				nz |= q;
+			}
+			if(nz) max = cb;
+		}
+
+		/* short (count1table) values */
+		for(;l3 && (part2remain+num > 0);l3--)
+		{
+			const unsigned char *lut = huff_lut_c[gr_info->count1table_select];
+			register short a;
+
+			REFRESH_MASK;
+			a = lut[(unsigned long)mask>>(BITSHIFT+2)];
+			num -= a >> 4;
+			mask <<= a >> 4;
+			a &= 0xf;
+			if(part2remain+num <= 0)
+			{
+				num -= part2remain+num;
+				break;
+			}
+
+			for(i=0;i<4;i++)
+			{
+				if(!(i & 1))
+				{
+					if(!mc)
+					{
+						mc = *m++;
+						cb = *m++;
+#ifdef CUT_SFB21
+						if(cb == 21)
+							v = 0.0;
+						else
+#endif
+						{
+#ifdef REAL_IS_FIXED
+							gainpow2_scale_idx = (int)(gr_info->pow2gain + (*scf << shift) - fr->gainpow2);
+#endif
+							v = gr_info->pow2gain[((*scf++) + (*pretab++)) << shift];
+						}
+					}
+					mc--;
+				}
+				if( (a & (0x8>>i)) )
+				{
+					max = cb;
+					if(part2remain+num <= 0)
+					break;
+
+					if(mask < 0) *xrpnt++ = -REAL_SCALE_LAYER3(v, gainpow2_scale_idx);
+					else         *xrpnt++ =  REAL_SCALE_LAYER3(v, gainpow2_scale_idx);
+
+					num--;
+					mask <<= 1;
+				}
+				else *xrpnt++ = DOUBLE_TO_REAL(0.0);
+			}
+		}
+
+		gr_info->maxbandl = max+1;
+		gr_info->maxb = fr->longLimit[sfreq][gr_info->maxbandl];
+	}
 	else
 	{
 		/* decoding with 'long' BandIndex table (block_type != 2) */
@@ -1368,7 +1686,29 @@ maybe still wrong??? (copy 12 to 13?) */
 }
 
 
-static void III_antialias(real xr[SBLIMIT][SSLIMIT],struct gr_info_s *gr_info)
+/* 31 alias-reduction operations between each pair of sub-bands */
+/* with 8 butterflies between each pair                         */
+void antialias(real *xr, int sblim)
+{
+	int sb;
+	real *xr1=xr+SSLIMIT;
+
+	for(sb=sblim; sb; sb--,xr1+=10)
+	{
+		int ss;
+		real *cs=aa_cs,*ca=aa_ca;
+		real *xr2 = xr1;
+
+		for(ss=7;ss>=0;ss--)
+		{ /* upper and lower butterfly inputs */
+			register real bu = *--xr2,bd = *xr1;
+			*xr2   = REAL_MUL(bu, *cs) - REAL_MUL(bd, *ca);
+			*xr1++ = REAL_MUL(bd, *cs++) + REAL_MUL(bu, *ca++);
+		}
+	}
+}
+
+static void III_antialias(mpg123_handle *fr, real xr[SBLIMIT][SSLIMIT],struct gr_info_s *gr_info)
 {
 	int sblim;
 
@@ -1380,27 +1720,7 @@ static void III_antialias(real xr[SBLIMIT][SSLIMIT],struct gr_info_s *gr_info)
 	}
 	else sblim = gr_info->maxb-1;
 
-	/* 31 alias-reduction operations between each pair of sub-bands */
-	/* with 8 butterflies between each pair                         */
-
-	{
-		int sb;
-		real *xr1=(real *) xr[1];
-
-		for(sb=sblim; sb; sb--,xr1+=10)
-		{
-			int ss;
-			real *cs=aa_cs,*ca=aa_ca;
-			real *xr2 = xr1;
-
-			for(ss=7;ss>=0;ss--)
-			{ /* upper and lower butterfly inputs */
-				register real bu = *--xr2,bd = *xr1;
-				*xr2   = REAL_MUL(bu, *cs) - REAL_MUL(bd, *ca);
-				*xr1++ = REAL_MUL(bd, *cs++) + REAL_MUL(bu, *ca++);
-			}
-		}
-	}
+	opt_antialias(fr)((real *) xr, sblim);
 }
 
 /* 
@@ -1928,6 +2248,9 @@ int do_layer3(mpg123_handle *fr)
 	int ms_stereo,i_stereo;
 	int sfreq = fr->sampling_frequency;
 	int stereo1,granules;
+#ifndef NO_THREADS
+	struct pipeline *pl = pipeline_use(fr);
+#endif
 
 	if(stereo == 1)
 	{ /* stream is mono */
@@ -1964,6 +2287,9 @@ int do_layer3(mpg123_handle *fr)
 		real (*hybridIn)[SBLIMIT][SSLIMIT] = fr->layer3.hybrid_in;
 		/*  hybridOut[2][SSLIMIT][SBLIMIT] */
 		real (*hybridOut)[SSLIMIT][SBLIMIT] = fr->layer3.hybrid_out;
+#ifndef NO_THREADS
+		if(pl != NULL) hybridOut = pipeline_slot(pl);
+#endif
 
 		{
 			struct gr_info_s *gr_info = &(sideinfo.ch[0].gr[gr]);
@@ -1976,7 +2302,7 @@ int do_layer3(mpg123_handle *fr)
 			if(III_dequantize_sample(fr, hybridIn[0], scalefacs[0],gr_info,sfreq,part2bits))
 			{
 				if(VERBOSE2) error("dequantization failed!");
-				return clip;
+				goto layer3_end;
 			}
 		}
 
@@ -1992,7 +2318,7 @@ int do_layer3(mpg123_handle *fr)
 			if(III_dequantize_sample(fr, hybridIn[1],scalefacs[1],gr_info,sfreq,part2bits))
 			{
 				if(VERBOSE2) error("dequantization failed!");
-				return clip;
+				goto layer3_end;
 			}
 
 			if(ms_stereo)
@@ -2044,12 +2370,28 @@ int do_layer3(mpg123_handle *fr)
 		for(ch=0;ch<stereo1;ch++)
 		{
 			struct gr_info_s *gr_info = &(sideinfo.ch[ch].gr[gr]);
-			III_antialias(hybridIn[ch],gr_info);
+			III_antialias(fr, hybridIn[ch],gr_info);
 			III_hybrid(hybridIn[ch], hybridOut[ch], ch,gr_info, fr);
 		}
+#ifndef NO_EQUALIZER
+		/* The equalizer gains for all time slots of the granule at once.
+		   A single channel to decode is in hybridOut[0], using the gains of the left one. */
+		if(fr->have_eq_settings)
+		for(ch=0;ch<stereo1;ch++)
+		opt_equalizer(fr)(hybridOut[ch][0], SSLIMIT, fr->equalizer[ch]);
+#endif
+
+#ifndef NO_THREADS
+		if(pl != NULL)
+		{
+			pipeline_push(pl, single == SINGLE_STEREO);
+			continue;
+		}
+#endif
 
 #ifdef OPT_I486
-		if(single != SINGLE_STEREO || fr->af.encoding != MPG123_ENC_SIGNED_16 || fr->down_sample != 0)
+		if(  single != SINGLE_STEREO || fr->af.encoding != MPG123_ENC_SIGNED_16 || fr->down_sample != 0
+		  || fr->buffer.plane )
 		{
 #endif
 		for(ss=0;ss<SSLIMIT;ss++)
@@ -2080,6 +2422,11 @@ int do_layer3(mpg123_handle *fr)
 		}
 #endif
 	}
-  
+
+layer3_end:
+#ifndef NO_THREADS
+	/* The frame is only done when the synth thread is. */
+	if(pl != NULL) clip += pipeline_sync(pl);
+#endif
 	return clip;
 }
@@ -8,10 +8,15 @@
 
 #include "mpg123lib_intern.h"
 #include "icy2utf8.h"
+#include "checkpoint.h"
 #include "debug.h"
 
 #include "gapless.h"
 
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
 #define SEEKFRAME(mh) ((mh)->ignoreframe < 0 ? 0 : (mh)->ignoreframe)
 
 static int initialized = 0;
@@ -239,6 +244,27 @@ int attribute_align_arg mpg123_par(mpg123_pars *mp, enum mpg123_parms key, long
 			else ret = MPG123_BAD_VALUE;
 #else
 			ret = MPG123_MISSING_FEATURE;
+#endif
+		break;
+		case MPG123_RESAMPLE:
+#ifdef SINC_RESAMPLE
+			if(val == MPG123_RESAMPLE_NTOM || val == MPG123_RESAMPLE_SINC)
+			mp->resample = (int)val;
+			else ret = MPG123_BAD_VALUE;
+#else
+			if(val != MPG123_RESAMPLE_NTOM) ret = MPG123_MISSING_FEATURE;
+#endif
+		break;
+		case MPG123_CHECKPOINTS:
+			if(val >= 0) mp->checkpoints = val;
+			else ret = MPG123_BAD_VALUE;
+		break;
+		case MPG123_READAHEAD:
+#ifndef NO_THREADS
+			if(val >= 0) mp->readahead = val;
+			else ret = MPG123_BAD_VALUE;
+#else
+			if(val != 0) ret = MPG123_MISSING_FEATURE;
 #endif
 		break;
 		default:
@@ -330,6 +356,20 @@ int attribute_align_arg mpg123_getpar(mpg123_pars *mp, enum mpg123_parms key, lo
 			ret = MPG123_MISSING_FEATURE;
 #endif
 		break;
+		case MPG123_RESAMPLE:
+			if(val)
+#ifdef SINC_RESAMPLE
+			*val = mp->resample;
+#else
+			*val = MPG123_RESAMPLE_NTOM;
+#endif
+		break;
+		case MPG123_CHECKPOINTS:
+			*val = mp->checkpoints;
+		break;
+		case MPG123_READAHEAD:
+			*val = mp->readahead;
+		break;
 		default:
 			ret = MPG123_BAD_PARAM;
 	}
@@ -600,6 +640,7 @@ static int get_next_frame(mpg123_handle *mh)
 		{
 			debug1("ignoring frame %li", (long)mh->num);
 			/* Decoder structure must be current! decode_update has been called before... */
+			checkpoint_save(mh);
 			(mh->do_layer)(mh); mh->buffer.fill = 0;
 #ifndef NO_NTOM
 			/* The ignored decoding may have failed. Make sure ntom stays consistent. */
@@ -688,6 +729,25 @@ static int zero_byte(mpg123_handle *fr)
 #endif
 }
 
+/* Silence for the given bytes of decoder output. Unsigned 24 bit comes straight
+   from the synth, without a conversion that would flip the zero bytes. */
+static void zero_fill(mpg123_handle *fr, unsigned char *dest, size_t bytes)
+{
+	if(fr->af.dec_enc == MPG123_ENC_UNSIGNED_24)
+	{
+		size_t i;
+		for(i=0; i+3 <= bytes; i+=3)
+		{
+#ifdef WORDS_BIGENDIAN
+			dest[i] = 0x80; dest[i+1] = 0; dest[i+2] = 0;
+#else
+			dest[i] = 0; dest[i+1] = 0; dest[i+2] = 0x80;
+#endif
+		}
+	}
+	else memset(dest, zero_byte(fr), bytes);
+}
+
 /*
 	Not part of the api. This just decodes the frame and fills missing bits with zeroes.
 	There can be frames that are broken and thus make do_layer() fail.
@@ -695,6 +755,9 @@ static int zero_byte(mpg123_handle *fr)
 static void decode_the_frame(mpg123_handle *fr)
 {
 	size_t needed_bytes = decoder_synth_bytes(fr, frame_expect_outsamples(fr));
+	/* The synth fills the channel planes up to their distance. */
+	fr->buffer.plane = fr->synth_stereo == synth_planar_stereo ? needed_bytes/2 : 0;
+	checkpoint_save(fr);
 	fr->clip += (fr->do_layer)(fr);
 	/*fprintf(stderr, "frame %"OFF_P": got %"SIZE_P" / %"SIZE_P"\n", fr->num,(size_p)fr->buffer.fill, (size_p)needed_bytes);*/
 	/* There could be less data than promised.
@@ -705,6 +768,7 @@ static void decode_the_frame(mpg123_handle *fr)
 #endif
 		if(fr->buffer.fill < needed_bytes)
 		{
+			fr->state_flags |= FRAME_DAMAGED;
 			if(VERBOSE2)
 			fprintf(stderr, "Note: broken frame %li, filling up with %"SIZE_P" zeroes, from %"SIZE_P"\n", (long)fr->num, (size_p)(needed_bytes-fr->buffer.fill), (size_p)fr->buffer.fill);
 
@@ -712,9 +776,18 @@ static void decode_the_frame(mpg123_handle *fr)
 				One could do a loop with individual samples instead... but zero is zero
 				Actually, that is wrong: zero is mostly a series of null bytes,
 				but we have funny 8bit formats that have a different opinion on zero...
-				Unsigned 16 or 32 bit formats are handled later.
+				Unsigned 16 or 32 bit formats are handled later, unsigned 24 bit
+				from the synth needs its own pattern.
 			*/
-			memset( fr->buffer.data + fr->buffer.fill, zero_byte(fr), needed_bytes - fr->buffer.fill );
+			if(fr->buffer.plane)
+			{
+				zero_fill( fr, fr->buffer.data + fr->buffer.fill/2
+				,	fr->buffer.plane - fr->buffer.fill/2 );
+				zero_fill( fr, fr->buffer.data + fr->buffer.plane + fr->buffer.fill/2
+				,	fr->buffer.plane - fr->buffer.fill/2 );
+			}
+			else
+			zero_fill( fr, fr->buffer.data + fr->buffer.fill, needed_bytes - fr->buffer.fill );
 
 			fr->buffer.fill = needed_bytes;
 #ifndef NO_NTOM
@@ -731,6 +804,57 @@ static void decode_the_frame(mpg123_handle *fr)
 	}
 #endif
 	postprocess_buffer(fr);
+	/* Full planes are back to back, also after conversion to another sample size. */
+	if(fr->buffer.plane) fr->buffer.plane = fr->buffer.fill/2;
+}
+
+/*
+	Copy decoded data to the caller's buffer of outsize bytes, behind the done bytes there.
+	Planar output goes to one half of the buffer per channel, each holding whole samples;
+	join_planes() closes the gap if the buffer does not get full. The half is kept for that,
+	as the format may have changed when the call is over.
+	Returns TRUE when there is no more space.
+*/
+static int copy_output(mpg123_handle *mh, unsigned char *out, size_t outsize, size_t *done)
+{
+	size_t a;
+	if(mh->buffer.plane)
+	{
+		size_t half, have = *done/2;
+		if(!mh->outhalf) mh->outhalf = outsize/(2*mh->af.encsize)*mh->af.encsize;
+		half = mh->outhalf;
+		a = mh->buffer.fill/2 > half-have ? half-have : mh->buffer.fill/2;
+		memcpy(out+have,      mh->buffer.p,                    a);
+		memcpy(out+half+have, mh->buffer.p+mh->buffer.plane, a);
+		mh->buffer.fill -= 2*a;
+		mh->buffer.p += a;
+		*done += 2*a;
+		return !(half > *done/2);
+	}
+	/* get what is needed - or just what is there */
+	a = mh->buffer.fill > outsize-*done ? outsize-*done : mh->buffer.fill;
+	debug4("buffer fill: %i; copying %i (%i - %li)", (int)mh->buffer.fill, (int)a, (int)outsize, (long)*done);
+	memcpy(out+*done, mh->buffer.p, a);
+	/* less data in frame buffer, more data given... */
+	mh->buffer.fill -= a;
+	mh->buffer.p += a;
+	*done += a;
+	return !(outsize > *done);
+}
+
+/* Move the second channel of planar output from the middle of the caller's buffer right behind the first. */
+static void join_planes(mpg123_handle *mh, unsigned char *out, size_t done)
+{
+	if(done/2 < mh->outhalf) memmove(out+done/2, out+mh->outhalf, done/2);
+	mh->outhalf = 0;
+}
+
+/* mpg123_decode_frame() hands out the planes of a frame back to back. */
+static void join_frame_planes(mpg123_handle *mh)
+{
+	if(mh->buffer.plane > mh->buffer.fill/2)
+	memmove(mh->buffer.p + mh->buffer.fill/2, mh->buffer.p + mh->buffer.plane, mh->buffer.fill/2);
+	if(mh->buffer.plane) mh->buffer.plane = mh->buffer.fill/2;
 }
 
 /*
@@ -762,6 +886,7 @@ int attribute_align_arg mpg123_framebyframe_decode(mpg123_handle *mh, off_t *num
 	mh->to_decode = mh->to_ignore = FALSE;
 	mh->buffer.p = mh->buffer.data;
 	FRAME_BUFFERCHECK(mh);
+	join_frame_planes(mh);
 	*audio = mh->buffer.p;
 	*bytes = mh->buffer.fill;
 	return MPG123_OK;
@@ -839,6 +964,7 @@ int attribute_align_arg mpg123_decode_frame(mpg123_handle *mh, off_t *num, unsig
 			mh->to_decode = mh->to_ignore = FALSE;
 			mh->buffer.p = mh->buffer.data;
 			FRAME_BUFFERCHECK(mh);
+			join_frame_planes(mh);
 			if(audio != NULL) *audio = mh->buffer.p;
 			if(bytes != NULL) *bytes = mh->buffer.fill;
 
@@ -889,6 +1015,36 @@ int attribute_align_arg mpg123_feed(mpg123_handle *mh, const unsigned char *in,
 #endif
 }
 
+int attribute_align_arg mpg123_feed_lent( mpg123_handle *mh
+,	const unsigned char *in, size_t size
+,	void (*release)(void *, const unsigned char *, size_t), void *handle )
+{
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+#ifndef NO_FEEDER
+	if(in == NULL)
+	{
+		mh->err = MPG123_NULL_BUFFER;
+		return MPG123_ERR;
+	}
+	if(size == 0)
+	{ /* Nothing to keep. */
+		if(release != NULL) release(handle, in, size);
+		return MPG123_OK;
+	}
+	if(feed_lend(mh, in, size, release, handle) != 0)
+	{
+		mh->err = MPG123_OUT_OF_MEM;
+		return MPG123_ERR;
+	}
+	if(mh->err == MPG123_ERR_READER) mh->err = MPG123_OK;
+
+	return MPG123_OK;
+#else
+	mh->err = MPG123_MISSING_FEATURE;
+	return MPG123_ERR;
+#endif
+}
+
 /*
 	The old picture:
 	while(1) {
@@ -945,16 +1101,7 @@ int attribute_align_arg mpg123_decode(mpg123_handle *mh, const unsigned char *in
 		}
 		if(mh->buffer.fill) /* Copy (part of) the decoded data to the caller's buffer. */
 		{
-			/* get what is needed - or just what is there */
-			int a = mh->buffer.fill > (outmemsize - mdone) ? outmemsize - mdone : mh->buffer.fill;
-			debug4("buffer fill: %i; copying %i (%i - %li)", (int)mh->buffer.fill, a, (int)outmemsize, (long)mdone);
-			memcpy(outmemory, mh->buffer.p, a);
-			/* less data in frame buffer, less needed, output pointer increase, more data given... */
-			mh->buffer.fill -= a;
-			outmemory  += a;
-			mdone += a;
-			mh->buffer.p += a;
-			if(!(outmemsize > mdone)) goto decodeend;
+			if(copy_output(mh, outmemory, outmemsize, &mdone)) goto decodeend;
 		}
 		else /* If we didn't have data, get a new frame. */
 		{
@@ -963,6 +1110,7 @@ int attribute_align_arg mpg123_decode(mpg123_handle *mh, const unsigned char *in
 		}
 	}
 decodeend:
+	join_planes(mh, outmemory, mdone);
 	if(done != NULL) *done = mdone;
 	return ret;
 #else
@@ -1119,6 +1267,7 @@ static int do_the_seek(mpg123_handle *mh)
 {
 	int b;
 	off_t fnum = SEEKFRAME(mh);
+	off_t cp;
 	mh->buffer.fill = 0;
 
 	/* If we are inside the ignoreframe - firstframe window, we may get away without actual seeking. */
@@ -1139,6 +1288,13 @@ static int do_the_seek(mpg123_handle *mh)
 
 	/* OK, real seeking follows... clear buffers and go for it. */
 	frame_buffers_reset(mh);
+	/* A decoder state snapshot spares the decoding of frames in advance. */
+	cp = checkpoint_find(mh, mh->firstframe);
+	if(cp >= 0)
+	{
+		fnum = cp;
+		mh->ignoreframe = cp;
+	}
 #ifndef NO_NTOM
 	if(mh->down_sample == 3)
 	{
@@ -1154,6 +1310,7 @@ static int do_the_seek(mpg123_handle *mh)
 	}
 	debug1("seek_frame returned: %i", b);
 	if(b<0) return b;
+	checkpoint_restore(mh, cp);
 	/* Only mh->to_ignore is TRUE. */
 	if(mh->num < mh->firstframe) mh->to_decode = FALSE;
 
@@ -1392,11 +1549,16 @@ int attribute_align_arg mpg123_scan(mpg123_handle *mh)
 	debug("TODO: We should disable gapless code when encountering inconsistent mh->spf!");
 	debug("      ... at least unset MPG123_ACCURATE.");
 	/* Do not increment mh->track_frames in the loop as tha would confuse Frankenstein detection. */
+	/* Only headers are needed, read_frame() skips the bodies. */
+	mh->state_flags |= FRAME_SCANNING;
 	while(read_frame(mh) == 1)
 	{
 		++track_frames;
 		track_samples += mh->spf;
 	}
+	mh->state_flags &= ~FRAME_SCANNING;
+	/* Read the last frames for real, in case the seek back ends up right there. */
+	if(mh->rd->seek_frame(mh, mh->num) < 0) return MPG123_ERR;
 	mh->track_frames = track_frames;
 	mh->track_samples = track_samples;
 	debug2("Scanning yielded %"OFF_P" track samples, %"OFF_P" frames.", (off_p)mh->track_samples, (off_p)mh->track_frames);
@@ -1407,6 +1569,782 @@ int attribute_align_arg mpg123_scan(mpg123_handle *mh)
 	return mpg123_seek(mh, oldpos, SEEK_SET) >= 0 ? MPG123_OK : MPG123_ERR;
 }
 
+/*
+	Frame-parallel decoding of a whole track.
+
+	The track is cut into frame ranges at index positions. The first range is
+	decoded by the handle itself, just like mpg123_read() does. The others go to
+	worker handles in feeder mode, which start some frames before their range
+	(the prime frames) to have bit reservoir, layer 3 overlap and synth buffer in
+	the same state as in serial decoding when the first wanted frame arrives.
+	Output of the prime frames is discarded, the rest lands at its final place
+	in the caller's buffer, with gapless trimming applied on the way.
+	That only works for the frame sequence the scan found. A worker that hits
+	skipped junk (resync), a format change, prime frames that do not decode or
+	frames at other input offsets than the ones of serial decoding at its range
+	boundaries aborts the whole thing, which then is decoded serially.
+*/
+
+#if !defined(NO_THREADS) && !defined(NO_FEEDER) && defined(FRAME_INDEX)
+
+/* Minimal number of frames in a range, to keep the priming overhead low. */
+#define PARALLEL_MIN_FRAMES 512
+/* Ranges per thread, for some load balancing. */
+#define PARALLEL_RANGES 4
+/* Range and prime starts are multiples of this, keeping the synth buffer offset (fr->bo) in phase. */
+#define PARALLEL_ALIGN 8
+/* Largest layer 3 frame with standard bitrates (320 kbps at 32 kHz or 160 kbps at 8 kHz, plus padding). */
+#define PARALLEL_MAX_L3FRAME 1441
+/* Per-frame overhead that does not count into the bit reservoir: header, side info, CRC. */
+#define PARALLEL_L3OVERHEAD (4+32+2)
+/* Input is fed to the workers in chunks of that size. */
+#define PARALLEL_CHUNK 16384
+
+struct parallel_range
+{
+	off_t prime; /* frame to start decoding at */
+	off_t begin; /* first frame with wanted output */
+	off_t end;   /* frame after the range */
+	/* Input offsets of the prime and begin frames, relative to the job buffer. */
+	size_t inprime;
+	size_t inbegin;
+};
+
+struct parallel_job
+{
+	mpg123_handle *mh;
+	pthread_mutex_t lock;
+	struct parallel_range *ranges;
+	size_t count;
+	size_t next;
+	unsigned char *in;
+	size_t insize;
+	unsigned char *out;
+	off_t outsamples; /* maximum output samples that fit into out */
+	off_t spf;        /* output samples per frame */
+	size_t samplebytes;
+	struct audioformat af; /* output format of the handle at the start */
+	int err;
+	int serial; /* A range does not match serial decoding, do it all serially. */
+};
+
+struct parallel_worker
+{
+	struct parallel_job *job;
+	mpg123_handle *wh;
+	pthread_t thread;
+};
+
+static void parallel_fail(struct parallel_job *job, int err)
+{
+	pthread_mutex_lock(&job->lock);
+	if(job->err == MPG123_OK) job->err = err;
+	pthread_mutex_unlock(&job->lock);
+}
+
+static void parallel_serial(struct parallel_job *job)
+{
+	pthread_mutex_lock(&job->lock);
+	job->serial = TRUE;
+	pthread_mutex_unlock(&job->lock);
+}
+
+static struct parallel_range *parallel_next(struct parallel_job *job)
+{
+	struct parallel_range *r = NULL;
+	pthread_mutex_lock(&job->lock);
+	if(job->err == MPG123_OK && !job->serial && job->next < job->count)
+	r = &job->ranges[job->next++];
+	pthread_mutex_unlock(&job->lock);
+	return r;
+}
+
+/* Copy the decoder samples [from, to) of a frame starting at sample x to their output position. */
+static void parallel_store( struct parallel_job *job, off_t x
+,	unsigned char *audio, off_t from, off_t to )
+{
+	off_t pos;
+	if(from >= to) return;
+	/* The gapless offsets are settled by the scan, SAMPLE_ADJUST() does only read them. */
+	pos = SAMPLE_ADJUST(job->mh, from);
+	if(pos >= job->outsamples) return;
+	if(to-from > job->outsamples-pos) to = from + job->outsamples - pos;
+	memcpy( job->out + pos*job->samplebytes, audio + (from-x)*job->samplebytes
+	,	(to-from)*job->samplebytes );
+}
+
+/* Sort the samples of one frame into the output, skipping what gapless decoding skips. */
+static void parallel_output(struct parallel_job *job, off_t frame, unsigned char *audio, size_t bytes)
+{
+	mpg123_handle *mh = job->mh;
+	off_t x = frame*job->spf;
+	off_t n = bytes/job->samplebytes;
+#ifdef GAPLESS
+	if(mh->p.flags & MPG123_GAPLESS && mh->gapless_frames > 0)
+	{
+		/* The planned track, and anything after the padding (see frame_buffercheck()). */
+		parallel_store( job, x, audio
+		,	x > mh->begin_os ? x : mh->begin_os, x+n < mh->end_os ? x+n : mh->end_os );
+		parallel_store(job, x, audio, x > mh->fullend_os ? x : mh->fullend_os, x+n);
+	}
+	else
+#endif
+	parallel_store(job, x, audio, x, x+n);
+}
+
+static int parallel_same_format(struct parallel_job *job, mpg123_handle *fr)
+{
+	return fr->af.rate == job->af.rate && fr->af.channels == job->af.channels
+	&&     fr->af.encoding == job->af.encoding;
+}
+
+/*
+	Decode a range with a worker handle. Returns an error code or MPG123_OK,
+	which includes the case of a range that does not match serial decoding,
+	with job->serial set.
+*/
+static int parallel_decode_range(struct parallel_job *job, mpg123_handle *wh, struct parallel_range *r)
+{
+	mpg123_handle *mh = job->mh;
+	size_t inpos = r->inprime;
+	off_t last = r->end - r->prime - 1; /* last frame number for the worker */
+	off_t num = -1;
+	off_t next = 0; /* input offset of the next frame for a stream without gaps */
+
+	if(SAMPLE_ADJUST(mh, r->begin*job->spf) >= job->outsamples) return MPG123_OK;
+	if(mpg123_open_feed(wh) != MPG123_OK) return wh->err;
+	/* Volume adjustment from tags the worker does not get to see. */
+	wh->rva = mh->rva;
+	while(num < last)
+	{
+		unsigned char *audio;
+		size_t bytes;
+		int ret = mpg123_decode_frame(wh, &num, &audio, &bytes);
+		if(ret == MPG123_NEED_MORE)
+		{
+			size_t chunk = job->insize - inpos;
+			if(chunk == 0) break; /* Track ends early, as it does for serial decoding. */
+			if(chunk > PARALLEL_CHUNK) chunk = PARALLEL_CHUNK;
+			if(mpg123_feed(wh, job->in+inpos, chunk) != MPG123_OK) return wh->err;
+			inpos += chunk;
+		}
+		else if(ret == MPG123_NEW_FORMAT)
+		{
+			if(!parallel_same_format(job, wh)) goto parallel_range_serial;
+		}
+		else if(ret == MPG123_OK)
+		{
+			/* After a resync or a big change of the stream, the serial decoder state
+			   may differ. So it may after prime frames that did not decode.
+			   The first wanted frame has to be where the scan found it. */
+			if(  wh->input_offset != next || (wh->state_flags & FRAME_FRANKENSTEIN)
+			  || (r->prime+num < r->begin && (wh->state_flags & FRAME_DAMAGED))
+			  || (r->prime+num == r->begin && r->inprime+next != r->inbegin) )
+			goto parallel_range_serial;
+			next = wh->input_offset + wh->framesize + 4;
+			if(r->prime+num >= r->begin) parallel_output(job, r->prime+num, audio, bytes);
+		}
+		else goto parallel_range_serial; /* Let the serial decoder deal with that. */
+	}
+	/* The next range starts right after this one, as far as the scan is concerned. */
+	if(r+1 < job->ranges+job->count && r->inprime+next != r[1].inbegin)
+	goto parallel_range_serial;
+
+	return MPG123_OK;
+parallel_range_serial:
+	parallel_serial(job);
+	return MPG123_OK;
+}
+
+static void *parallel_work(void *arg)
+{
+	struct parallel_worker *w = arg;
+	struct parallel_range *r;
+	while((r = parallel_next(w->job)) != NULL)
+	{
+		int err = parallel_decode_range(w->job, w->wh, r);
+		if(err != MPG123_OK) parallel_fail(w->job, err);
+	}
+	return NULL;
+}
+
+/* Find an index entry at or before the given frame that is a multiple of PARALLEL_ALIGN.
+   Returns the entry number or -1. */
+static long parallel_entry(struct frame_index *fi, off_t frame)
+{
+	long i = (long)(frame/fi->step);
+	if(i >= (long)fi->fill) i = (long)fi->fill-1;
+	for(; i >= 0; --i)
+	if((i*fi->step) % PARALLEL_ALIGN == 0) return i;
+
+	return -1;
+}
+
+/* Decide on the ranges, from the scanned index. Returns the number of ranges (may be just 1). */
+static size_t parallel_ranges( mpg123_handle *mh, int threads
+,	struct parallel_range **ranges, off_t *inbase )
+{
+	struct frame_index *fi = &mh->index;
+	struct parallel_range *rl;
+	size_t count = 0;
+	off_t total = mh->track_frames;
+	off_t len = total/((off_t)threads*PARALLEL_RANGES);
+	off_t prime_min = mh->p.preframes > 2 ? mh->p.preframes : 2;
+	off_t start = 0; /* The serial decoder may skip frames at the beginning. */
+	off_t frame = 0;
+
+	*ranges = NULL;
+	*inbase = 0;
+	if(fi->fill < 2) return 1;
+	/* Priming a range needs some index entries anyway. */
+	if(len < PARALLEL_MIN_FRAMES) len = PARALLEL_MIN_FRAMES;
+	if(len < 4*PARALLEL_ALIGN*fi->step) len = 4*PARALLEL_ALIGN*fi->step;
+#ifdef GAPLESS
+	if(mh->p.flags & MPG123_GAPLESS && mh->gapless_frames > 0)
+	start = frame_offset(mh, mh->begin_os);
+#endif
+	rl = malloc(sizeof(*rl)*(total/len+2));
+	if(rl == NULL) return 1;
+
+	rl[0].prime = rl[0].begin = 0;
+	rl[0].inprime = rl[0].inbegin = 0;
+	count = 1;
+	while((frame += len) < total)
+	{
+		long b, p;
+		off_t pframe;
+		b = parallel_entry(fi, frame);
+		if(b < 0 || b*fi->step <= rl[count-1].begin) continue;
+		/* Walk back to a prime frame that gives a full bit reservoir for the frame before the range. */
+		for(p = b-1; (p = parallel_entry(fi, p*fi->step)) >= 0; --p)
+		{
+			off_t n = (b-p)*fi->step;
+			if(n < prime_min) continue;
+			if(mh->lay != 3) break;
+			if(  fi->data[b] - fi->data[p] - n*PARALLEL_L3OVERHEAD
+			   - (mh->freeformat ? MAXFRAMESIZE : PARALLEL_MAX_L3FRAME) >= 511 )
+			break;
+		}
+		if(p < 0 || (pframe = p*fi->step) < start) continue;
+
+		rl[count].prime = pframe;
+		rl[count].begin = b*fi->step;
+		rl[count].inprime = (size_t)(fi->data[p]);
+		rl[count].inbegin = (size_t)(fi->data[b]);
+		rl[count-1].end = rl[count].begin;
+		++count;
+	}
+	rl[count-1].end = total;
+	if(count > 1)
+	{
+		size_t i;
+		/* Input offsets relative to the prime of the first worker range, which is the minimum. */
+		*inbase = (off_t)rl[1].inprime;
+		for(i=1; i<count; ++i)
+		{
+			rl[i].inprime -= (size_t)*inbase;
+			rl[i].inbegin -= (size_t)*inbase;
+		}
+		*ranges = rl;
+	}
+	else free(rl);
+
+	return count;
+}
+
+/* Read the stream from the given offset into memory, up to limit bytes or the end
+   for limit == 0. The reader position is restored afterwards. */
+static unsigned char *parallel_input(mpg123_handle *mh, off_t base, size_t limit, size_t *size)
+{
+	unsigned char *in = NULL;
+	size_t fill = 0;
+	size_t bufsize = 0;
+	ssize_t got = 0;
+	off_t oldpos = mh->rd->tell(mh);
+
+	if(mh->rd->skip_bytes(mh, base - oldpos) != base) return NULL;
+	do
+	{
+		if(fill == bufsize)
+		{
+			unsigned char *nin;
+			bufsize = bufsize ? 2*bufsize : 1024*1024;
+			if(mh->rdat.filelen > base && (off_t)bufsize < mh->rdat.filelen - base)
+			bufsize = (size_t)(mh->rdat.filelen - base);
+			if(limit && bufsize > limit) bufsize = limit;
+			nin = safe_realloc(in, bufsize);
+			if(nin == NULL){ mh->err = MPG123_OUT_OF_MEM; got = -1; break; }
+			in = nin;
+		}
+		got = mh->rd->fullread(mh, in+fill, (ssize_t)(bufsize-fill));
+		if(got > 0) fill += got;
+	} while(got > 0 && fill != limit);
+	if(mh->rd->skip_bytes(mh, oldpos - mh->rd->tell(mh)) != oldpos || got < 0)
+	{
+		free(in);
+		return NULL;
+	}
+	*size = fill;
+	return in;
+}
+
+/* Decode the first range serially with the handle itself, the others with workers.
+   Sets *serial if that did not work out and it all has to be decoded serially. */
+static int parallel_decode( mpg123_handle *mh, int threads
+,	struct parallel_range *ranges, size_t count, off_t inbase
+,	unsigned char *out, off_t outsamples, size_t *done, int *serial )
+{
+	struct parallel_job job;
+	struct parallel_worker *workers = NULL;
+	size_t inlimit = 0;
+	int started = 0;
+	int ret = MPG123_OK;
+	int i;
+
+	job.mh = mh;
+	job.ranges = ranges;
+	job.count = count;
+	job.next = 1;
+	job.out = out;
+	job.outsamples = outsamples;
+	job.spf = frame_outs(mh, 1);
+	job.samplebytes = samples_to_bytes(mh, 1);
+	job.insize = 0;
+	job.af = mh->af;
+	job.err = MPG123_OK;
+	job.serial = FALSE;
+
+	/* Ranges past the end of the output buffer are skipped, so is their input.
+	   The last one to decode needs input up to the beginning of the next. */
+	for(i=0; i<(int)count-1; ++i)
+	if(SAMPLE_ADJUST(mh, ranges[i+1].begin*job.spf) >= outsamples)
+	{
+		inlimit = ranges[i+1].inbegin;
+		break;
+	}
+	if(threads > (int)count) threads = (int)count;
+	workers = malloc(sizeof(*workers)*threads);
+	job.in = parallel_input(mh, inbase, inlimit, &job.insize);
+	if(workers == NULL || job.in == NULL)
+	{
+		if(mh->err == MPG123_OK) mh->err = MPG123_OUT_OF_MEM;
+		ret = MPG123_ERR;
+		goto parallel_end;
+	}
+	for(i=0; i<threads; ++i)
+	{
+		int err;
+		workers[i].job = &job;
+		workers[i].wh  = mpg123_parnew(&mh->p, mpg123_current_decoder(mh), &err);
+		if(workers[i].wh == NULL)
+		{
+			for(--i; i>=0; --i) mpg123_delete(workers[i].wh);
+			mh->err = err;
+			ret = MPG123_ERR;
+			goto parallel_end;
+		}
+		workers[i].wh->p.flags &= ~MPG123_GAPLESS;
+		workers[i].wh->p.checkpoints = 0;
+		workers[i].wh->p.flags |= MPG123_QUIET|MPG123_IGNORE_INFOFRAME;
+		workers[i].wh->p.verbose = 0;
+		workers[i].wh->have_eq_settings = mh->have_eq_settings;
+		memcpy(workers[i].wh->equalizer, mh->equalizer, sizeof(mh->equalizer));
+	}
+	if(pthread_mutex_init(&job.lock, NULL))
+	{
+		for(i=0; i<threads; ++i) mpg123_delete(workers[i].wh);
+		mh->err = MPG123_BAD_DECODER_SETUP;
+		ret = MPG123_ERR;
+		goto parallel_end;
+	}
+	/* Worker 0 is the calling thread, after it decoded the first range itself. */
+	for(started=1; started<threads; ++started)
+	if(pthread_create(&workers[started].thread, NULL, parallel_work, &workers[started]))
+	break;
+
+	if(mpg123_seek(mh, 0, SEEK_SET) < 0) parallel_fail(&job, mh->err);
+	else
+	{
+		off_t first = SAMPLE_ADJUST(mh, frame_outs(mh, ranges[0].end));
+		size_t want = samples_to_bytes(mh, first < outsamples ? first : outsamples);
+		while(*done < want)
+		{
+			size_t got = 0;
+			ret = mpg123_read(mh, out+*done, want-*done, &got);
+			*done += got;
+			if(ret == MPG123_NEW_FORMAT && !parallel_same_format(&job, mh))
+			{
+				parallel_serial(&job);
+				ret = MPG123_OK;
+				break;
+			}
+			if(ret != MPG123_OK && ret != MPG123_NEW_FORMAT) break;
+		}
+		if(ret != MPG123_OK && ret != MPG123_DONE) parallel_fail(&job, mh->err);
+		ret = MPG123_OK;
+	}
+	parallel_work(&workers[0]);
+
+	for(i=1; i<started; ++i) pthread_join(workers[i].thread, NULL);
+	for(i=0; i<threads; ++i) mpg123_delete(workers[i].wh);
+	pthread_mutex_destroy(&job.lock);
+	if(job.err != MPG123_OK)
+	{
+		mh->err = job.err;
+		ret = MPG123_ERR;
+	}
+	else if(job.serial)
+	{
+		*done = 0;
+		*serial = TRUE;
+	}
+	else *done = samples_to_bytes(mh, outsamples);
+
+parallel_end:
+	if(job.in != NULL) free(job.in);
+	if(workers != NULL) free(workers);
+	return ret;
+}
+
+#endif
+
+int attribute_align_arg mpg123_decode_parallel(mpg123_handle *mh, int threads, unsigned char *outmemory, size_t outmemsize, size_t *done)
+{
+	int ret = MPG123_OK;
+	int serial = TRUE;
+	off_t oldpos, length;
+	size_t mdone = 0;
+
+	if(done != NULL) *done = 0;
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+	if(outmemory == NULL && outmemsize > 0)
+	{
+		mh->err = MPG123_NULL_BUFFER;
+		return MPG123_ERR;
+	}
+	if(mpg123_scan(mh) != MPG123_OK) return MPG123_ERR;
+	if(track_need_init(mh)) return MPG123_DONE;
+	/* The output is sorted together from pieces of whole frames, interleaved. */
+	if(mh->synth_stereo == synth_planar_stereo)
+	{
+		mh->err = MPG123_BAD_PARAM;
+		return MPG123_ERR;
+	}
+
+	oldpos = mpg123_tell(mh);
+	length = mpg123_length(mh);
+	if(length < 0) return MPG123_ERR;
+	if(length > (off_t)(outmemsize/samples_to_bytes(mh, 1)))
+	length = (off_t)(outmemsize/samples_to_bytes(mh, 1));
+
+#if !defined(NO_THREADS) && !defined(NO_FEEDER) && defined(FRAME_INDEX)
+	/* Only share work where a worker can reproduce the serial decoder state. */
+	if(  threads > 1 && mh->down_sample < 3 && mh->p.halfspeed == 0 && mh->p.doublespeed == 0
+	  && mh->track_samples == mh->track_frames*mh->spf
+#ifdef OPT_DITHER
+	  && mh->cpu_opts.type != generic_dither && mh->cpu_opts.type != ifuenf_dither
+	  && mh->cpu_opts.type != x86_64_dither
+#endif
+#ifdef OPT_I486
+	  && mh->cpu_opts.type != ivier
+#endif
+	  && !(mh->state_flags & FRAME_FRANKENSTEIN) )
+	{
+		struct parallel_range *ranges;
+		off_t inbase;
+		size_t count = parallel_ranges(mh, threads, &ranges, &inbase);
+		if(count > 1)
+		{
+			serial = FALSE;
+			ret = parallel_decode(mh, threads, ranges, count, inbase, outmemory, length, &mdone, &serial);
+			free(ranges);
+		}
+	}
+#endif
+	if(serial)
+	{ /* The plain mpg123_read() loop. */
+		size_t want = samples_to_bytes(mh, length);
+		ret = mpg123_seek(mh, 0, SEEK_SET) < 0 ? MPG123_ERR : MPG123_OK;
+		while(ret == MPG123_OK && mdone < want)
+		{
+			size_t got = 0;
+			ret = mpg123_read(mh, outmemory+mdone, want-mdone, &got);
+			mdone += got;
+			if(ret == MPG123_NEW_FORMAT) ret = MPG123_OK;
+		}
+		if(ret == MPG123_DONE) ret = MPG123_OK;
+	}
+	if(done != NULL) *done = mdone;
+	if(ret != MPG123_OK) return ret;
+
+	return mpg123_seek(mh, oldpos, SEEK_SET) >= 0 ? MPG123_OK : MPG123_ERR;
+}
+
+#ifndef NO_FEEDER
+/*
+	One turn of mpg123_decode() for a batch job: deliver at most one decoded frame.
+	Returns TRUE if the job wants another turn, FALSE if it is finished with job->err set.
+*/
+static int batch_step(struct mpg123_batch *job)
+{
+	mpg123_handle *mh = job->mh;
+	int decoded = FALSE;
+
+	while(1)
+	{
+		if(mh->to_decode)
+		{
+			if(decoded) return TRUE; /* That one is for the next turn. */
+			if(mh->new_format)
+			{
+				mh->new_format = 0;
+				job->err = MPG123_NEW_FORMAT;
+				return FALSE;
+			}
+			if(mh->buffer.size - mh->buffer.fill < mh->outblock)
+			{
+				job->err = MPG123_NO_SPACE;
+				return FALSE;
+			}
+			decode_the_frame(mh);
+			mh->to_decode = mh->to_ignore = FALSE;
+			mh->buffer.p = mh->buffer.data;
+			FRAME_BUFFERCHECK(mh);
+			decoded = TRUE;
+		}
+		if(mh->buffer.fill)
+		{
+			if(copy_output(mh, job->outmemory, job->outmemsize, &job->done))
+			{
+				job->err = MPG123_OK;
+				return FALSE;
+			}
+		}
+		else
+		{
+			int b;
+			if(decoded) return TRUE;
+			b = get_next_frame(mh);
+			if(b < 0)
+			{
+				job->err = b;
+				return FALSE;
+			}
+		}
+	}
+}
+
+/* Set up a job like mpg123_decode() does before its loop. Returns TRUE if there is decoding to do. */
+static int batch_prepare(struct mpg123_batch *job)
+{
+	job->done = 0;
+	job->err = MPG123_OK;
+	if(job->inmemsize > 0 && mpg123_feed(job->mh, job->inmemory, job->inmemsize) != MPG123_OK)
+	{
+		job->err = MPG123_ERR;
+		return FALSE;
+	}
+	if(job->outmemory == NULL) job->outmemsize = 0;
+	return TRUE;
+}
+
+/* Round-robin over the jobs listed in the queue, dropping finished ones. */
+static void batch_serial(struct mpg123_batch *jobs, size_t *queue, size_t count)
+{
+	while(count)
+	{
+		size_t i = 0;
+		while(i < count)
+		{
+			if(batch_step(jobs+queue[i])) ++i;
+			else queue[i] = queue[--count];
+		}
+	}
+}
+
+#ifndef NO_THREADS
+/*
+	Work stealing: Each worker has its own queue of job indices (a ring in a slice of one
+	array), protected by its own lock. It takes the first job, does one step, and appends it
+	again if unfinished. An empty worker takes half of the waiting jobs of another one.
+	Only one lock is held at any time. A worker quits when no other queue has waiting jobs;
+	the jobs in progress elsewhere then are the last ones of their workers, anyway.
+*/
+#define BATCH_LOOT 64
+
+struct batch_worker
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	struct mpg123_batch *jobs;
+	struct batch_worker *all;
+	size_t *queue; /* room for all jobs */
+	size_t first;
+	size_t fill;
+	size_t size;
+	int index;
+	int count;
+};
+
+static void batch_push(struct batch_worker *w, size_t job)
+{
+	w->queue[(w->first+w->fill++) % w->size] = job;
+}
+
+static size_t batch_pop(struct batch_worker *w)
+{
+	size_t job = w->queue[w->first];
+	w->first = (w->first+1) % w->size;
+	--w->fill;
+	return job;
+}
+
+static size_t batch_steal(struct batch_worker *w)
+{
+	int v;
+	size_t stolen = 0;
+	for(v=1; v<w->count && !stolen; ++v)
+	{
+		struct batch_worker *victim = w->all + (w->index+v) % w->count;
+		size_t loot[BATCH_LOOT];
+		size_t i;
+
+		pthread_mutex_lock(&victim->lock);
+		stolen = (victim->fill+1)/2;
+		if(stolen > BATCH_LOOT) stolen = BATCH_LOOT;
+		/* Take from the end, the victim continues at the front. */
+		for(i=0; i<stolen; ++i)
+		loot[i] = victim->queue[(victim->first + --victim->fill) % victim->size];
+		pthread_mutex_unlock(&victim->lock);
+
+		if(stolen)
+		{
+			pthread_mutex_lock(&w->lock);
+			for(i=0; i<stolen; ++i) batch_push(w, loot[i]);
+			pthread_mutex_unlock(&w->lock);
+		}
+	}
+	return stolen;
+}
+
+static void *batch_work(void *arg)
+{
+	struct batch_worker *w = arg;
+
+	while(1)
+	{
+		size_t job;
+		pthread_mutex_lock(&w->lock);
+		if(!w->fill)
+		{
+			pthread_mutex_unlock(&w->lock);
+			if(batch_steal(w)) continue;
+			else break;
+		}
+		job = batch_pop(w);
+		pthread_mutex_unlock(&w->lock);
+
+		if(batch_step(w->jobs+job))
+		{
+			pthread_mutex_lock(&w->lock);
+			batch_push(w, job);
+			pthread_mutex_unlock(&w->lock);
+		}
+	}
+	return NULL;
+}
+
+/* Returns FALSE if the threaded variant could not be started at all. */
+static int batch_threaded(struct mpg123_batch *jobs, size_t *queue, size_t count, int threads)
+{
+	struct batch_worker *workers;
+	size_t *queues;
+	int i, started;
+
+	workers = malloc(sizeof(*workers)*threads);
+	queues  = malloc(sizeof(*queues)*threads*count);
+	if(workers == NULL || queues == NULL)
+	{
+		if(workers != NULL) free(workers);
+		if(queues  != NULL) free(queues);
+		return FALSE;
+	}
+	for(i=0; i<threads; ++i)
+	{
+		size_t j;
+		struct batch_worker *w = workers+i;
+		w->jobs  = jobs;
+		w->all   = workers;
+		w->queue = queues+i*count;
+		w->first = 0;
+		w->fill  = 0;
+		w->size  = count;
+		w->index = i;
+		w->count = threads;
+		for(j=i; j<count; j+=threads) batch_push(w, queue[j]);
+		pthread_mutex_init(&w->lock, NULL);
+	}
+	/* The calling thread is worker 0. Jobs of workers that fail to start get stolen,
+	   as nobody quits before all other queues are empty. */
+	for(started=1; started<threads; ++started)
+	if(pthread_create(&workers[started].thread, NULL, batch_work, workers+started))
+	break;
+
+	batch_work(workers);
+	for(i=1; i<started; ++i) pthread_join(workers[i].thread, NULL);
+	for(i=0; i<threads; ++i) pthread_mutex_destroy(&workers[i].lock);
+	free(queues);
+	free(workers);
+	return TRUE;
+}
+#endif
+#endif
+
+int attribute_align_arg mpg123_decode_batch(struct mpg123_batch *jobs, size_t count, int threads)
+{
+	size_t i;
+#ifndef NO_FEEDER
+	size_t active = 0;
+	size_t *queue;
+#endif
+
+	for(i=0; i<count; ++i)
+	if(jobs[i].mh == NULL) return MPG123_BAD_HANDLE;
+	if(count == 0) return MPG123_OK;
+#ifndef NO_FEEDER
+	queue = malloc(sizeof(*queue)*count);
+	if(queue == NULL)
+	{ /* Plain mpg123_decode() calls still work. */
+		for(i=0; i<count; ++i)
+		jobs[i].err = mpg123_decode( jobs[i].mh, jobs[i].inmemory, jobs[i].inmemsize
+		,	jobs[i].outmemory, jobs[i].outmemsize, &jobs[i].done );
+		return MPG123_OK;
+	}
+	for(i=0; i<count; ++i)
+	if(batch_prepare(jobs+i)) queue[active++] = i;
+
+#ifndef NO_THREADS
+	if(threads > 1 && active > 1)
+	{
+		if((size_t)threads > active) threads = (int)active;
+		if(batch_threaded(jobs, queue, active, threads)) active = 0;
+	}
+#endif
+	batch_serial(jobs, queue, active);
+	free(queue);
+	for(i=0; i<count; ++i)
+	join_planes(jobs[i].mh, jobs[i].outmemory, jobs[i].done);
+#else
+	for(i=0; i<count; ++i)
+	{
+		jobs[i].done = 0;
+		jobs[i].mh->err = MPG123_MISSING_FEATURE;
+		jobs[i].err = MPG123_ERR;
+	}
+#endif
+	return MPG123_OK;
+}
+
 int attribute_align_arg mpg123_meta_check(mpg123_handle *mh)
 {
 	if(mh != NULL) return mh->metaflags;
@@ -1581,6 +2519,495 @@ int attribute_align_arg mpg123_set_index(mpg123_handle *mh, off_t *offsets, off_
 #endif
 }
 
+#ifdef FRAME_INDEX
+/*
+	Layout of exported index data, numbers in little endian:
+
+	 0  "mpgi", version byte, three zero bytes
+	 8  file size (-1 if unknown)
+	16  first frame header, four zero bytes
+	24  audio_start, track_frames, track_samples
+	48  gapless_frames, begin_s, end_s (-1, 0, 0 without gapless info)
+	72  index step, index fill
+	88  fill index offsets
+	    CRC-32 of all the above (4 bytes)
+
+	All values without other mention are 8 bytes wide.
+*/
+#define INDEX_VERSION 1
+#define INDEX_HEAD    88
+#endif
+
+/* Byte order independent storage, for index and decoder state data. */
+static void index_put(unsigned char *p, int64_t val, int bytes)
+{
+	uint64_t v = (uint64_t)val;
+	int i;
+	for(i=0; i<bytes; ++i, v >>= 8) p[i] = v & 0xff;
+}
+
+static int64_t index_get(const unsigned char *p, int bytes)
+{
+	uint64_t v = 0;
+	int i;
+	for(i=bytes-1; i>=0; --i) v = (v << 8) | p[i];
+	return (int64_t)v;
+}
+
+static unsigned long index_crc(const unsigned char *data, size_t size)
+{
+	unsigned long crc = 0xffffffffUL;
+	while(size--)
+	{
+		int k;
+		crc ^= *data++;
+		for(k=0; k<8; ++k)
+		crc = (crc >> 1) ^ (0xedb88320UL & (0UL-(crc & 1)));
+	}
+	return crc ^ 0xffffffffUL;
+}
+
+/* Does the stored value survive the trip through off_t? */
+#define INDEX_OFF_OK(v) ((int64_t)(off_t)(v) == (v))
+
+int attribute_align_arg mpg123_export_index(mpg123_handle *mh, unsigned char *data, size_t *size)
+{
+#ifdef FRAME_INDEX
+	int b;
+	size_t need, i;
+	unsigned char *p;
+#endif
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+	if(size == NULL)
+	{
+		mh->err = MPG123_BAD_INDEX_PAR;
+		return MPG123_ERR;
+	}
+#ifdef FRAME_INDEX
+	b = init_track(mh); /* The first header is part of it. */
+	if(b == MPG123_DONE)
+	{
+		/* No frame at all, nothing to store. */
+		mh->err = MPG123_INDEX_FAIL;
+		return MPG123_ERR;
+	}
+	if(b < 0) return b;
+
+	need = INDEX_HEAD + 8*mh->index.fill + 4;
+	if(data == NULL)
+	{
+		*size = need;
+		return MPG123_OK;
+	}
+	if(*size < need)
+	{
+		*size = need;
+		mh->err = MPG123_BAD_BUFFER;
+		return MPG123_ERR;
+	}
+	memset(data, 0, INDEX_HEAD);
+	memcpy(data, "mpgi", 4);
+	data[4] = INDEX_VERSION;
+	index_put(data+8,  mh->rdat.filelen, 8);
+	index_put(data+16, mh->firsthead, 4);
+	index_put(data+24, mh->audio_start, 8);
+	index_put(data+32, mh->track_frames, 8);
+	index_put(data+40, mh->track_samples, 8);
+#ifdef GAPLESS
+	index_put(data+48, mh->gapless_frames, 8);
+	index_put(data+56, mh->begin_s, 8);
+	index_put(data+64, mh->end_s, 8);
+#else
+	index_put(data+48, -1, 8);
+#endif
+	index_put(data+72, mh->index.step, 8);
+	index_put(data+80, mh->index.fill, 8);
+	for(i=0, p=data+INDEX_HEAD; i<mh->index.fill; ++i, p+=8)
+	index_put(p, mh->index.data[i], 8);
+	index_put(p, index_crc(data, need-4), 4);
+	*size = need;
+	return MPG123_OK;
+#else
+	mh->err = MPG123_MISSING_FEATURE;
+	return MPG123_ERR;
+#endif
+}
+
+int attribute_align_arg mpg123_import_index(mpg123_handle *mh, const unsigned char *data, size_t size)
+{
+#ifdef FRAME_INDEX
+	int b;
+	int64_t fill, step, track_frames, track_samples, gapless_frames, begin_s, end_s;
+	off_t *offsets = NULL;
+	size_t oldsize, i;
+	const unsigned char *p;
+#endif
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+	if(data == NULL)
+	{
+		mh->err = MPG123_BAD_INDEX_PAR;
+		return MPG123_ERR;
+	}
+#ifdef FRAME_INDEX
+	/* First, the data itself has to be sane. */
+	if(size < INDEX_HEAD+4 || memcmp(data, "mpgi", 4) || data[4] != INDEX_VERSION)
+	goto import_bad;
+	fill = index_get(data+80, 8);
+	if(fill < 0 || (uint64_t)fill != (size-INDEX_HEAD-4)/8 || size != INDEX_HEAD+8*(size_t)fill+4)
+	goto import_bad;
+	if((unsigned long)index_get(data+size-4, 4) != index_crc(data, size-4))
+	goto import_bad;
+	step          = index_get(data+72, 8);
+	track_frames  = index_get(data+32, 8);
+	track_samples = index_get(data+40, 8);
+	gapless_frames = index_get(data+48, 8);
+	begin_s       = index_get(data+56, 8);
+	end_s         = index_get(data+64, 8);
+	if( step < 1 || track_frames < 0 || track_samples < 0 || !INDEX_OFF_OK(step)
+	||  !INDEX_OFF_OK(track_frames) || !INDEX_OFF_OK(track_samples)
+	||  !INDEX_OFF_OK(gapless_frames) || !INDEX_OFF_OK(begin_s) || !INDEX_OFF_OK(end_s) )
+	goto import_bad;
+
+	/* Then, it has to match the stream. An empty one has no index. */
+	b = init_track(mh);
+	if(b == MPG123_DONE) goto import_bad;
+	if(b < 0) return b;
+	if( index_get(data+8, 8) != mh->rdat.filelen
+	||  (unsigned long)index_get(data+16, 4) != mh->firsthead
+	||  index_get(data+24, 8) != mh->audio_start )
+	goto import_bad;
+
+	if(fill > 0)
+	{
+		offsets = malloc(sizeof(off_t)*(size_t)fill);
+		if(offsets == NULL)
+		{
+			mh->err = MPG123_OUT_OF_MEM;
+			return MPG123_ERR;
+		}
+	}
+	for(i=0, p=data+INDEX_HEAD; i<(size_t)fill; ++i, p+=8)
+	{
+		int64_t pos = index_get(p, 8);
+		if( !INDEX_OFF_OK(pos) || pos < 0 || (i && pos <= offsets[i-1])
+		||  (mh->rdat.filelen > 0 && pos >= mh->rdat.filelen) )
+		{
+			free(offsets);
+			goto import_bad;
+		}
+		offsets[i] = (off_t)pos;
+	}
+	/* Keep the configured index size, more entries will follow during decoding. */
+	oldsize = mh->index.size;
+	b = fi_set(&mh->index, offsets, (off_t)step, (size_t)fill);
+	if(offsets != NULL) free(offsets);
+	if(b == -1)
+	{
+		mh->err = MPG123_OUT_OF_MEM;
+		return MPG123_ERR;
+	}
+	if(oldsize > mh->index.size) fi_resize(&mh->index, oldsize);
+
+	if(track_frames > 0)
+	{
+		mh->track_frames  = (off_t)track_frames;
+		mh->track_samples = (off_t)track_samples;
+	}
+#ifdef GAPLESS
+	if(mh->p.flags & MPG123_GAPLESS)
+	{
+		mh->gapless_frames = (off_t)gapless_frames;
+		mh->begin_s = (off_t)begin_s;
+		mh->end_s   = (off_t)end_s;
+		frame_gapless_realinit(mh);
+		frame_set_frameseek(mh, mh->num);
+	}
+#endif
+	return MPG123_OK;
+
+import_bad:
+	mh->err = MPG123_BAD_INDEX_DATA;
+	return MPG123_ERR;
+#else
+	mh->err = MPG123_MISSING_FEATURE;
+	return MPG123_ERR;
+#endif
+}
+
+/*
+	Layout of exported decoding state, numbers in little endian:
+
+	  0  "mpgs", version byte, sizeof(real), 1 for fixed point, 1 for little endian host
+	  8  decoder name, zero-padded to 16 bytes
+	 24  first frame header, last frame header (4 bytes each)
+	 32  free format frame size, num, playnum, input_offset, audio_start
+	 72  input position of the pending input bytes
+	 80  track_frames, track_samples, mean_frames, mean_framesize (in 1/1024 bytes)
+	112  firstframe, lastframe, ignoreframe
+	136  gapless_frames, firstoff, lastoff, begin_s, begin_os, end_s, end_os, fullend_os
+	200  output rate, channels, encoding (4 bytes each)
+	216  state flags, halfphase, vbr, abr_rate (4 bytes each)
+	232  bitreservoir, bo, hybrid_blc[2], i486bo[2] (4 bytes each)
+	256  ditherindex, bsnum (4 bytes each), ntom_val[2]
+	280  count of decoder buffer bytes, count of pending input bytes
+	296  decoder buffer data (native layout, see checkpoint_state_get())
+	     pending input bytes
+	     CRC-32 of all the above (4 bytes)
+
+	All values without other mention are 8 bytes wide.
+*/
+#define STATE_VERSION 1
+#define STATE_HEAD    296
+
+static void state_native(unsigned char *p)
+{
+	union { uint16_t i; unsigned char c[2]; } order;
+	order.i = 1;
+	p[0] = sizeof(real);
+#ifdef REAL_IS_FIXED
+	p[1] = 1;
+#else
+	p[1] = 0;
+#endif
+	p[2] = order.c[0];
+}
+
+int attribute_align_arg mpg123_export_state(mpg123_handle *mh, unsigned char *data, size_t *size)
+{
+	ssize_t pending;
+	size_t decbytes, need;
+	const char *decoder;
+
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+	if(size == NULL)
+	{
+		mh->err = MPG123_ERR_NULL;
+		return MPG123_ERR;
+	}
+	/* Between frames of a feed, with the decoder set up for the last one. */
+	pending  = feed_pending(mh, NULL);
+	decbytes = checkpoint_state_size(mh);
+	if(pending < 0 || mh->num < 0 || mh->to_decode || mh->header_change > 1 || !decbytes)
+	{
+		mh->err = MPG123_NO_STATE;
+		return MPG123_ERR;
+	}
+	need = STATE_HEAD + decbytes + pending + 4;
+	if(data == NULL)
+	{
+		*size = need;
+		return MPG123_OK;
+	}
+	if(*size < need)
+	{
+		*size = need;
+		mh->err = MPG123_BAD_BUFFER;
+		return MPG123_ERR;
+	}
+	memset(data, 0, STATE_HEAD);
+	memcpy(data, "mpgs", 4);
+	data[4] = STATE_VERSION;
+	state_native(data+5);
+	decoder = mpg123_current_decoder(mh);
+	strncpy((char*)data+8, decoder != NULL ? decoder : "", 16);
+	index_put(data+24,  mh->firsthead, 4);
+	index_put(data+28,  mh->oldhead, 4);
+	index_put(data+32,  mh->freeformat_framesize, 8);
+	index_put(data+40,  mh->num, 8);
+	index_put(data+48,  mh->playnum, 8);
+	index_put(data+56,  mh->input_offset, 8);
+	index_put(data+64,  mh->audio_start, 8);
+	index_put(data+72,  mh->rdat.filepos, 8);
+	index_put(data+80,  mh->track_frames, 8);
+	index_put(data+88,  mh->track_samples, 8);
+	index_put(data+96,  mh->mean_frames, 8);
+	index_put(data+104, (int64_t)(mh->mean_framesize*1024+0.5), 8);
+	index_put(data+112, mh->firstframe, 8);
+	index_put(data+120, mh->lastframe, 8);
+	index_put(data+128, mh->ignoreframe, 8);
+#ifdef GAPLESS
+	index_put(data+136, mh->gapless_frames, 8);
+	index_put(data+144, mh->firstoff, 8);
+	index_put(data+152, mh->lastoff, 8);
+	index_put(data+160, mh->begin_s, 8);
+	index_put(data+168, mh->begin_os, 8);
+	index_put(data+176, mh->end_s, 8);
+	index_put(data+184, mh->end_os, 8);
+	index_put(data+192, mh->fullend_os, 8);
+#else
+	index_put(data+136, -1, 8);
+#endif
+	index_put(data+200, mh->af.rate, 8);
+	index_put(data+208, mh->af.channels, 4);
+	index_put(data+212, mh->af.encoding, 4);
+	index_put(data+216, mh->state_flags & (FRAME_ACCURATE|FRAME_FRANKENSTEIN), 4);
+	index_put(data+220, mh->halfphase, 4);
+	index_put(data+224, mh->vbr, 4);
+	index_put(data+228, mh->abr_rate, 4);
+	index_put(data+232, mh->bitreservoir, 4);
+	index_put(data+236, mh->bo, 4);
+	index_put(data+240, mh->hybrid_blc[0], 4);
+	index_put(data+244, mh->hybrid_blc[1], 4);
+#ifdef OPT_I486
+	index_put(data+248, mh->i486bo[0], 4);
+	index_put(data+252, mh->i486bo[1], 4);
+#endif
+#ifdef OPT_DITHER
+	index_put(data+256, mh->ditherindex, 4);
+#endif
+	index_put(data+260, mh->bsnum, 4);
+#ifndef NO_NTOM
+	index_put(data+264, mh->ntom_val[0], 8);
+	index_put(data+272, mh->ntom_val[1], 8);
+#endif
+	index_put(data+280, decbytes, 8);
+	index_put(data+288, pending, 8);
+	checkpoint_state_get(mh, data+STATE_HEAD);
+	feed_pending(mh, data+STATE_HEAD+decbytes);
+	index_put(data+need-4, index_crc(data, need-4), 4);
+	*size = need;
+	return MPG123_OK;
+}
+
+int attribute_align_arg mpg123_import_state(mpg123_handle *mh, const unsigned char *data, size_t size)
+{
+	unsigned char native[3];
+	int64_t decbytes, pending;
+	int64_t offs[20];
+	const char *decoder;
+	long freeformat_framesize;
+	int b, i;
+
+	if(mh == NULL) return MPG123_BAD_HANDLE;
+	if(data == NULL)
+	{
+		mh->err = MPG123_ERR_NULL;
+		return MPG123_ERR;
+	}
+	if(feed_pending(mh, NULL) != 0 || mh->num >= 0 || mh->firsthead)
+	{
+		mh->err = MPG123_NO_STATE;
+		return MPG123_ERR;
+	}
+	/* The data itself has to be sane and made by our kind. */
+	state_native(native);
+	if( size < STATE_HEAD+4 || memcmp(data, "mpgs", 4) || data[4] != STATE_VERSION
+	||  memcmp(data+5, native, sizeof(native)) )
+	goto state_bad;
+	decbytes = index_get(data+280, 8);
+	pending  = index_get(data+288, 8);
+	if( decbytes <= 0 || pending < 0 || (uint64_t)decbytes > size || (uint64_t)pending > size
+	||  size != STATE_HEAD+(size_t)decbytes+(size_t)pending+4 )
+	goto state_bad;
+	if((unsigned long)index_get(data+size-4, 4) != index_crc(data, size-4))
+	goto state_bad;
+	/* All the off_t values from num to fullend_os. */
+	for(i=0; i<20; ++i)
+	{
+		offs[i] = index_get(data+40+8*i, 8);
+		if(!INDEX_OFF_OK(offs[i])) goto state_bad;
+	}
+	if(offs[0] < 0 || offs[4] < 0) goto state_bad;
+
+	/* The last header makes up the stream properties, the decoder is set up for them. */
+	freeformat_framesize = mh->freeformat_framesize;
+	mh->freeformat_framesize = (long)index_get(data+32, 8);
+	if(!index_get(data+24, 4) || read_frame_restore(mh, (unsigned long)index_get(data+28, 4)))
+	{
+		mh->freeformat_framesize = freeformat_framesize;
+		goto state_bad;
+	}
+	mh->firsthead   = (unsigned long)index_get(data+24, 4);
+	mh->oldhead     = (unsigned long)index_get(data+28, 4);
+	mh->num         = (off_t)offs[0];
+	mh->playnum     = (off_t)offs[1];
+	mh->input_offset = (off_t)offs[2];
+	mh->audio_start = (off_t)offs[3];
+	mh->track_frames  = (off_t)offs[5];
+	mh->track_samples = (off_t)offs[6];
+	mh->mean_frames = (off_t)offs[7];
+	mh->mean_framesize = (double)offs[8]/1024;
+	mh->firstframe  = (off_t)offs[9];
+	mh->lastframe   = (off_t)offs[10];
+	mh->ignoreframe = (off_t)offs[11];
+#ifdef GAPLESS
+	mh->gapless_frames = (off_t)offs[12];
+	mh->firstoff    = (off_t)offs[13];
+	mh->lastoff     = (off_t)offs[14];
+	mh->begin_s     = (off_t)offs[15];
+	mh->begin_os    = (off_t)offs[16];
+	mh->end_s       = (off_t)offs[17];
+	mh->end_os      = (off_t)offs[18];
+	mh->fullend_os  = (off_t)offs[19];
+#endif
+	mh->state_flags = (mh->state_flags & ~(FRAME_ACCURATE|FRAME_FRANKENSTEIN))
+	                | (index_get(data+216, 4) & (FRAME_ACCURATE|FRAME_FRANKENSTEIN));
+	mh->halfphase   = (int)index_get(data+220, 4);
+	mh->vbr         = (enum mpg123_vbr)index_get(data+224, 4);
+	mh->abr_rate    = (int)index_get(data+228, 4);
+	mh->fresh = 0; /* No gapless setup from the start, that is all there already. */
+	if(decode_update(mh) < 0) goto state_fail;
+	mh->header_change = 0;
+
+	if(frame_bitstream_buffers(mh) < 0)
+	{
+		mh->err = MPG123_OUT_OF_MEM;
+		goto state_fail;
+	}
+	/* Now the decoder buffers are there, they must match. */
+	decoder = mpg123_current_decoder(mh);
+	if( mh->af.rate != index_get(data+200, 8)
+	||  mh->af.channels != index_get(data+208, 4) || mh->af.encoding != index_get(data+212, 4)
+	||  decoder == NULL || strncmp(decoder, (const char*)data+8, 16)
+	||  checkpoint_state_size(mh) != (size_t)decbytes )
+	{
+		mh->err = MPG123_BAD_STATE_DATA;
+		goto state_fail;
+	}
+	mh->bitreservoir   = (unsigned int)index_get(data+232, 4);
+	mh->bo             = (int)index_get(data+236, 4);
+	mh->hybrid_blc[0]  = (int)index_get(data+240, 4) & 1;
+	mh->hybrid_blc[1]  = (int)index_get(data+244, 4) & 1;
+#ifdef OPT_I486
+	mh->i486bo[0] = (int)index_get(data+248, 4);
+	mh->i486bo[1] = (int)index_get(data+252, 4);
+#endif
+#ifdef OPT_DITHER
+	mh->ditherindex = (int)index_get(data+256, 4);
+#endif
+	mh->bsnum = (int)index_get(data+260, 4) & 1;
+#ifndef NO_NTOM
+	mh->ntom_val[0] = (unsigned long)index_get(data+264, 8);
+	mh->ntom_val[1] = (unsigned long)index_get(data+272, 8);
+#endif
+	if(checkpoint_state_set(mh, data+STATE_HEAD) != 0)
+	{
+		mh->err = MPG123_OUT_OF_MEM;
+		goto state_fail;
+	}
+	/* Continue with the input where the other handle stopped parsing. */
+	feed_set_pos(mh, (off_t)offs[4]);
+	mh->rdat.filepos = (off_t)offs[4];
+	if(pending && feed_more(mh, data+STATE_HEAD+decbytes, (long)pending) != 0)
+	{
+		mh->err = MPG123_OUT_OF_MEM;
+		goto state_fail;
+	}
+	mh->to_decode = mh->to_ignore = FALSE;
+	mh->buffer.fill = 0;
+	mh->checkpoint_next = mh->num+1;
+	return MPG123_OK;
+
+state_bad:
+	mh->err = MPG123_BAD_STATE_DATA;
+	return MPG123_ERR;
+state_fail:
+	b = mh->err;
+	mpg123_open_feed(mh);
+	mh->err = b;
+	return MPG123_ERR;
+}
+
 int attribute_align_arg mpg123_close(mpg123_handle *mh)
 {
 	if(mh == NULL) return MPG123_BAD_HANDLE;
@@ -1596,6 +3023,7 @@ int attribute_align_arg mpg123_close(mpg123_handle *mh)
 	}
 	/* Always reset the frame buffers on close, so we cannot forget it in funky opening routines (wrappers, even). */
 	frame_reset(mh);
+	if(mh->p.flags & MPG123_LAZY_BUFFERS) frame_release_buffers(mh);
 	return MPG123_OK;
 }
 
@@ -1655,6 +3083,9 @@ static const char *mpg123_error[] =
 	,"Custom I/O obviously not prepared."
 	,"Overflow in LFS (large file support) conversion."
 	,"Overflow in integer conversion."
+	,"Stored frame index data is damaged or does not belong to this stream."
+	,"Decoding state cannot be exported or imported now (not between frames of a feed?)."
+	,"Stored decoding state is damaged or does not fit this handle (build, decoder, format)."
 };
 
 const char* attribute_align_arg mpg123_plain_strerror(int errcode)
@@ -48,7 +48,7 @@ static struct cpuflags cpu_flags;
 #endif
 
 #ifndef NO_32BIT
-#define IF32(synth) synth
+#define IF32(synth) synth,
 #else
 #define IF32(synth)
 #endif
@@ -61,13 +61,13 @@ static struct cpuflags cpu_flags;
 #endif
 
 #ifndef NO_16BIT
-#	define OUT_SYNTHS(synth_16, synth_8, synth_real, synth_32) { synth_16, IF8(synth_8) IFREAL(synth_real) IF32(synth_32) }
+#	define OUT_SYNTHS(synth_16, synth_8, synth_real, synth_32, synth_24) { synth_16, IF8(synth_8) IFREAL(synth_real) IF32(synth_32) IF32(synth_24) }
 #else
-#	define OUT_SYNTHS(synth_16, synth_8, synth_real, synth_32) { IF8(synth_8) IFREAL(synth_real) IF32(synth_32) }
+#	define OUT_SYNTHS(synth_16, synth_8, synth_real, synth_32, synth_24) { IF8(synth_8) IFREAL(synth_real) IF32(synth_32) IF32(synth_24) }
 #endif
 
 /* The call of left and right plain synth, wrapped.
-   This may be replaced by a direct stereo optimized synth. */
+   Used for decoders that only have a special plain synth. */
 static int synth_stereo_wrap(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 {
 	int clip;
@@ -79,43 +79,43 @@ static int synth_stereo_wrap(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr
 static const struct synth_s synth_base =
 {
 	{ /* plain */
-		 OUT_SYNTHS(synth_1to1, synth_1to1_8bit, synth_1to1_real, synth_1to1_s32)
+		 OUT_SYNTHS(synth_1to1, synth_1to1_8bit, synth_1to1_real, synth_1to1_s32, synth_1to1_s24)
 #		ifndef NO_DOWNSAMPLE
-		,OUT_SYNTHS(synth_2to1, synth_2to1_8bit, synth_2to1_real, synth_2to1_s32)
-		,OUT_SYNTHS(synth_4to1, synth_4to1_8bit, synth_4to1_real, synth_4to1_s32)
+		,OUT_SYNTHS(synth_2to1, synth_2to1_8bit, synth_2to1_real, synth_2to1_s32, synth_2to1_s24)
+		,OUT_SYNTHS(synth_4to1, synth_4to1_8bit, synth_4to1_real, synth_4to1_s32, synth_4to1_s24)
 #		endif
 #		ifndef NO_NTOM
-		,OUT_SYNTHS(synth_ntom, synth_ntom_8bit, synth_ntom_real, synth_ntom_s32)
+		,OUT_SYNTHS(synth_ntom, synth_ntom_8bit, synth_ntom_real, synth_ntom_s32, synth_ntom_s24)
 #		endif
 	},
-	{ /* stereo, by default only wrappers over plain synth */
-		 OUT_SYNTHS(synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap)
+	{ /* stereo, generic code doing both channels in one pass */
+		 OUT_SYNTHS(synth_1to1_stereo, synth_1to1_8bit_stereo, synth_1to1_real_stereo, synth_1to1_s32_stereo, synth_1to1_s24_stereo)
 #		ifndef NO_DOWNSAMPLE
-		,OUT_SYNTHS(synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap)
-		,OUT_SYNTHS(synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap)
+		,OUT_SYNTHS(synth_2to1_stereo, synth_2to1_8bit_stereo, synth_2to1_real_stereo, synth_2to1_s32_stereo, synth_2to1_s24_stereo)
+		,OUT_SYNTHS(synth_4to1_stereo, synth_4to1_8bit_stereo, synth_4to1_real_stereo, synth_4to1_s32_stereo, synth_4to1_s24_stereo)
 #		endif
 #		ifndef NO_NTOM
-		,OUT_SYNTHS(synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap, synth_stereo_wrap)
+		,OUT_SYNTHS(synth_ntom_stereo, synth_ntom_8bit_stereo, synth_ntom_real_stereo, synth_ntom_s32_stereo, synth_ntom_s24_stereo)
 #		endif
 	},
 	{ /* mono2stereo */
-		 OUT_SYNTHS(synth_1to1_m2s, synth_1to1_8bit_m2s, synth_1to1_real_m2s, synth_1to1_s32_m2s)
+		 OUT_SYNTHS(synth_1to1_m2s, synth_1to1_8bit_m2s, synth_1to1_real_m2s, synth_1to1_s32_m2s, synth_1to1_s24_m2s)
 #		ifndef NO_DOWNSAMPLE
-		,OUT_SYNTHS(synth_2to1_m2s, synth_2to1_8bit_m2s, synth_2to1_real_m2s, synth_2to1_s32_m2s)
-		,OUT_SYNTHS(synth_4to1_m2s, synth_4to1_8bit_m2s, synth_4to1_real_m2s, synth_4to1_s32_m2s)
+		,OUT_SYNTHS(synth_2to1_m2s, synth_2to1_8bit_m2s, synth_2to1_real_m2s, synth_2to1_s32_m2s, synth_2to1_s24_m2s)
+		,OUT_SYNTHS(synth_4to1_m2s, synth_4to1_8bit_m2s, synth_4to1_real_m2s, synth_4to1_s32_m2s, synth_4to1_s24_m2s)
 #		endif
 #		ifndef NO_NTOM
-		,OUT_SYNTHS(synth_ntom_m2s, synth_ntom_8bit_m2s, synth_ntom_real_m2s, synth_ntom_s32_m2s)
+		,OUT_SYNTHS(synth_ntom_m2s, synth_ntom_8bit_m2s, synth_ntom_real_m2s, synth_ntom_s32_m2s, synth_ntom_s24_m2s)
 #		endif
 	},
 	{ /* mono*/
-		 OUT_SYNTHS(synth_1to1_mono, synth_1to1_8bit_mono, synth_1to1_real_mono, synth_1to1_s32_mono)
+		 OUT_SYNTHS(synth_1to1_mono, synth_1to1_8bit_mono, synth_1to1_real_mono, synth_1to1_s32_mono, synth_1to1_s24_mono)
 #		ifndef NO_DOWNSAMPLE
-		,OUT_SYNTHS(synth_2to1_mono, synth_2to1_8bit_mono, synth_2to1_real_mono, synth_2to1_s32_mono)
-		,OUT_SYNTHS(synth_4to1_mono, synth_4to1_8bit_mono, synth_4to1_real_mono, synth_4to1_s32_mono)
+		,OUT_SYNTHS(synth_2to1_mono, synth_2to1_8bit_mono, synth_2to1_real_mono, synth_2to1_s32_mono, synth_2to1_s24_mono)
+		,OUT_SYNTHS(synth_4to1_mono, synth_4to1_8bit_mono, synth_4to1_real_mono, synth_4to1_s32_mono, synth_4to1_s24_mono)
 #		endif
 #		ifndef NO_NTOM
-		,OUT_SYNTHS(synth_ntom_mono, synth_ntom_8bit_mono, synth_ntom_real_mono, synth_ntom_s32_mono)
+		,OUT_SYNTHS(synth_ntom_mono, synth_ntom_8bit_mono, synth_ntom_real_mono, synth_ntom_s32_mono, synth_ntom_s24_mono)
 #endif
 	}
 };
@@ -124,13 +124,13 @@ static const struct synth_s synth_base =
 /* More plain synths for i386 */
 const func_synth plain_i386[r_limit][f_limit] =
 { /* plain */
-	 OUT_SYNTHS(synth_1to1_i386, synth_1to1_8bit_i386, synth_1to1_real_i386, synth_1to1_s32_i386)
+	 OUT_SYNTHS(synth_1to1_i386, synth_1to1_8bit_i386, synth_1to1_real_i386, synth_1to1_s32_i386, synth_1to1_s24_i386)
 #	ifndef NO_DOWNSAMPLE
-	,OUT_SYNTHS(synth_2to1_i386, synth_2to1_8bit_i386, synth_2to1_real_i386, synth_2to1_s32_i386)
-	,OUT_SYNTHS(synth_4to1_i386, synth_4to1_8bit_i386, synth_4to1_real_i386, synth_4to1_s32_i386)
+	,OUT_SYNTHS(synth_2to1_i386, synth_2to1_8bit_i386, synth_2to1_real_i386, synth_2to1_s32_i386, synth_2to1_s24_i386)
+	,OUT_SYNTHS(synth_4to1_i386, synth_4to1_8bit_i386, synth_4to1_real_i386, synth_4to1_s32_i386, synth_4to1_s24_i386)
 #	endif
 #	ifndef NO_NTOM
-	,OUT_SYNTHS(synth_ntom, synth_ntom_8bit, synth_ntom_real, synth_ntom_s32)
+	,OUT_SYNTHS(synth_ntom, synth_ntom_8bit, synth_ntom_real, synth_ntom_s32, synth_ntom_s24)
 #	endif
 };
 #endif
@@ -148,6 +148,7 @@ enum optcla decclass(const enum optdec type)
 		|| type == dreidnowext
 		|| type == dreidnowext_vintage
 		|| type == x86_64
+		|| type == x86_64_dither
 		|| type == neon
 		|| type == neon64
 		|| type == avx
@@ -193,6 +194,10 @@ static int find_dectype(mpg123_handle *fr)
 	/* Direct and indirect usage, 1to1 stereo decoding.
 	   Concentrating on the plain stereo synth should be fine, mono stuff is derived. */
 	func_synth basic_synth = fr->synth;
+#ifdef SINC_RESAMPLE
+	if(basic_synth == synth_sinc)
+	basic_synth = fr->synths.plain[r_1to1][f_real]; /* The one doing the work. */
+#endif
 #ifndef NO_8BIT
 #ifndef NO_16BIT
 	if(basic_synth == synth_1to1_8bit_wrap)
@@ -262,6 +267,9 @@ static int find_dectype(mpg123_handle *fr)
 #ifdef OPT_GENERIC_DITHER
 	else if(basic_synth == synth_1to1_dither) type = generic_dither;
 #endif
+#ifdef OPT_X86_64_DITHER
+	else if(basic_synth == synth_1to1_x86_64_dither) type = x86_64_dither;
+#endif
 #ifdef OPT_DITHER /* either i586 or generic! */
 #ifndef NO_DOWNSAMPLE
 	else if
@@ -380,8 +388,10 @@ int set_synth_functions(mpg123_handle *fr)
 	basic_format = f_real;
 #endif
 #ifndef NO_32BIT
-	/* 24 bit integer means decoding to 32 bit first. */
-	else if(fr->af.dec_enc & MPG123_ENC_32 || fr->af.dec_enc & MPG123_ENC_24)
+	/* 24 bit integer straight from the synth, if frame_output_format() chose so. */
+	else if(fr->af.dec_enc & MPG123_ENC_24)
+	basic_format = f_24;
+	else if(fr->af.dec_enc & MPG123_ENC_32)
 	basic_format = f_32;
 #endif
 
@@ -414,12 +424,35 @@ int set_synth_functions(mpg123_handle *fr)
 	}
 
 	debug2("selecting synth: resample=%i format=%i", resample, basic_format);
-	/* Finally selecting the synth functions for stereo / mono. */
-	fr->synth = fr->synths.plain[resample][basic_format];
-	fr->synth_stereo = fr->synths.stereo[resample][basic_format];
-	fr->synth_mono = fr->af.channels==2
-		? fr->synths.mono2stereo[resample][basic_format] /* Mono MPEG file decoded to stereo. */
-		: fr->synths.mono[resample][basic_format];       /* Mono MPEG file decoded to mono. */
+#ifdef SINC_RESAMPLE
+	/* The sinc resampler takes the place of the NtoM synth, working with the 1to1 float synth. */
+	if(resample == r_ntom && fr->p.resample == MPG123_RESAMPLE_SINC)
+	{
+		if(resample_init(fr, basic_format) != 0) return -1;
+
+		fr->synth = synth_sinc;
+		fr->synth_stereo = synth_sinc_stereo;
+		fr->synth_mono = fr->af.channels==2 ? synth_sinc_m2s : synth_sinc_mono;
+	}
+	else
+#endif
+	{
+		/* Finally selecting the synth functions for stereo / mono. */
+		fr->synth = fr->synths.plain[resample][basic_format];
+		fr->synth_stereo = fr->synths.stereo[resample][basic_format];
+		fr->synth_mono = fr->af.channels==2
+			? fr->synths.mono2stereo[resample][basic_format] /* Mono MPEG file decoded to stereo. */
+			: fr->synths.mono[resample][basic_format];       /* Mono MPEG file decoded to mono. */
+	}
+
+	/* One plane per channel: wrap whatever writes the interleaved stereo. */
+	if(fr->p.flags & MPG123_PLANAR && fr->af.channels == 2)
+	{
+		fr->planar_stereo = fr->synth_stereo;
+		fr->planar_mono   = fr->synth_mono;
+		fr->synth_stereo  = synth_planar_stereo;
+		fr->synth_mono    = synth_planar_m2s;
+	}
 
 	if(find_dectype(fr) != MPG123_OK) /* Actually determine the currently active decoder breed. */
 	{
@@ -435,6 +468,9 @@ int set_synth_functions(mpg123_handle *fr)
 		return MPG123_ERR;
 	}
 
+#ifndef NO_32BIT
+	fr->s24_flip = fr->af.dec_enc == MPG123_ENC_UNSIGNED_24 ? 0x800000 : 0;
+#endif
 #ifndef NO_8BIT
 	if(basic_format == f_8)
 	{
@@ -457,6 +493,9 @@ int set_synth_functions(mpg123_handle *fr)
 #	ifndef NO_32BIT
 	   && basic_format != f_32
 #	endif
+#	ifdef SINC_RESAMPLE
+	   && fr->synth != synth_sinc
+#	endif
 #	ifdef ACCURATE_ROUNDING
 	   && fr->cpu_opts.type != sse
 	   && fr->cpu_opts.type != sse_vintage
@@ -464,14 +503,17 @@ int set_synth_functions(mpg123_handle *fr)
 	   && fr->cpu_opts.type != neon
 	   && fr->cpu_opts.type != neon64
 	   && fr->cpu_opts.type != avx
+#	endif
+#	ifdef OPT_X86_64_DITHER
+	   && fr->cpu_opts.type != x86_64_dither /* float synth below the dither */
 #	endif
 	  )
 	{
 #ifndef NO_LAYER3
-		init_layer3_stuff(fr, init_layer3_gainpow2_mmx);
+		init_layer3_stuff(fr, TRUE);
 #endif
 #ifndef NO_LAYER12
-		init_layer12_stuff(fr, init_layer12_table_mmx);
+		init_layer12_stuff(fr, TRUE);
 #endif
 		fr->make_decode_tables = make_decode_tables_mmx;
 	}
@@ -479,10 +521,10 @@ int set_synth_functions(mpg123_handle *fr)
 #endif
 	{
 #ifndef NO_LAYER3
-		init_layer3_stuff(fr, init_layer3_gainpow2);
+		init_layer3_stuff(fr, FALSE);
 #endif
 #ifndef NO_LAYER12
-		init_layer12_stuff(fr, init_layer12_table);
+		init_layer12_stuff(fr, FALSE);
 #endif
 		fr->make_decode_tables = make_decode_tables;
 	}
@@ -524,6 +566,18 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 #if (defined OPT_3DNOW_VINTAGE || defined OPT_3DNOWEXT_VINTAGE || defined OPT_SSE || defined OPT_X86_64 || defined OPT_AVX || defined OPT_NEON || defined OPT_NEON64)
 	fr->cpu_opts.the_dct36 = dct36;
 #endif
+#ifdef OPT_AVX
+	fr->cpu_opts.the_antialias = antialias;
+#endif
+#endif
+#if defined(SINC_RESAMPLE) && (defined OPT_X86_64 || defined OPT_AVX)
+	fr->cpu_opts.the_resample_dot = resample_dot;
+#endif
+#if !defined(NO_32BIT) && defined(OPT_AVX)
+	fr->cpu_opts.the_conv_s32_to_24 = conv_s32_to_24;
+#endif
+#if !defined(NO_EQUALIZER) && (defined OPT_X86_64 || defined OPT_AVX)
+	fr->cpu_opts.the_equalizer = do_equalizer;
 #endif
 #endif
 	/* covers any i386+ cpu; they actually differ only in the synth_1to1 function, mostly... */
@@ -679,7 +733,9 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 			fr->synths.plain[r_1to1][f_16] = synth_1to1_i586_dither;
 #			ifndef NO_DOWNSAMPLE
 			fr->synths.plain[r_2to1][f_16] = synth_2to1_dither;
+			fr->synths.stereo[r_2to1][f_16] = synth_2to1_dither_stereo;
 			fr->synths.plain[r_4to1][f_16] = synth_4to1_dither;
+			fr->synths.stereo[r_4to1][f_16] = synth_4to1_dither_stereo;
 #			endif
 #			endif
 			done = 1;
@@ -742,6 +798,16 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 #ifdef OPT_MULTI
 #		ifndef NO_LAYER3
 		fr->cpu_opts.the_dct36 = dct36_avx;
+		fr->cpu_opts.the_antialias = antialias_avx;
+#		endif
+#		ifdef SINC_RESAMPLE
+		fr->cpu_opts.the_resample_dot = resample_dot_avx;
+#		endif
+#		ifndef NO_32BIT
+		fr->cpu_opts.the_conv_s32_to_24 = conv_s32_to_24_avx;
+#		endif
+#		ifndef NO_EQUALIZER
+		fr->cpu_opts.the_equalizer = do_equalizer_avx;
 #		endif
 #endif
 #		ifndef NO_16BIT
@@ -769,6 +835,12 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 #		ifndef NO_LAYER3
 		fr->cpu_opts.the_dct36 = dct36_x86_64;
 #		endif
+#		ifdef SINC_RESAMPLE
+		fr->cpu_opts.the_resample_dot = resample_dot_x86_64;
+#		endif
+#		ifndef NO_EQUALIZER
+		fr->cpu_opts.the_equalizer = do_equalizer_x86_64;
+#		endif
 #endif
 #		ifndef NO_16BIT
 		fr->synths.plain[r_1to1][f_16] = synth_1to1_x86_64;
@@ -786,6 +858,44 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 	}
 #endif
 
+#ifdef OPT_X86_64_DITHER
+	/* Only on request, dithering is never the automatic choice. */
+	if(!done && want_dec == x86_64_dither)
+	{
+		chosen = "dithered x86-64 (SSE)";
+		fr->cpu_opts.type = x86_64_dither;
+		dithered = TRUE;
+#		ifndef NO_LAYER3
+		fr->cpu_opts.the_dct36 = dct36_x86_64;
+#		endif
+#		ifdef SINC_RESAMPLE
+		fr->cpu_opts.the_resample_dot = resample_dot_x86_64;
+#		endif
+#		ifndef NO_EQUALIZER
+		fr->cpu_opts.the_equalizer = do_equalizer_x86_64;
+#		endif
+#		ifndef NO_16BIT
+		fr->synths.plain[r_1to1][f_16] = synth_1to1_x86_64_dither;
+		fr->synths.stereo[r_1to1][f_16] = synth_1to1_stereo_x86_64_dither;
+#		ifndef NO_DOWNSAMPLE
+		fr->synths.plain[r_2to1][f_16] = synth_2to1_dither;
+		fr->synths.stereo[r_2to1][f_16] = synth_2to1_dither_stereo;
+		fr->synths.plain[r_4to1][f_16] = synth_4to1_dither;
+		fr->synths.stereo[r_4to1][f_16] = synth_4to1_dither_stereo;
+#		endif
+#		endif
+#		ifndef NO_REAL
+		fr->synths.plain[r_1to1][f_real] = synth_1to1_real_x86_64;
+		fr->synths.stereo[r_1to1][f_real] = synth_1to1_real_stereo_x86_64;
+#		endif
+#		ifndef NO_32BIT
+		fr->synths.plain[r_1to1][f_32] = synth_1to1_s32_x86_64;
+		fr->synths.stereo[r_1to1][f_32] = synth_1to1_s32_stereo_x86_64;
+#		endif
+		done = 1;
+	}
+#endif
+
 #	ifdef OPT_ALTIVEC
 	if(!done && (auto_choose || want_dec == altivec))
 	{
@@ -888,9 +998,12 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 		dithered = TRUE;
 #		ifndef NO_16BIT
 		fr->synths.plain[r_1to1][f_16] = synth_1to1_dither;
+		fr->synths.stereo[r_1to1][f_16] = synth_1to1_dither_stereo;
 #		ifndef NO_DOWNSAMPLE
 		fr->synths.plain[r_2to1][f_16] = synth_2to1_dither;
+		fr->synths.stereo[r_2to1][f_16] = synth_2to1_dither_stereo;
 		fr->synths.plain[r_4to1][f_16] = synth_4to1_dither;
+		fr->synths.stereo[r_4to1][f_16] = synth_4to1_dither_stereo;
 #		endif
 #		endif
 		done = 1;
@@ -899,20 +1012,57 @@ int frame_cpu_opt(mpg123_handle *fr, const char* cpu)
 
 	fr->cpu_opts.class = decclass(fr->cpu_opts.type);
 
+	{
+		/* The generic stereo synths only go with the generic plain ones.
+		   A decoder with its own plain synth but no stereo one gets the wrapper. */
+		enum synth_resample ri;
+		enum synth_format   fi;
+		for(ri=0; ri<r_limit; ++ri)
+		for(fi=0; fi<f_limit; ++fi)
+		if(    fr->synths.stereo[ri][fi] == synth_base.stereo[ri][fi]
+		    && fr->synths.plain[ri][fi]  != synth_base.plain[ri][fi] )
+		fr->synths.stereo[ri][fi] = synth_stereo_wrap;
+	}
+
 #	ifndef NO_8BIT
 #	ifndef NO_16BIT /* possibility to use a 16->8 wrapper... */
 	/* Last chance to use some optimized routine via generic wrappers (for 8bit). */
 	if(     fr->cpu_opts.type != ifuenf_dither
 	     && fr->cpu_opts.type != generic_dither
+	     && fr->cpu_opts.type != x86_64_dither
 	     && fr->synths.plain[r_1to1][f_16] != synth_base.plain[r_1to1][f_16] )
 	{
 		fr->synths.plain[r_1to1][f_8] = synth_1to1_8bit_wrap;
 		fr->synths.mono[r_1to1][f_8] = synth_1to1_8bit_wrap_mono;
 		fr->synths.mono2stereo[r_1to1][f_8] = synth_1to1_8bit_wrap_m2s;
+		fr->synths.stereo[r_1to1][f_8] = fr->synths.stereo[r_1to1][f_16] != synth_stereo_wrap
+		?	synth_1to1_8bit_wrap_stereo : synth_stereo_wrap;
 	}
 #	endif
 #	endif
 
+#	if !defined(NO_32BIT) && !defined(NO_SYNTH32)
+	/* The direct 24 bit synths are plain C. A decoder with its own 32 bit synth
+	   does better with that plus conversion in postprocess_buffer(), so they
+	   are only offered along generic 32 bit synths (see frame_output_format()). */
+	if(  sizeof(struct s24_sample) != 3
+	  || (   fr->synths.plain[r_1to1][f_32] != synth_base.plain[r_1to1][f_32]
+#		ifdef OPT_X86
+	      && fr->synths.plain[r_1to1][f_32] != plain_i386[r_1to1][f_32]
+#		endif
+	     ) )
+	{
+		enum synth_resample ri;
+		for(ri=0; ri<r_limit; ++ri)
+		{
+			fr->synths.plain[ri][f_24] = NULL;
+			fr->synths.stereo[ri][f_24] = NULL;
+			fr->synths.mono2stereo[ri][f_24] = NULL;
+			fr->synths.mono[ri][f_24] = NULL;
+		}
+	}
+#	endif
+
 #ifdef OPT_DITHER
 	if(done && dithered)
 	{
@@ -997,6 +1147,9 @@ static const char *mpg123_supported_decoder_list[] =
 	#ifdef OPT_X86_64
 	NULL,
 	#endif
+	#ifdef OPT_X86_64_DITHER
+	NULL,
+	#endif
 	#ifdef OPT_ARM
 	NULL,
 	#endif
@@ -1063,6 +1216,9 @@ static const char *mpg123_decoder_list[] =
 	#ifdef OPT_X86_64
 	dn_x86_64,
 	#endif
+	#ifdef OPT_X86_64_DITHER
+	dn_x86_64_dither,
+	#endif
 	#ifdef OPT_ARM
 	dn_arm,
 	#endif
@@ -1142,6 +1298,9 @@ void check_decoders(void )
 #ifdef OPT_X86_64
 	*(d++) = dn_x86_64;
 #endif
+#ifdef OPT_X86_64_DITHER
+	*(d++) = dn_x86_64_dither;
+#endif
 #ifdef OPT_ARM
 	*(d++) = dn_arm;
 #endif
@@ -64,6 +64,7 @@ perl <<'EOT'
 ,['dreidnow_vintage', '3DNow_vintage']
 ,['dreidnowext_vintage', '3DNowExt_vintage']
 ,['sse_vintage', 'SSE_vintage']
+,['x86_64_dither', 'x86-64_dither']
 ,['nodec', 'nodec']
 );
 
@@ -113,6 +114,7 @@ enum optdec
 	,dreidnow_vintage
 	,dreidnowext_vintage
 	,sse_vintage
+	,x86_64_dither
 	,nodec
 };
 #ifdef I_AM_OPTIMIZE
@@ -136,6 +138,7 @@ static const char dn_avx[] = "AVX";
 static const char dn_dreidnow_vintage[] = "3DNow_vintage";
 static const char dn_dreidnowext_vintage[] = "3DNowExt_vintage";
 static const char dn_sse_vintage[] = "SSE_vintage";
+static const char dn_x86_64_dither[] = "x86-64_dither";
 static const char dn_nodec[] = "nodec";
 static const char* decname[] =
 {
@@ -159,6 +162,7 @@ static const char* decname[] =
 	,dn_dreidnow_vintage
 	,dn_dreidnowext_vintage
 	,dn_sse_vintage
+	,dn_x86_64_dither
 	,dn_nodec
 };
 #endif
@@ -331,14 +335,25 @@ extern const int costab_mmxsse[];
 #ifndef OPT_MULTI
 #	define defopt x86_64
 #	define opt_dct36(fr) dct36_x86_64
+#	define opt_resample_dot(fr) resample_dot_x86_64
+#	define opt_equalizer(fr) do_equalizer_x86_64
 #endif
 #endif
 
+/* The dithered x86-64 decoder comes with the dithered generic one in multi builds. */
+#if defined(OPT_X86_64) && defined(OPT_DITHER) && defined(OPT_MULTI)
+#define OPT_X86_64_DITHER
+#endif
+
 #ifdef OPT_AVX
 #define OPT_MMXORSSE
 #ifndef OPT_MULTI
 #	define defopt avx
 #	define opt_dct36(fr) dct36_avx
+#	define opt_antialias(fr) antialias_avx
+#	define opt_resample_dot(fr) resample_dot_avx
+#	define opt_conv_s32_to_24(fr) conv_s32_to_24_avx
+#	define opt_equalizer(fr) do_equalizer_avx
 #endif
 #endif
 
@@ -380,12 +395,41 @@ void check_decoders(void);
 #	if (defined OPT_3DNOW_VINTAGE || defined OPT_3DNOWEXT_VINTAGE || defined OPT_SSE || defined OPT_X86_64 || defined OPT_AVX || defined OPT_NEON || defined OPT_NEON64)
 #		define opt_dct36(fr) ((fr)->cpu_opts.the_dct36)
 #	endif
+#	ifdef OPT_AVX
+#		define opt_antialias(fr) ((fr)->cpu_opts.the_antialias)
+#	endif
+#	if (defined OPT_X86_64 || defined OPT_AVX)
+#		define opt_resample_dot(fr) ((fr)->cpu_opts.the_resample_dot)
+#	endif
+#	ifdef OPT_AVX
+#		define opt_conv_s32_to_24(fr) ((fr)->cpu_opts.the_conv_s32_to_24)
+#	endif
+#	if (defined OPT_X86_64 || defined OPT_AVX)
+#		define opt_equalizer(fr) ((fr)->cpu_opts.the_equalizer)
+#	endif
 
 #endif /* OPT_MULTI else */
 
 #	ifndef opt_dct36
 #		define opt_dct36(fr) dct36
 #	endif
+#	ifndef opt_antialias
+#		define opt_antialias(fr) antialias
+#	endif
+#	ifndef opt_resample_dot
+#		define opt_resample_dot(fr) resample_dot
+#	endif
+#	ifndef opt_conv_s32_to_24
+#		define opt_conv_s32_to_24(fr) conv_s32_to_24
+#	endif
+#	ifndef opt_equalizer
+#		define opt_equalizer(fr) do_equalizer
+#	endif
+
+/* The windowed-sinc resampler works on top of the float synth, see resample.c . */
+#if !defined(NO_NTOM) && !defined(NO_REAL) && !defined(NO_SYNTH32) && !defined(REAL_IS_FIXED)
+#	define SINC_RESAMPLE
+#endif
 
 #endif /* MPG123_H_OPTIMIZE */
 
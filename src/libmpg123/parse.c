@@ -67,6 +67,7 @@ static int decode_header(mpg123_handle *fr,unsigned long newhead, int *freeforma
 static int skip_junk(mpg123_handle *fr, unsigned long *newheadp, long *headcount);
 static int do_readahead(mpg123_handle *fr, unsigned long newhead);
 static int wetwork(mpg123_handle *fr, unsigned long *newheadp);
+static int skip_frame_body(mpg123_handle *fr);
 
 /* These two are to be replaced by one function that gives all the frame parameters (for outsiders).*/
 /* Those functions are unsafe regarding bad arguments (inside the mpg123_handle), but just returning anything would also be unsafe, the caller code has to be trusted. */
@@ -551,18 +552,37 @@ init_resync:
 
 	/* if filepos is invalid, so is framepos */
 	framepos = fr->rd->tell(fr) - 4;
+	/* Scanning only needs the headers. The bitstream buffers keep stale data, mpg123_scan() re-reads. */
+	if(fr->state_flags & FRAME_SCANNING)
+	{
+		if((ret=skip_frame_body(fr))<0) goto read_frame_bad;
+	}
+	else
 	/* flip/init buffer for Layer 3 */
 	{
-		unsigned char *newbuf = fr->bsspace[fr->bsnum]+512;
-		/* read main data into memory */
-		if((ret=fr->rd->read_frame_body(fr,newbuf,fr->framesize))<0)
+		unsigned char *newbuf;
+		unsigned char *view = NULL;
+		if((ret=frame_bitstream_buffers(fr)) < 0) goto read_frame_bad;
+
+		newbuf = fr->bsspace[fr->bsnum]+512;
+		/* Layer I/II frames in lent feeder buffers or mapped files are decoded in place.
+		   Layer III needs writable room before the main data for the bit reservoir,
+		   see set_pointer(). */
+		if( fr->lay == 3 || fr->rd->frame_view == NULL
+		||	(view = fr->rd->frame_view(fr, fr->framesize)) == NULL )
 		{
-			/* if failed: flip back */
-			debug("need more?");
-			goto read_frame_bad;
+			/* read main data into memory */
+			if((ret=fr->rd->read_frame_body(fr,newbuf,fr->framesize))<0)
+			{
+				/* if failed: flip back */
+				debug("need more?");
+				goto read_frame_bad;
+			}
 		}
-		fr->bsbufold = fr->bsbuf;
-		fr->bsbuf = newbuf;
+		/* A lent buffer may be gone by now; the other bitstream buffer is as good as garbage. */
+		fr->bsbufold = fr->bsbuf_lent ? fr->bsspace[(fr->bsnum+1)&1]+512 : fr->bsbuf;
+		fr->bsbuf = view != NULL ? view : newbuf;
+		fr->bsbuf_lent = view != NULL;
 	}
 	fr->bsnum = (fr->bsnum + 1) & 1;
 
@@ -626,6 +646,9 @@ init_resync:
 	   but only do so when we are sure that the frame number is accurate... */
 	if((fr->state_flags & FRAME_ACCURATE) && FI_NEXT(fr->index, fr->num))
 	fi_add(&fr->index, framepos);
+	if( (fr->p.flags & MPG123_EXACT_INDEX) && (fr->state_flags & FRAME_ACCURATE)
+	 && EI_NEXT(fr->exact, fr->num) && ei_add(&fr->exact, framepos) && NOQUIET )
+	error("Out of memory for exact frame index, seeking beyond here will be slower.");
 #endif
 
 	if(fr->silent_resync > 0) --fr->silent_resync;
@@ -876,6 +899,35 @@ static int decode_header(mpg123_handle *fr,unsigned long newhead, int *freeforma
 	return PARSE_GOOD;
 }
 
+/*
+	Skip over the frame body, failing like reading it would for a frame that is cut off
+	at the end of the file (filelen does not count an ID3v1 tag there).
+*/
+static int skip_frame_body(mpg123_handle *fr)
+{
+	off_t end = fr->rd->tell(fr) + fr->framesize;
+	off_t size = fr->rdat.filelen + ((fr->rdat.flags & READER_ID3TAG) ? 128 : 0);
+
+	if(fr->rdat.filelen < 0 || end > size) return READER_MORE;
+	if(fr->rd->skip_bytes(fr, fr->framesize) != end) return READER_ERROR;
+
+	return fr->framesize;
+}
+
+/*
+	Set up the frame properties from the header of a frame that was read elsewhere,
+	as if it had just been parsed. For free format, fr->freeformat_framesize has to be
+	known already, there is no following header to guess it from.
+*/
+int read_frame_restore(mpg123_handle *fr, unsigned long head)
+{
+	int freeformat_count = 0;
+
+	if(!head_check(head) || (!(head & HDR_BITRATE) && fr->freeformat_framesize < 0))
+	return -1;
+	return decode_header(fr, head, &freeformat_count) == PARSE_GOOD ? 0 : -1;
+}
+
 void set_pointer(mpg123_handle *fr, long backstep)
 {
 	fr->wordpointer = fr->bsbuf + fr->ssize - backstep;
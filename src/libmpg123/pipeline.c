@@ -0,0 +1,203 @@
+/*
+	pipeline: layer 3 synthesis on a second thread
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	See pipeline.h for the idea. The synth thread owns fr->buffer and the synth state
+	(fr->bo, real_buffs) while there is queued work; the decoder thread only touches
+	bitstream, scale factors, hybrid_in, the overlap-add blocks of III_hybrid() and the
+	equalizer, which is applied to the hybrid output before it is queued.
+	pipeline_sync() at the end of each frame makes the handle whole again before
+	anything else sees it.
+*/
+
+#include "mpg123lib_intern.h"
+#include "pipeline.h"
+#include "debug.h"
+
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+
+#include <pthread.h>
+
+struct pipeline
+{
+	mpg123_handle *fr;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t work; /* signals the synth thread: new block or quit */
+	pthread_cond_t done; /* signals the decoder: block finished */
+	void *mem;
+	real (*slot[PIPELINE_SLOTS])[SSLIMIT][SBLIMIT];
+	int stereo[PIPELINE_SLOTS];
+	/* Running counters: head = blocks queued, tail = blocks synthesized.
+	   Both only grow, head-tail is the fill of the ring. */
+	unsigned int head;
+	unsigned int tail;
+	int clip;
+	int quit;
+};
+
+static void *pipeline_synth(void *arg)
+{
+	struct pipeline *pl = arg;
+	mpg123_handle *fr = pl->fr;
+
+	pthread_mutex_lock(&pl->lock);
+	while(1)
+	{
+		unsigned int s;
+		int ss, clip = 0;
+		real (*hybridOut)[SSLIMIT][SBLIMIT];
+
+		while(pl->tail == pl->head && !pl->quit)
+		pthread_cond_wait(&pl->work, &pl->lock);
+		/* Queued work is always finished before quitting. */
+		if(pl->tail == pl->head) break;
+
+		s = pl->tail % PIPELINE_SLOTS;
+		hybridOut = pl->slot[s];
+		pthread_mutex_unlock(&pl->lock);
+
+		if(pl->stereo[s])
+		for(ss=0;ss<SSLIMIT;ss++)
+		clip += (fr->synth_stereo)(hybridOut[0][ss], hybridOut[1][ss], fr);
+		else
+		for(ss=0;ss<SSLIMIT;ss++)
+		clip += (fr->synth_mono)(hybridOut[0][ss], fr);
+
+		pthread_mutex_lock(&pl->lock);
+		pl->clip += clip;
+		++pl->tail;
+		pthread_cond_signal(&pl->done);
+	}
+	pthread_mutex_unlock(&pl->lock);
+	return NULL;
+}
+
+static struct pipeline *pipeline_new(mpg123_handle *fr)
+{
+	int i;
+	uintptr_t aoff;
+	real *block;
+	struct pipeline *pl = malloc(sizeof(struct pipeline));
+	if(pl == NULL) return NULL;
+
+	pl->fr = fr;
+	pl->head = pl->tail = 0;
+	pl->clip = 0;
+	pl->quit = 0;
+	/* Same 64 byte alignment as fr->layer3.hybrid_out in the layerscratch. */
+	pl->mem = malloc(sizeof(real)*PIPELINE_SLOTS*2*SSLIMIT*SBLIMIT+63);
+	if(pl->mem == NULL)
+	{
+		free(pl);
+		return NULL;
+	}
+	aoff = (uintptr_t)(char*)pl->mem % 64;
+	block = (real*)(aoff ? (char*)pl->mem+64-aoff : (char*)pl->mem);
+	for(i=0; i<PIPELINE_SLOTS; ++i)
+	{
+		pl->slot[i] = (real (*)[SSLIMIT][SBLIMIT]) block;
+		pl->stereo[i] = 0;
+		block += 2*SSLIMIT*SBLIMIT;
+	}
+
+	if(pthread_mutex_init(&pl->lock, NULL))
+	goto new_fail_mutex;
+	if(pthread_cond_init(&pl->work, NULL))
+	goto new_fail_work;
+	if(pthread_cond_init(&pl->done, NULL))
+	goto new_fail_done;
+	if(pthread_create(&pl->thread, NULL, pipeline_synth, pl))
+	goto new_fail_thread;
+
+	return pl;
+
+new_fail_thread:
+	pthread_cond_destroy(&pl->done);
+new_fail_done:
+	pthread_cond_destroy(&pl->work);
+new_fail_work:
+	pthread_mutex_destroy(&pl->lock);
+new_fail_mutex:
+	free(pl->mem);
+	free(pl);
+	return NULL;
+}
+
+struct pipeline* pipeline_use(mpg123_handle *fr)
+{
+	if(!(fr->p.flags & MPG123_PIPELINE)) return NULL;
+	/* The i486 synth works on the whole granule at once, no gain in splitting that. */
+#ifdef OPT_I486
+	if(fr->cpu_opts.type == ivier) return NULL;
+#endif
+	if(fr->pipeline == NULL && !fr->pipeline_failed)
+	{
+		fr->pipeline = pipeline_new(fr);
+		if(fr->pipeline == NULL)
+		{
+			/* Do not try again for each frame. */
+			fr->pipeline_failed = 1;
+			if(NOQUIET) error("Unable to start synth thread, decoding without pipeline.");
+		}
+	}
+	return fr->pipeline;
+}
+
+real (*pipeline_slot(struct pipeline *pl))[SSLIMIT][SBLIMIT]
+{
+	real (*block)[SSLIMIT][SBLIMIT];
+
+	pthread_mutex_lock(&pl->lock);
+	while(pl->head - pl->tail >= PIPELINE_SLOTS)
+	pthread_cond_wait(&pl->done, &pl->lock);
+	block = pl->slot[pl->head % PIPELINE_SLOTS];
+	pthread_mutex_unlock(&pl->lock);
+	return block;
+}
+
+void pipeline_push(struct pipeline *pl, int stereo)
+{
+	pthread_mutex_lock(&pl->lock);
+	pl->stereo[pl->head % PIPELINE_SLOTS] = stereo;
+	++pl->head;
+	pthread_cond_signal(&pl->work);
+	pthread_mutex_unlock(&pl->lock);
+}
+
+int pipeline_sync(struct pipeline *pl)
+{
+	int clip;
+
+	pthread_mutex_lock(&pl->lock);
+	while(pl->tail != pl->head)
+	pthread_cond_wait(&pl->done, &pl->lock);
+	clip = pl->clip;
+	pl->clip = 0;
+	pthread_mutex_unlock(&pl->lock);
+	return clip;
+}
+
+void pipeline_exit(mpg123_handle *fr)
+{
+	struct pipeline *pl = fr->pipeline;
+	if(pl == NULL) return;
+
+	pthread_mutex_lock(&pl->lock);
+	pl->quit = 1;
+	pthread_cond_signal(&pl->work);
+	pthread_mutex_unlock(&pl->lock);
+	pthread_join(pl->thread, NULL);
+
+	pthread_cond_destroy(&pl->done);
+	pthread_cond_destroy(&pl->work);
+	pthread_mutex_destroy(&pl->lock);
+	free(pl->mem);
+	free(pl);
+	fr->pipeline = NULL;
+	fr->pipeline_failed = 0;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*
+	pipeline: layer 3 synthesis on a second thread
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	With MPG123_PIPELINE set, do_layer3() hands the hybrid output of each granule over
+	to a synth thread and continues with scale factors, Huffman decoding and the hybrid
+	filter bank of the next granule meanwhile.
+	The hand-over happens via a small ring of hybrid_out blocks. The frame is finished only
+	after the synth thread caught up, so the output is exactly the same as without it.
+*/
+
+#ifndef MPG123_PIPELINE_H
+#define MPG123_PIPELINE_H
+
+#include "frame.h"
+
+/* Number of hybrid_out blocks in the ring, one for each granule of a MPEG 1 frame. */
+#define PIPELINE_SLOTS 2
+
+struct pipeline;
+
+#if !defined(NO_THREADS) && !defined(NO_LAYER3)
+/* Return the pipeline to use for the current frame, starting the synth thread on first use.
+   NULL means: decode serially (flag not set, unsupported decoder or no thread available). */
+struct pipeline* pipeline_use(mpg123_handle *fr);
+/* Get the next free hybrid_out block, waiting for the synth thread to release one. */
+real (*pipeline_slot(struct pipeline *pl))[SSLIMIT][SBLIMIT];
+/* Queue the block from the last pipeline_slot() for synthesis of SSLIMIT sample blocks. */
+void pipeline_push(struct pipeline *pl, int stereo);
+/* Wait until all queued blocks are synthesized, return the accumulated clip count. */
+int pipeline_sync(struct pipeline *pl);
+/* Stop the synth thread and free everything. */
+void pipeline_exit(mpg123_handle *fr);
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/*
+	planar: stereo output with one plane per channel
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	With MPG123_PLANAR, the samples of a decoded frame are stored as all left ones,
+	then all right ones, instead of interleaved. The synth functions selected for the
+	output format (generic or assembly, resampling, 8 bit wrapping) stay as they are:
+	they are wrapped to write the output of one call (32 samples per channel, up to
+	NTOM_MAX times that with NtoM) into a small block on the stack, which is then
+	sorted into the planes while it is still in cache. That is instead of another
+	pass over the whole buffer, or a second version of every synth.
+
+	decode_the_frame() sets fr->buffer.plane, the distance of the planes, to the size
+	of one channel of the whole frame. Channel c of what is in the buffer starts at
+	fr->buffer.p + c*fr->buffer.plane, with fr->buffer.fill/2 bytes.
+*/
+
+#include "mpg123lib_intern.h"
+#include "debug.h"
+
+/* Put one interleaved block of <bytes> behind what is in the planes already. */
+static void planar_sort(mpg123_handle *fr, const unsigned char *block, size_t bytes)
+{
+	size_t size = fr->af.dec_encsize;
+	size_t n = bytes/(2*size);
+	unsigned char *left  = fr->buffer.data + fr->buffer.fill/2;
+	unsigned char *right = left + fr->buffer.plane;
+	size_t i;
+
+	switch(size)
+	{
+		case 1:
+			for(i=0; i<n; ++i)
+			{
+				left[i]  = block[2*i];
+				right[i] = block[2*i+1];
+			}
+		break;
+		case 2:
+		{
+			const int16_t *in = (const int16_t*)block;
+			int16_t *l = (int16_t*)left;
+			int16_t *r = (int16_t*)right;
+			for(i=0; i<n; ++i)
+			{
+				l[i] = in[2*i];
+				r[i] = in[2*i+1];
+			}
+		}
+		break;
+		case 4:
+		{
+			const int32_t *in = (const int32_t*)block;
+			int32_t *l = (int32_t*)left;
+			int32_t *r = (int32_t*)right;
+			for(i=0; i<n; ++i)
+			{
+				l[i] = in[2*i];
+				r[i] = in[2*i+1];
+			}
+		}
+		break;
+		default: /* Packed 24 bit, double. */
+			for(i=0; i<n; ++i)
+			{
+				memcpy(left+i*size,  block+2*i*size,      size);
+				memcpy(right+i*size, block+(2*i+1)*size, size);
+			}
+	}
+	fr->buffer.fill += bytes;
+}
+
+/* Run the wrapped synth on the block instead of the output buffer, then sort its output into the planes.
+   No sample is bigger than real, so 32*NTOM_MAX of those per channel hold the output of any synth call. */
+#define PLANAR_SYNTH(fr, call) \
+{ \
+	ALIGNED(16) real block[2*32*NTOM_MAX]; \
+	unsigned char *planar_data = fr->buffer.data; \
+	size_t planar_fill = fr->buffer.fill; \
+	size_t bytes; \
+	fr->buffer.data = (unsigned char*)block; \
+	fr->buffer.fill = 0; \
+	clip = call; \
+	bytes = fr->buffer.fill; \
+	fr->buffer.data = planar_data; \
+	fr->buffer.fill = planar_fill; \
+	planar_sort(fr, (unsigned char*)block, bytes); \
+}
+
+int synth_planar_stereo(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	int clip;
+	PLANAR_SYNTH(fr, (fr->planar_stereo)(bandPtr_l, bandPtr_r, fr))
+	return clip;
+}
+
+int synth_planar_m2s(real *bandPtr, mpg123_handle *fr)
+{
+	int clip;
+	PLANAR_SYNTH(fr, (fr->planar_mono)(bandPtr, fr))
+	return clip;
+}
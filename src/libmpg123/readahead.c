@@ -0,0 +1,242 @@
+/*
+	readahead: reading the input stream on a second thread
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	See readahead.h for the idea. The ring is written by the thread only at
+	rpos+fill, the decoder only reads (or skips) at rpos, so the copying happens
+	outside the lock. Seeks that are no skip inside the ring go to the thread as a
+	command while the decoder waits, the thread being the only one doing actual I/O.
+*/
+
+#include "mpg123lib_intern.h"
+#include "readahead.h"
+#include "debug.h"
+
+#ifndef NO_THREADS
+
+#include <pthread.h>
+
+/* Read that much at most in one go, so that the decoder gets going after a seek. */
+#define READAHEAD_CHUNK 65536
+
+enum readahead_cmd { RA_NONE = 0, RA_SEEK, RA_QUIT };
+
+struct readahead
+{
+	struct reader_data *rdat;
+	ssize_t (*read)(struct reader_data *, void *, size_t);
+	off_t   (*seek)(struct reader_data *, off_t, int);
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake; /* signals the thread: space or command */
+	pthread_cond_t done; /* signals the decoder: data or command finished */
+	unsigned char *data;
+	size_t size;
+	size_t rpos; /* where the decoder reads next */
+	size_t fill; /* bytes ready from there on */
+	off_t pos;   /* stream position of rpos */
+	int end;     /* 1: end of stream, -1: read error, after the data in the ring */
+	int err;     /* errno of the failed read or seek */
+	int cmd;
+	off_t offset;
+	int whence;
+	off_t result;
+};
+
+static void *readahead_thread(void *arg)
+{
+	struct readahead *ra = arg;
+
+	pthread_mutex_lock(&ra->lock);
+	while(1)
+	{
+		size_t wpos, piece;
+		ssize_t got;
+
+		while(ra->cmd == RA_NONE && (ra->fill == ra->size || ra->end))
+		pthread_cond_wait(&ra->wake, &ra->lock);
+		if(ra->cmd == RA_QUIT) break;
+		if(ra->cmd == RA_SEEK)
+		{
+			ra->result = ra->seek(ra->rdat, ra->offset, ra->whence);
+			if(ra->result >= 0)
+			{
+				ra->rpos = ra->fill = 0;
+				ra->pos = ra->result;
+				ra->end = 0;
+			}
+			else ra->err = errno;
+			ra->cmd = RA_NONE;
+			pthread_cond_signal(&ra->done);
+			continue;
+		}
+
+		wpos = (ra->rpos + ra->fill) % ra->size;
+		piece = ra->size - ra->fill;
+		if(piece > ra->size - wpos) piece = ra->size - wpos;
+		if(piece > READAHEAD_CHUNK) piece = READAHEAD_CHUNK;
+		pthread_mutex_unlock(&ra->lock);
+		errno = 0;
+		got = ra->read(ra->rdat, ra->data+wpos, piece);
+		pthread_mutex_lock(&ra->lock);
+		if(got > 0)
+		ra->fill += got;
+		else if(got < 0 && errno == EINTR)
+		continue;
+		else
+		{
+			ra->end = got < 0 ? -1 : 1;
+			ra->err = errno;
+			debug1("readahead stopped with %i", ra->end);
+		}
+		pthread_cond_signal(&ra->done);
+	}
+	pthread_mutex_unlock(&ra->lock);
+	return NULL;
+}
+
+struct readahead* readahead_new( struct reader_data *rdat, size_t size
+,	ssize_t (*read)(struct reader_data *, void *, size_t)
+,	off_t (*seek)(struct reader_data *, off_t, int) )
+{
+	struct readahead *ra = malloc(sizeof(struct readahead));
+	if(ra == NULL) return NULL;
+
+	ra->rdat = rdat;
+	ra->read = read;
+	ra->seek = seek;
+	ra->size = size;
+	ra->rpos = ra->fill = 0;
+	/* Continue where the stream is, or just count from here on. */
+	ra->pos = seek(rdat, 0, SEEK_CUR);
+	if(ra->pos < 0) ra->pos = 0;
+	ra->end = 0;
+	ra->err = 0;
+	ra->cmd = RA_NONE;
+	ra->data = malloc(size);
+	if(ra->data == NULL)
+	{
+		free(ra);
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&ra->lock, NULL))
+	goto new_fail_mutex;
+	if(pthread_cond_init(&ra->wake, NULL))
+	goto new_fail_wake;
+	if(pthread_cond_init(&ra->done, NULL))
+	goto new_fail_done;
+	if(pthread_create(&ra->thread, NULL, readahead_thread, ra))
+	goto new_fail_thread;
+
+	debug1("readahead with %"SIZE_P" bytes", (size_p)size);
+	return ra;
+
+new_fail_thread:
+	pthread_cond_destroy(&ra->done);
+new_fail_done:
+	pthread_cond_destroy(&ra->wake);
+new_fail_wake:
+	pthread_mutex_destroy(&ra->lock);
+new_fail_mutex:
+	free(ra->data);
+	free(ra);
+	return NULL;
+}
+
+ssize_t readahead_read(struct readahead *ra, void *buf, size_t count)
+{
+	size_t piece;
+
+	pthread_mutex_lock(&ra->lock);
+	while(!ra->fill && !ra->end)
+	pthread_cond_wait(&ra->done, &ra->lock);
+	piece = ra->fill;
+	if(piece > ra->size - ra->rpos) piece = ra->size - ra->rpos;
+	if(piece > count) piece = count;
+	if(!piece)
+	{
+		ssize_t ret = 0;
+		if(ra->end < 0)
+		{
+			errno = ra->err;
+			ret = -1;
+		}
+		pthread_mutex_unlock(&ra->lock);
+		return ret;
+	}
+	pthread_mutex_unlock(&ra->lock);
+
+	memcpy(buf, ra->data+ra->rpos, piece);
+
+	pthread_mutex_lock(&ra->lock);
+	ra->rpos = (ra->rpos + piece) % ra->size;
+	ra->fill -= piece;
+	ra->pos  += piece;
+	pthread_cond_signal(&ra->wake);
+	pthread_mutex_unlock(&ra->lock);
+	return (ssize_t)piece;
+}
+
+off_t readahead_seek(struct readahead *ra, off_t offset, int whence)
+{
+	off_t ret;
+
+	pthread_mutex_lock(&ra->lock);
+	if(whence != SEEK_END)
+	{
+		off_t target = whence == SEEK_CUR ? ra->pos + offset : offset;
+		/* Inside the ring, just skip there. */
+		if(target >= ra->pos && target <= ra->pos + (off_t)ra->fill)
+		{
+			size_t skip = (size_t)(target - ra->pos);
+			ra->rpos = (ra->rpos + skip) % ra->size;
+			ra->fill -= skip;
+			ra->pos   = target;
+			pthread_cond_signal(&ra->wake);
+			pthread_mutex_unlock(&ra->lock);
+			return target;
+		}
+		/* The actual stream position is ahead of ours. */
+		offset = target;
+		whence = SEEK_SET;
+	}
+	/* Do not wait for a slow stream just to fail. */
+	if(!(ra->rdat->flags & READER_SEEKABLE))
+	{
+		pthread_mutex_unlock(&ra->lock);
+		errno = ESPIPE;
+		return -1;
+	}
+	ra->offset = offset;
+	ra->whence = whence;
+	ra->cmd = RA_SEEK;
+	pthread_cond_signal(&ra->wake);
+	while(ra->cmd != RA_NONE)
+	pthread_cond_wait(&ra->done, &ra->lock);
+	ret = ra->result;
+	if(ret < 0) errno = ra->err;
+	pthread_mutex_unlock(&ra->lock);
+	return ret;
+}
+
+void readahead_del(struct readahead *ra)
+{
+	if(ra == NULL) return;
+
+	pthread_mutex_lock(&ra->lock);
+	ra->cmd = RA_QUIT;
+	pthread_cond_signal(&ra->wake);
+	pthread_mutex_unlock(&ra->lock);
+	pthread_join(ra->thread, NULL);
+
+	pthread_cond_destroy(&ra->done);
+	pthread_cond_destroy(&ra->wake);
+	pthread_mutex_destroy(&ra->lock);
+	free(ra->data);
+	free(ra);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+	readahead: reading the input stream on a second thread
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	With MPG123_READAHEAD set, the stream readers do not call read() (or the replaced
+	reader functions) themselves. A thread keeps a ring of that many bytes filled from
+	the stream and the decoder just copies from there, waiting only if the thread did
+	not keep up. Seeks within the data that is already there are free, others are handed
+	to the thread, which drops the ring and continues at the new position.
+*/
+
+#ifndef MPG123_READAHEAD_H
+#define MPG123_READAHEAD_H
+
+#include "reader.h"
+
+struct readahead;
+
+#ifndef NO_THREADS
+/* Start the thread on the opened stream, with read and seek being the actual I/O.
+   NULL means: read normally (no memory or no thread available). */
+struct readahead* readahead_new( struct reader_data *rdat, size_t size
+,	ssize_t (*read)(struct reader_data *, void *, size_t)
+,	off_t (*seek)(struct reader_data *, off_t, int) );
+/* Same semantics as read() and lseek(), also for the error return. */
+ssize_t readahead_read(struct readahead *ra, void *buf, size_t count);
+off_t readahead_seek(struct readahead *ra, off_t offset, int whence);
+/* Stop the thread and free everything. */
+void readahead_del(struct readahead *ra);
+#endif
+
+#endif
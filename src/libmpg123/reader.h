@@ -12,6 +12,12 @@
 #include "config.h"
 #include "mpg123.h"
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define READ_MMAP
+#endif
+
+struct readahead;
+
 #ifndef NO_FEEDER
 struct buffy
 {
@@ -19,6 +25,10 @@ struct buffy
 	ssize_t size;
 	ssize_t realsize;
 	struct buffy *next;
+	/* Lent buffers: data belongs to the client and is handed back via release(). */
+	int lent;
+	void (*release)(void *handle, const unsigned char *data, size_t size);
+	void *releasehandle;
 };
 
 
@@ -77,6 +87,13 @@ struct reader_data
 #ifndef NO_FEEDER
 	struct bufferchain buffer; /* Not dynamically allocated, these few struct bytes aren't worth the trouble. */
 #endif
+#ifdef READ_MMAP
+	unsigned char *map; /* the whole file for the mmap reader */
+	size_t mapsize;
+#endif
+#ifndef NO_THREADS
+	struct readahead *readahead; /* MPG123_READAHEAD, doing the I/O if not NULL */
+#endif
 };
 
 /* start to use off_t to properly do LFS in future ... used to be long */
@@ -94,6 +111,8 @@ struct reader
 	off_t   (*tell)           (mpg123_handle *);
 	void    (*rewind)         (mpg123_handle *);
 	void    (*forget)         (mpg123_handle *);
+	/* Frame body of given size in place (advancing position), NULL to have it read into a buffer. */
+	unsigned char* (*frame_view)(mpg123_handle *, int size);
 };
 
 /* Open a file by path or use an opened file descriptor. */
@@ -105,8 +124,14 @@ int open_stream_handle(mpg123_handle *, void *iohandle);
 int open_feed(mpg123_handle *);
 /* externally called function, returns 0 on success, -1 on error */
 int  feed_more(mpg123_handle *fr, const unsigned char *in, long count);
+/* Append a lent buffer without copying, same return values as feed_more(). */
+int  feed_lend(mpg123_handle *fr, const unsigned char *in, long count
+,	void (*release)(void *, const unsigned char *, size_t), void *handle);
 void feed_forget(mpg123_handle *fr);  /* forget the data that has been read (free some buffers) */
 off_t feed_set_pos(mpg123_handle *fr, off_t pos); /* Set position (inside available data if possible), return wanted byte offset of next feed. */
+/* Copy the fed input that has not been parsed yet to out (if not NULL) without consuming it.
+   Returns the byte count, -1 if this is no feed reader. */
+ssize_t feed_pending(mpg123_handle *fr, unsigned char *out);
 
 void open_bad(mpg123_handle *);
 
@@ -123,12 +148,14 @@ void open_bad(mpg123_handle *);
 /* These two add a little buffering to enable small seeks for peek ahead. */
 #define READER_BUF_STREAM 3
 #define READER_BUF_ICY_STREAM 4
+/* Plain files via mmap(), with MPG123_MMAP. */
+#define READER_MMAP 5
 
 #ifdef READ_SYSTEM
-#define READER_SYSTEM 5
-#define READERS 6
+#define READER_SYSTEM 6
+#define READERS 7
 #else
-#define READERS 5
+#define READERS 6
 #endif
 
 #define READER_ERROR MPG123_ERR
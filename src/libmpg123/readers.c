@@ -22,6 +22,10 @@
 #ifdef _MSC_VER
 #include <io.h>
 #endif
+#ifdef READ_MMAP
+#include <sys/mman.h>
+#endif
+#include "readahead.h"
 
 #include "compat.h"
 #include "debug.h"
@@ -37,6 +41,8 @@ static ssize_t plain_fullread(mpg123_handle *fr,unsigned char *buf, ssize_t coun
 /* Wrapper to decide between descriptor-based and external handle-based I/O. */
 static off_t io_seek(struct reader_data *rdat, off_t offset, int whence);
 static ssize_t io_read(struct reader_data *rdat, void *buf, size_t count);
+static off_t direct_seek(struct reader_data *rdat, off_t offset, int whence);
+static ssize_t direct_read(struct reader_data *rdat, void *buf, size_t count);
 
 #ifndef NO_FEEDER
 /* Bufferchain methods. */
@@ -238,6 +244,11 @@ static off_t stream_lseek(mpg123_handle *fr, off_t pos, int whence)
 
 static void stream_close(mpg123_handle *fr)
 {
+#ifndef NO_THREADS
+	/* The thread is the one using the descriptor or handle. */
+	readahead_del(fr->rdat.readahead);
+	fr->rdat.readahead = NULL;
+#endif
 	if(fr->rdat.flags & READER_FD_OPENED) compat_close(fr->rdat.filept);
 
 	fr->rdat.filept = 0;
@@ -470,6 +481,7 @@ static struct buffy* buffy_new(size_t size, size_t minsize)
 	}
 	newbuf->size = 0;
 	newbuf->next = NULL;
+	newbuf->lent = 0;
 	return newbuf;
 }
 
@@ -477,7 +489,9 @@ static void buffy_del(struct buffy* buf)
 {
 	if(buf)
 	{
-		free(buf->data);
+		if(!buf->lent) free(buf->data);
+		else if(buf->release != NULL)
+		buf->release(buf->releasehandle, buf->data, (size_t)buf->size);
 		free(buf);
 	}
 }
@@ -542,7 +556,7 @@ static void bc_free(struct bufferchain *bc, struct buffy* buf)
 {
 	if(!buf) return;
 
-	if(bc->pool_fill < bc->pool_size)
+	if(!buf->lent && bc->pool_fill < bc->pool_size)
 	{
 		buf->next = bc->pool;
 		bc->pool = buf;
@@ -653,6 +667,34 @@ static int bc_add(struct bufferchain *bc, const unsigned char *data, ssize_t siz
 	return ret;
 }
 
+/*
+	Append a buffer of the client without copying. Being full (size == realsize),
+	it never gets data added by bc_add().
+*/
+static int bc_lend(struct bufferchain *bc, const unsigned char *data, ssize_t size
+,	void (*release)(void *, const unsigned char *, size_t), void *handle)
+{
+	struct buffy *newbuf;
+	if(size < 1) return -1;
+
+	newbuf = malloc(sizeof(struct buffy));
+	if(newbuf == NULL) return -2;
+	newbuf->data = (unsigned char*)data;
+	newbuf->size = newbuf->realsize = size;
+	newbuf->next = NULL;
+	newbuf->lent = 1;
+	newbuf->release = release;
+	newbuf->releasehandle = handle;
+
+	if(bc->last != NULL)  bc->last->next = newbuf;
+	else if(bc->first == NULL) bc->first = newbuf;
+
+	bc->last  = newbuf;
+	bc->size += size;
+	debug2("bc_lend: lent buffer %p with %"SSIZE_P" B", (void*)data, (ssize_p)size);
+	return 0;
+}
+
 /* Common handler for "You want more than I can give." situation. */
 static ssize_t bc_need_more(struct bufferchain *bc)
 {
@@ -700,6 +742,30 @@ static ssize_t bc_give(struct bufferchain *bc, unsigned char *out, ssize_t size)
 	return gotcount;
 }
 
+/*
+	Give some data in place, if it is inside one lent buffer that has at least
+	room bytes from the current position on. The decoders may read past the end
+	of a (broken) frame; the bitstream buffers have MAXFRAMESIZE room for that.
+*/
+static unsigned char *bc_view(struct bufferchain *bc, ssize_t size, ssize_t room)
+{
+	struct buffy *b = bc->first;
+	ssize_t offset = 0;
+	unsigned char *data;
+	if(bc->size - bc->pos < size) return NULL;
+
+	while(b != NULL && (offset + b->size) <= bc->pos)
+	{
+		offset += b->size;
+		b = b->next;
+	}
+	if(b == NULL || !b->lent || b->size - (bc->pos - offset) < room) return NULL;
+
+	data = b->data + (bc->pos - offset);
+	bc->pos += size;
+	return data;
+}
+
 /* Skip some bytes and return the new position.
    The buffers are still there, just the read pointer is moved! */
 static ssize_t bc_skip(struct bufferchain *bc, ssize_t count)
@@ -773,6 +839,38 @@ int feed_more(mpg123_handle *fr, const unsigned char *in, long count)
 	return ret;
 }
 
+int feed_lend(mpg123_handle *fr, const unsigned char *in, long count
+,	void (*release)(void *, const unsigned char *, size_t), void *handle)
+{
+	int ret = 0;
+	if(VERBOSE3) debug("feed_lend");
+	if((ret = bc_lend(&fr->rdat.buffer, in, count, release, handle)) != 0)
+	{
+		ret = READER_ERROR;
+		if(NOQUIET) error1("Failed to add buffer, return: %i", ret);
+	}
+	return ret;
+}
+
+static unsigned char *feed_frame_view(mpg123_handle *fr, int count)
+{
+	return bc_view(&fr->rdat.buffer, count, MAXFRAMESIZE);
+}
+
+/* The current frame may still get decoded after its lent buffer is gone. */
+static void feed_keep_frame(mpg123_handle *fr)
+{
+	unsigned char *buf;
+	if(!fr->bsbuf_lent) return;
+
+	/* That is where it would have been read to. */
+	buf = fr->bsspace[(fr->bsnum+1)&1]+512;
+	memcpy(buf, fr->bsbuf, fr->framesize);
+	fr->wordpointer = buf + (fr->wordpointer - fr->bsbuf);
+	fr->bsbuf = buf;
+	fr->bsbuf_lent = 0;
+}
+
 static ssize_t feed_read(mpg123_handle *fr, unsigned char *out, ssize_t count)
 {
 	ssize_t gotcount = bc_give(&fr->rdat.buffer, out, count);
@@ -818,6 +916,7 @@ off_t feed_set_pos(mpg123_handle *fr, off_t pos)
 	}
 	else
 	{ /* I expect to get the specific position on next feed. Forget what I have now. */
+		feed_keep_frame(fr);
 		bc_reset(bc);
 		bc->fileoff = pos;
 		debug1("feed_set_pos outside, buffer reset, next feed from %"OFF_P, (off_p)pos);
@@ -875,6 +974,12 @@ int feed_more(mpg123_handle *fr, const unsigned char *in, long count)
 	fr->err = MPG123_MISSING_FEATURE;
 	return -1;
 }
+int feed_lend(mpg123_handle *fr, const unsigned char *in, long count
+,	void (*release)(void *, const unsigned char *, size_t), void *handle)
+{
+	fr->err = MPG123_MISSING_FEATURE;
+	return -1;
+}
 off_t feed_set_pos(mpg123_handle *fr, off_t pos)
 {
 	fr->err = MPG123_MISSING_FEATURE;
@@ -882,6 +987,137 @@ off_t feed_set_pos(mpg123_handle *fr, off_t pos)
 }
 #endif /* NO_FEEDER */
 
+#ifdef READ_MMAP
+/*
+	The mmap reader works on the whole file mapped into memory, with filepos as the read
+	position. Headers are taken right from the mapping, Layer I/II frame bodies decoded in
+	place; the rest is a memcpy() instead of a read() call.
+*/
+
+/* Map the open file for the mmap reader. Returns 0 on success. */
+static int mmap_open(mpg123_handle *fr)
+{
+	struct stat st;
+	void *map;
+
+	if(fstat(fr->rdat.filept, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+	return -1;
+	/* Does it fit into the address space at all? */
+	if((off_t)(size_t)st.st_size != st.st_size) return -1;
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fr->rdat.filept, 0);
+	if(map == MAP_FAILED)
+	{
+		if(NOQUIET) error1("Cannot map file, reading it normally: %s", strerror(errno));
+		return -1;
+	}
+	/* Only hints, errors do not matter. */
+#ifdef MADV_SEQUENTIAL
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+	madvise(map, (size_t)st.st_size, MADV_WILLNEED);
+#endif
+	fr->rdat.map = map;
+	fr->rdat.mapsize = (size_t)st.st_size;
+	fr->rdat.filepos = 0;
+	debug1("mmap reader with %"SIZE_P" bytes", (size_p)fr->rdat.mapsize);
+	return 0;
+}
+
+static void mmap_close(mpg123_handle *fr)
+{
+	if(fr->rdat.map != NULL) munmap(fr->rdat.map, fr->rdat.mapsize);
+
+	fr->rdat.map = NULL;
+	fr->rdat.mapsize = 0;
+	stream_close(fr);
+}
+
+/* Bytes left from the current position, filepos can be beyond the end after skipping. */
+static size_t mmap_left(mpg123_handle *fr)
+{
+	return fr->rdat.filepos < (off_t)fr->rdat.mapsize
+	?	fr->rdat.mapsize - (size_t)fr->rdat.filepos : 0;
+}
+
+static ssize_t mmap_fullread(mpg123_handle *fr, unsigned char *buf, ssize_t count)
+{
+	size_t left = mmap_left(fr);
+	if((size_t)count > left) count = (ssize_t)left;
+	if(count <= 0) return 0;
+
+	memcpy(buf, fr->rdat.map+fr->rdat.filepos, count);
+	fr->rdat.filepos += count;
+	return count;
+}
+
+static int mmap_head_read(mpg123_handle *fr, unsigned long *newhead)
+{
+	unsigned char *hbuf;
+	if(mmap_left(fr) < 4) return FALSE;
+
+	hbuf = fr->rdat.map+fr->rdat.filepos;
+	*newhead = ((unsigned long) hbuf[0] << 24) |
+	           ((unsigned long) hbuf[1] << 16) |
+	           ((unsigned long) hbuf[2] << 8)  |
+	            (unsigned long) hbuf[3];
+	fr->rdat.filepos += 4;
+	return TRUE;
+}
+
+static int mmap_head_shift(mpg123_handle *fr, unsigned long *head)
+{
+	if(mmap_left(fr) < 1) return FALSE;
+
+	*head <<= 8;
+	*head |= fr->rdat.map[fr->rdat.filepos++];
+	*head &= 0xffffffff;
+	return TRUE;
+}
+
+/* Like lseek(), going beyond the end is fine, reading there just yields nothing. */
+static off_t mmap_skip_bytes(mpg123_handle *fr, off_t len)
+{
+	if(fr->rdat.filepos+len < 0)
+	{
+		fr->err = MPG123_LSEEK_FAILED;
+		return READER_ERROR;
+	}
+	return fr->rdat.filepos += len;
+}
+
+static int mmap_back_bytes(mpg123_handle *fr, off_t bytes)
+{
+	return mmap_skip_bytes(fr, -bytes) >= 0 ? 0 : READER_ERROR;
+}
+
+static void mmap_rewind(mpg123_handle *fr)
+{
+	fr->rdat.filepos = 0;
+}
+
+/* Same room for reading beyond the frame as in the bitstream buffers (see bc_view()). */
+static unsigned char *mmap_frame_view(mpg123_handle *fr, int count)
+{
+	unsigned char *data;
+	if(mmap_left(fr) < MAXFRAMESIZE) return NULL;
+
+	data = fr->rdat.map+fr->rdat.filepos;
+	fr->rdat.filepos += count;
+	return data;
+}
+#else
+#define mmap_close NULL
+#define mmap_fullread NULL
+#define mmap_head_read NULL
+#define mmap_head_shift NULL
+#define mmap_skip_bytes NULL
+#define mmap_back_bytes NULL
+#define mmap_rewind NULL
+#define mmap_frame_view NULL
+#endif /* READ_MMAP */
+
 /*****************************************************************
  * read frame helper
  */
@@ -905,6 +1141,7 @@ static void bad_rewind(mpg123_handle *mh){}
 #define READER_FEED       2
 #define READER_BUF_STREAM 3
 #define READER_BUF_ICY_STREAM 4
+#define READER_MMAP 5
 static struct reader readers[] =
 {
 	{ /* READER_STREAM */
@@ -919,6 +1156,7 @@ static struct reader readers[] =
 		stream_seek_frame,
 		generic_tell,
 		stream_rewind,
+		NULL,
 		NULL
 	} ,
 	{ /* READER_ICY_STREAM */
@@ -933,6 +1171,7 @@ static struct reader readers[] =
 		stream_seek_frame,
 		generic_tell,
 		stream_rewind,
+		NULL,
 		NULL
 	},
 #ifdef NO_FEEDER
@@ -943,6 +1182,7 @@ static struct reader readers[] =
 #define feed_back_bytes NULL
 #define feed_skip_bytes NULL
 #define buffered_forget NULL
+#define feed_frame_view NULL
 #endif
 	{ /* READER_FEED */
 		feed_init,
@@ -956,7 +1196,8 @@ static struct reader readers[] =
 		feed_seek_frame,
 		generic_tell,
 		stream_rewind,
-		buffered_forget
+		buffered_forget,
+		feed_frame_view
 	},
 	{ /* READER_BUF_STREAM */
 		default_init,
@@ -970,7 +1211,8 @@ static struct reader readers[] =
 		stream_seek_frame,
 		generic_tell,
 		stream_rewind,
-		buffered_forget
+		buffered_forget,
+		NULL
 	} ,
 	{ /* READER_BUF_ICY_STREAM */
 		default_init,
@@ -984,8 +1226,24 @@ static struct reader readers[] =
 		stream_seek_frame,
 		generic_tell,
 		stream_rewind,
-		buffered_forget
+		buffered_forget,
+		NULL
 	},
+	{ /* READER_MMAP */
+		default_init,
+		mmap_close,
+		mmap_fullread,
+		mmap_head_read,
+		mmap_head_shift,
+		mmap_skip_bytes,
+		generic_read_frame_body,
+		mmap_back_bytes,
+		stream_seek_frame,
+		generic_tell,
+		mmap_rewind,
+		NULL,
+		mmap_frame_view
+	}
 #ifdef READ_SYSTEM
 	,{
 		system_init,
@@ -1000,6 +1258,7 @@ static struct reader readers[] =
 		NULL,
 		NULL,
 		NULL,
+		NULL,
 	}
 #endif
 };
@@ -1017,6 +1276,7 @@ static struct reader bad_reader =
 	bad_seek_frame,
 	bad_tell,
 	bad_rewind,
+	NULL,
 	NULL
 };
 
@@ -1095,6 +1355,23 @@ static int default_init(mpg123_handle *fr)
 		fr->rdat.flags |= READER_BUFFERED;
 #endif /* NO_FEEDER */
 	}
+#ifdef READ_MMAP
+	/* Map plain files if wanted, only with our own descriptor I/O. Failure is no error. */
+	if(  (fr->p.flags & MPG123_MMAP) && fr->rd == &readers[READER_STREAM]
+	  && (fr->rdat.flags & READER_SEEKABLE)
+	  && !(fr->rdat.flags & (READER_HANDLEIO|READER_NONBLOCK))
+	  && fr->rdat.r_read == NULL && fr->rdat.r_lseek == NULL
+	  && mmap_open(fr) == 0 )
+	fr->rd = &readers[READER_MMAP];
+#endif
+#ifndef NO_THREADS
+	/* Read on a thread if wanted, but not what is mapped or read with a timeout.
+	   Failure is no error, it just stays the old way. */
+	if(  fr->p.readahead > 0 && fr->rd != &readers[READER_MMAP]
+	  && !(fr->rdat.flags & READER_NONBLOCK) )
+	fr->rdat.readahead = readahead_new( &fr->rdat, (size_t)fr->p.readahead
+	,	direct_read, direct_seek );
+#endif
 	return 0;
 }
 
@@ -1139,6 +1416,26 @@ int open_feed(mpg123_handle *fr)
 #endif /* NO_FEEDER */
 }
 
+ssize_t feed_pending(mpg123_handle *fr, unsigned char *out)
+{
+#ifdef NO_FEEDER
+	return -1;
+#else
+	struct bufferchain *bc = &fr->rdat.buffer;
+	ssize_t count;
+
+	if(fr->rd != &readers[READER_FEED]) return -1;
+	count = bc->size - bc->pos;
+	if(out != NULL && count > 0)
+	{
+		/* Give and take back, the parser still wants it. */
+		if(bc_give(bc, out, count) != count) return -1;
+		bc->pos -= count;
+	}
+	return count;
+#endif
+}
+
 /* Final code common to open_stream and open_stream_handle. */
 static int open_finish(mpg123_handle *fr)
 {
@@ -1206,7 +1503,7 @@ int open_stream_handle(mpg123_handle *fr, void *iohandle)
 }
 
 /* Wrappers for actual reading/seeking... I'm full of wrappers here. */
-static off_t io_seek(struct reader_data *rdat, off_t offset, int whence)
+static off_t direct_seek(struct reader_data *rdat, off_t offset, int whence)
 {
 	if(rdat->flags & READER_HANDLEIO)
 	{
@@ -1220,7 +1517,7 @@ static off_t io_seek(struct reader_data *rdat, off_t offset, int whence)
 	return rdat->lseek(rdat->filept, offset, whence);
 }
 
-static ssize_t io_read(struct reader_data *rdat, void *buf, size_t count)
+static ssize_t direct_read(struct reader_data *rdat, void *buf, size_t count)
 {
 	if(rdat->flags & READER_HANDLEIO)
 	{
@@ -1233,3 +1530,22 @@ static ssize_t io_read(struct reader_data *rdat, void *buf, size_t count)
 	else
 	return rdat->read(rdat->filept, buf, count);
 }
+
+/* ... and one more, for the read-ahead thread doing the direct I/O. */
+static off_t io_seek(struct reader_data *rdat, off_t offset, int whence)
+{
+#ifndef NO_THREADS
+	if(rdat->readahead != NULL)
+	return readahead_seek(rdat->readahead, offset, whence);
+#endif
+	return direct_seek(rdat, offset, whence);
+}
+
+static ssize_t io_read(struct reader_data *rdat, void *buf, size_t count)
+{
+#ifndef NO_THREADS
+	if(rdat->readahead != NULL)
+	return readahead_read(rdat->readahead, buf, count);
+#endif
+	return direct_read(rdat, buf, count);
+}
@@ -0,0 +1,335 @@
+/*
+	resample: windowed-sinc resampling on top of the float synth
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	With MPG123_RESAMPLE_SINC, the NtoM synth functions are replaced by the ones here.
+	They run the 1to1 float synth of the chosen decoder and feed its output through a
+	polyphase windowed-sinc (Kaiser) filter. When an output sample is due and how many there
+	are per frame is decided by the same ntom_val/ntom_step counting as in synth_ntom.h,
+	so frame offsets and buffer sizes work unchanged. The gapless cut is moved by the
+	filter delay, see resample_delay().
+
+	The filter has RESAMPLE_TAPS taps for conversion upwards, proportionally more (up to
+	RESAMPLE_MAXTAPS) for going downwards, where the cutoff follows the lower rate.
+	Output is delayed by half the filter length in input samples (32 for upsampling).
+	Coefficients for output times between the RESAMPLE_PHASES table rows are
+	interpolated linearly.
+*/
+
+#include "mpg123lib_intern.h"
+#include "sample.h"
+#include "debug.h"
+
+#ifdef SINC_RESAMPLE
+
+#define RESAMPLE_TAPS    64
+#define RESAMPLE_MAXTAPS 256
+#define RESAMPLE_PHASES  256
+/* Passband edge relative to the lower Nyquist frequency. The Kaiser window with that beta
+   (about 80 dB stopband) needs the rest of the way up to Nyquist as transition band. */
+#define RESAMPLE_CUTOFF  0.84
+#define RESAMPLE_BETA    8.0
+
+struct resampler
+{
+	long inrate;  /* rates the table is made for */
+	long outrate;
+	int taps;     /* filter length, multiple of 8 */
+	int format;   /* enum synth_format of the output */
+	real *coeff;  /* RESAMPLE_PHASES+1 rows of taps coefficients */
+	real *hist[2]; /* taps older samples, followed by the current synth block */
+	real *block;  /* interleaved float synth output for one block */
+};
+
+/* Modified Bessel function of first kind, order 0, for the Kaiser window. */
+static double bessel_i0(double x)
+{
+	double sum  = 1.;
+	double term = 1.;
+	int k;
+	for(k=1; k<64 && term > 1e-12*sum; ++k)
+	{
+		term *= (x/(2*k))*(x/(2*k));
+		sum  += term;
+	}
+	return sum;
+}
+
+/*
+	Row p is for output at p/RESAMPLE_PHASES of an input sample interval after the
+	middle of the filter. Each row is normalized to unit gain at DC, scaled to the short range
+	the WRITE_*_SAMPLE macros want.
+*/
+static void resample_table(struct resampler *rs)
+{
+	double ratio = (double)rs->outrate/rs->inrate;
+	/* Cutoff in the middle of the transition band, in cycles per input sample. */
+	double fc = (ratio < 1. ? ratio : 1.)*0.5*(1.+RESAMPLE_CUTOFF)/2.;
+	double half = rs->taps/2;
+	double norm = bessel_i0(RESAMPLE_BETA);
+	int p, k;
+
+	for(p=0; p<=RESAMPLE_PHASES; ++p)
+	{
+		real *c = rs->coeff + p*rs->taps;
+		double sum = 0.;
+		for(k=0; k<rs->taps; ++k)
+		{
+			double t = (double)p/RESAMPLE_PHASES + half - 1 - k;
+			double u = t/half;
+			double h = 0.;
+			if(u > -1. && u < 1.)
+			{
+				double x = 2.*fc*t;
+				h = 2.*fc * (x != 0. ? sin(M_PI*x)/(M_PI*x) : 1.)
+				*	bessel_i0(RESAMPLE_BETA*sqrt(1.-u*u))/norm;
+			}
+			c[k] = DOUBLE_TO_REAL(h);
+			sum += h;
+		}
+		for(k=0; k<rs->taps; ++k)
+		c[k] = DOUBLE_TO_REAL(REAL_TO_DOUBLE(c[k])*SHORT_SCALE/sum);
+	}
+}
+
+int resample_init(mpg123_handle *fr, int format)
+{
+	struct resampler *rs = fr->resampler;
+	long inrate  = frame_freq(fr);
+	long outrate = fr->af.rate;
+	int taps = RESAMPLE_TAPS;
+
+	if(outrate < inrate)
+	{
+		taps = (int)((double)RESAMPLE_TAPS*inrate/outrate + 7) & ~7;
+		if(taps > RESAMPLE_MAXTAPS) taps = RESAMPLE_MAXTAPS;
+	}
+	if(rs == NULL || rs->taps != taps || rs->inrate != inrate || rs->outrate != outrate)
+	{
+		resample_exit(fr);
+		/* One lump: struct, coefficients, history and synth block. */
+		rs = malloc( sizeof(struct resampler)
+		+	sizeof(real)*((RESAMPLE_PHASES+1)*taps + 2*(taps+32) + 2*32) );
+		if(rs == NULL)
+		{
+			if(NOQUIET) error("Unable to allocate memory for the resampler.");
+			fr->err = MPG123_OUT_OF_MEM;
+			return -1;
+		}
+		rs->inrate  = inrate;
+		rs->outrate = outrate;
+		rs->taps    = taps;
+		rs->coeff   = (real*)(rs+1);
+		rs->hist[0] = rs->coeff + (RESAMPLE_PHASES+1)*taps;
+		rs->hist[1] = rs->hist[0] + taps+32;
+		rs->block   = rs->hist[1] + taps+32;
+		resample_table(rs);
+		fr->resampler = rs;
+		debug3("resampler %li -> %li with %i taps", inrate, outrate, taps);
+	}
+	rs->format = format;
+	memset(rs->hist[0], 0, sizeof(real)*2*(taps+32));
+	return 0;
+}
+
+void resample_exit(mpg123_handle *fr)
+{
+	if(fr->resampler != NULL) free(fr->resampler);
+	fr->resampler = NULL;
+}
+
+/* The output at a given ntom crossing is for the input time half the filter length back. */
+int resample_delay(mpg123_handle *fr)
+{
+	if(fr->resampler == NULL || fr->down_sample != 3 || fr->p.resample != MPG123_RESAMPLE_SINC)
+	return 0;
+	return fr->resampler->taps/2;
+}
+
+void resample_dot(const real *x, const real *c, int taps, real *sums)
+{
+	const real *c1 = c+taps;
+	real s0 = 0;
+	real s1 = 0;
+	int k;
+	for(k=0; k<taps; ++k)
+	{
+		s0 += x[k]*c[k];
+		s1 += x[k]*c1[k];
+	}
+	sums[0] = s0;
+	sums[1] = s1;
+}
+
+/*
+	Append one block of synth output (32 samples, every step-th of in) to the history
+	of the channel and compute the output samples falling into it. Returns their number.
+	Same counting as the NtoM synth: an output sample is due whenever the ntom value
+	crosses NTOM_MUL, what is left over tells how far back in the input interval that was.
+*/
+static int resample_block(mpg123_handle *fr, int channel, real *in, int step, real *out)
+{
+	struct resampler *rs = fr->resampler;
+	real *x = rs->hist[channel];
+	unsigned long ntom = fr->ntom_val[channel];
+	int i, n = 0;
+
+	for(i=0; i<32; ++i) x[rs->taps+i] = in[i*step];
+	for(i=0; i<32; ++i)
+	{
+		ntom += fr->ntom_step;
+		while(ntom >= NTOM_MUL)
+		{
+			real sums[2];
+			real pos;
+			int p;
+
+			ntom -= NTOM_MUL;
+			/* Filter over x[i] to x[i+taps-1], the last one being input sample i-1 of the block. */
+			pos = (real)(fr->ntom_step-ntom)*RESAMPLE_PHASES/fr->ntom_step;
+			p = (int)pos;
+			if(p >= RESAMPLE_PHASES) p = RESAMPLE_PHASES-1;
+			pos -= p;
+			opt_resample_dot(fr)(x+i, rs->coeff+p*rs->taps, rs->taps, sums);
+			out[n++] = sums[0] + pos*(sums[1]-sums[0]);
+		}
+	}
+	fr->ntom_val[channel] = ntom;
+	memmove(x, x+32, sizeof(real)*rs->taps);
+	return n;
+}
+
+/* Store n samples for one channel into the output buffer (not advancing fill). */
+static int resample_write(mpg123_handle *fr, real *out, int n, int channel, int step)
+{
+	unsigned char *data = fr->buffer.data + fr->buffer.fill;
+	int clip = 0;
+	int i;
+
+	switch(fr->resampler->format)
+	{
+#ifndef NO_16BIT
+		case f_16:
+		{
+			short *samples = (short*)data + channel;
+			for(i=0; i<n; ++i, samples += step)
+			{
+				WRITE_SHORT_SAMPLE_ACCURATE(samples, out[i], clip);
+			}
+		}
+		break;
+#endif
+#ifndef NO_8BIT
+		case f_8:
+		{
+			unsigned char *samples = data + channel;
+			for(i=0; i<n; ++i, samples += step)
+			WRITE_8BIT_SAMPLE(samples, out[i], clip);
+		}
+		break;
+#endif
+		case f_real:
+		{
+			real *samples = (real*)data + channel;
+			for(i=0; i<n; ++i, samples += step)
+			WRITE_REAL_SAMPLE(samples, out[i], clip);
+		}
+		break;
+#ifndef NO_32BIT
+		case f_32:
+		{
+			int32_t *samples = (int32_t*)data + channel;
+			for(i=0; i<n; ++i, samples += step)
+			WRITE_S32_SAMPLE(samples, out[i], clip);
+		}
+		break;
+		case f_24:
+		{
+			struct s24_sample *samples = (struct s24_sample*)data + channel;
+			for(i=0; i<n; ++i, samples += step)
+			WRITE_S24_SAMPLE(samples, out[i], clip);
+		}
+		break;
+#endif
+	}
+	return clip;
+}
+
+static size_t resample_samplesize(mpg123_handle *fr)
+{
+	switch(fr->resampler->format)
+	{
+		case f_8:    return 1;
+		case f_real: return sizeof(real);
+		case f_32:   return 4;
+		case f_24:   return 3;
+		default:     return 2;
+	}
+}
+
+/* Run a 1to1 float synth function on the resampler block instead of the output buffer. */
+#define FLOAT_SYNTH(fr, call) \
+{ \
+	unsigned char *float_synth_data = fr->buffer.data; \
+	size_t float_synth_fill = fr->buffer.fill; \
+	fr->buffer.data = (unsigned char*)fr->resampler->block; \
+	fr->buffer.fill = 0; \
+	call; \
+	fr->buffer.data = float_synth_data; \
+	fr->buffer.fill = float_synth_fill; \
+}
+
+int synth_sinc(real *bandPtr, int channel, mpg123_handle *fr, int final)
+{
+	real out[32*NTOM_MAX];
+	int n, clip;
+
+	FLOAT_SYNTH(fr, (fr->synths.plain[r_1to1][f_real])(bandPtr, channel, fr, 0))
+	n = resample_block(fr, channel, fr->resampler->block+channel, 2, out);
+	clip = resample_write(fr, out, n, channel, 2);
+	if(final) fr->buffer.fill += 2*n*resample_samplesize(fr);
+	return clip;
+}
+
+int synth_sinc_stereo(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	real out[2][32*NTOM_MAX];
+	int n, clip;
+
+	FLOAT_SYNTH(fr, (fr->synths.stereo[r_1to1][f_real])(bandPtr_l, bandPtr_r, fr))
+	n = resample_block(fr, 0, fr->resampler->block,   2, out[0]);
+	    resample_block(fr, 1, fr->resampler->block+1, 2, out[1]);
+	clip  = resample_write(fr, out[0], n, 0, 2);
+	clip += resample_write(fr, out[1], n, 1, 2);
+	fr->buffer.fill += 2*n*resample_samplesize(fr);
+	return clip;
+}
+
+int synth_sinc_mono(real *bandPtr, mpg123_handle *fr)
+{
+	real out[32*NTOM_MAX];
+	int n, clip;
+
+	FLOAT_SYNTH(fr, (fr->synths.plain[r_1to1][f_real])(bandPtr, 0, fr, 0))
+	n = resample_block(fr, 0, fr->resampler->block, 2, out);
+	clip = resample_write(fr, out, n, 0, 1);
+	fr->buffer.fill += n*resample_samplesize(fr);
+	return clip;
+}
+
+int synth_sinc_m2s(real *bandPtr, mpg123_handle *fr)
+{
+	real out[32*NTOM_MAX];
+	int n, clip;
+
+	FLOAT_SYNTH(fr, (fr->synths.plain[r_1to1][f_real])(bandPtr, 0, fr, 0))
+	n = resample_block(fr, 0, fr->resampler->block, 2, out);
+	clip = resample_write(fr, out, n, 0, 2);
+	resample_write(fr, out, n, 1, 2);
+	fr->buffer.fill += 2*n*resample_samplesize(fr);
+	return clip;
+}
+
+#endif
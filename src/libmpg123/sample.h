@@ -136,6 +136,23 @@ static inline int16_t ftoi16(float x)
 		else { *(samples) = REAL_TO_S32(tmpsum); } \
 	}
 
+/* Packed 24 bit, the upper bytes of the 32 bit sample, xor fr->s24_flip for unsigned. */
+#ifdef WORDS_BIGENDIAN
+#define WRITE_S24_BYTES(samples,v) \
+	{ (samples)->b[0] = (unsigned char)((v)>>16); (samples)->b[1] = (unsigned char)((v)>>8); (samples)->b[2] = (unsigned char)(v); }
+#else
+#define WRITE_S24_BYTES(samples,v) \
+	{ (samples)->b[0] = (unsigned char)(v); (samples)->b[1] = (unsigned char)((v)>>8); (samples)->b[2] = (unsigned char)((v)>>16); }
+#endif
+#define WRITE_S24_SAMPLE(samples,sum,clip) \
+	{ \
+		int32_t write_s24_tmp; \
+		uint32_t write_s24_v; \
+		WRITE_S32_SAMPLE(&write_s24_tmp,sum,clip) \
+		write_s24_v = ((uint32_t)write_s24_tmp >> 8) ^ fr->s24_flip; \
+		WRITE_S24_BYTES(samples,write_s24_v) \
+	}
+
 /* Produce an 8bit sample, via 16bit intermediate. */
 #define WRITE_8BIT_SAMPLE(samples,sum,clip) \
 { \
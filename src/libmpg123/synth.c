@@ -25,8 +25,10 @@
 #define BLOCK 0x40 /* One decoding block is 64 samples. */
 
 #define SYNTH_NAME synth_1to1
+#define STEREO_NAME synth_1to1_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_1to1. */
 #define SYNTH_NAME       fr->synths.plain[r_1to1][f_16]
@@ -42,6 +44,7 @@
 
 #ifdef OPT_GENERIC_DITHER
 #define SYNTH_NAME synth_1to1_dither
+#define STEREO_NAME synth_1to1_dither_stereo
 /* We need the accurate sample writing... */
 #undef WRITE_SAMPLE
 #define WRITE_SAMPLE(samples,sum,clip) WRITE_SHORT_SAMPLE_ACCURATE(samples,sum,clip)
@@ -50,6 +53,7 @@
 #include "synth.h"
 #undef USE_DITHER
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 #undef WRITE_SAMPLE
 #define WRITE_SAMPLE(samples,sum,clip) WRITE_SHORT_SAMPLE(samples,sum,clip)
@@ -75,9 +79,6 @@ int synth_1to1_i586_asm(real *bandPtr, int channel, unsigned char *out, unsigned
 int synth_1to1_i586(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
 	int ret;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	ret = synth_1to1_i586_asm(bandPtr, channel, fr->buffer.data+fr->buffer.fill, fr->rawbuffs, &fr->bo, fr->decwin);
 	if(final) fr->buffer.fill += 128;
 	return ret;
@@ -86,15 +87,12 @@ int synth_1to1_i586(real *bandPtr, int channel, mpg123_handle *fr, int final)
 
 #ifdef OPT_I586_DITHER
 /* This is defined in assembler. */
-int synth_1to1_i586_asm_dither(real *bandPtr, int channel, unsigned char *out, unsigned char *buffs, int *bo, real *decwin, float *dithernoise);
+int synth_1to1_i586_asm_dither(real *bandPtr, int channel, unsigned char *out, unsigned char *buffs, int *bo, real *decwin, const float *dithernoise);
 /* This is just a hull to use the mpg123 handle. */
 int synth_1to1_i586_dither(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
 	int ret;
 	int bo_dither[2]; /* Temporary workaround? Could expand the asm code. */
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	/* Applying this hack, to change the asm only bit by bit (adding dithernoise pointer). */
 	bo_dither[0] = fr->bo;
 	bo_dither[1] = fr->ditherindex;
@@ -108,16 +106,12 @@ int synth_1to1_i586_dither(real *bandPtr, int channel, mpg123_handle *fr, int fi
 #endif
 
 #if defined(OPT_3DNOW) || defined(OPT_3DNOW_VINTAGE)
-/* Those are defined in assembler. */
-void do_equalizer_3dnow(real *bandPtr,int channel, real equalizer[2][32]);
+/* This is defined in assembler. */
 int synth_1to1_3dnow_asm(real *bandPtr, int channel, unsigned char *out, unsigned char *buffs, int *bo, real *decwin);
 /* This is just a hull to use the mpg123 handle. */
 int synth_1to1_3dnow(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
 	int ret;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer_3dnow(bandPtr,channel,fr->equalizer);
-#endif
 	/* this is in asm, can be dither or not */
 	/* uh, is this return from pointer correct? */ 
 	ret = (int) synth_1to1_3dnow_asm(bandPtr, channel, fr->buffer.data+fr->buffer.fill, fr->rawbuffs, &fr->bo, fr->decwin);
@@ -132,9 +126,6 @@ int synth_1to1_MMX(real *bandPtr, int channel, short *out, short *buffs, int *bo
 /* This is just a hull to use the mpg123 handle. */
 int synth_1to1_mmx(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	/* in asm */
 	synth_1to1_MMX(bandPtr, channel, (short*) (fr->buffer.data+fr->buffer.fill), (short *) fr->rawbuffs, &fr->bo, fr->decwins);
 	if(final) fr->buffer.fill += 128;
@@ -155,9 +146,6 @@ int synth_1to1_sse(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -197,13 +185,6 @@ int synth_1to1_stereo_sse(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -238,9 +219,6 @@ void synth_1to1_sse_asm(real *bandPtr, int channel, short *samples, short *buffs
 /* This is just a hull to use the mpg123 handle. */
 int synth_1to1_sse(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	synth_1to1_sse_asm(bandPtr, channel, (short*) (fr->buffer.data+fr->buffer.fill), (short *) fr->rawbuffs, &fr->bo, fr->decwins);
 	if(final) fr->buffer.fill += 128;
 	return 0;
@@ -254,9 +232,6 @@ void synth_1to1_3dnowext_asm(real *bandPtr, int channel, short *samples, short *
 /* This is just a hull to use the mpg123 handle. */
 int synth_1to1_3dnowext(real *bandPtr, int channel, mpg123_handle *fr, int final)
 {
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	synth_1to1_3dnowext_asm(bandPtr, channel, (short*) (fr->buffer.data+fr->buffer.fill), (short *) fr->rawbuffs, &fr->bo, fr->decwins);
 	if(final) fr->buffer.fill += 128;
 	return 0;
@@ -277,9 +252,6 @@ int synth_1to1_x86_64(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -319,13 +291,6 @@ int synth_1to1_stereo_x86_64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -366,9 +331,6 @@ int synth_1to1_x86_64(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	short *b0, **buf;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -407,13 +369,6 @@ int synth_1to1_stereo_x86_64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 	short *b0l, *b0r, **bufl, **bufr;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->short_buffs[0];
@@ -445,6 +400,103 @@ int synth_1to1_stereo_x86_64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 #endif
 #endif
 
+#ifdef OPT_X86_64_DITHER
+/* Assembler routines. */
+int synth_1to1_real_x86_64_asm(real *window, real *b0, real *samples, int bo1);
+int synth_1to1_real_s_x86_64_asm(real *window, real *b0l, real *b0r, real *samples, int bo1);
+int dither_s16_x86_64(short *samples, real *block, const float *noise, int channel);
+int dither_s16_s_x86_64(short *samples, real *block, const float *noise);
+#ifndef ACCURATE_ROUNDING
+void dct64_real_x86_64(real *out0, real *out1, real *samples);
+#endif
+/*
+	The float synth writes one block to the stack, which is turned into dithered
+	16 bit output with SIMD right away. Noise is used like synth_1to1_dither does.
+*/
+int synth_1to1_x86_64_dither(real *bandPtr,int channel, mpg123_handle *fr, int final)
+{
+	short *samples = (short *) (fr->buffer.data+fr->buffer.fill);
+	ALIGNED(16) real block[64];
+
+	real *b0, **buf;
+	int bo1;
+	int clip;
+	if(!channel)
+	{
+		fr->bo--;
+		fr->bo &= 0xf;
+		buf = fr->real_buffs[0];
+	}
+	else
+	{
+		fr->ditherindex -= 32;
+		buf = fr->real_buffs[1];
+	}
+	if(DITHERSIZE-fr->ditherindex < 32) fr->ditherindex = 0;
+
+	if(fr->bo & 0x1)
+	{
+		b0 = buf[0];
+		bo1 = fr->bo;
+		dct64_real_x86_64(buf[1]+((fr->bo+1)&0xf),buf[0]+fr->bo,bandPtr);
+	}
+	else
+	{
+		b0 = buf[1];
+		bo1 = fr->bo+1;
+		dct64_real_x86_64(buf[0]+fr->bo,buf[1]+fr->bo+1,bandPtr);
+	}
+
+	synth_1to1_real_x86_64_asm(fr->decwin, b0, block, bo1);
+	clip = dither_s16_x86_64(samples, block, fr->dithernoise+fr->ditherindex, channel);
+	fr->ditherindex += 32;
+
+	if(final) fr->buffer.fill += 128;
+
+	return clip;
+}
+
+int synth_1to1_stereo_x86_64_dither(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	short *samples = (short *) (fr->buffer.data+fr->buffer.fill);
+	ALIGNED(16) real block[64];
+
+	real *b0l, *b0r, **bufl, **bufr;
+	int bo1;
+	int clip;
+	fr->bo--;
+	fr->bo &= 0xf;
+	bufl = fr->real_buffs[0];
+	bufr = fr->real_buffs[1];
+	if(DITHERSIZE-fr->ditherindex < 32) fr->ditherindex = 0;
+
+	if(fr->bo & 0x1)
+	{
+		b0l = bufl[0];
+		b0r = bufr[0];
+		bo1 = fr->bo;
+		dct64_real_x86_64(bufl[1]+((fr->bo+1)&0xf),bufl[0]+fr->bo,bandPtr_l);
+		dct64_real_x86_64(bufr[1]+((fr->bo+1)&0xf),bufr[0]+fr->bo,bandPtr_r);
+	}
+	else
+	{
+		b0l = bufl[1];
+		b0r = bufr[1];
+		bo1 = fr->bo+1;
+		dct64_real_x86_64(bufl[0]+fr->bo,bufl[1]+fr->bo+1,bandPtr_l);
+		dct64_real_x86_64(bufr[0]+fr->bo,bufr[1]+fr->bo+1,bandPtr_r);
+	}
+
+	synth_1to1_real_s_x86_64_asm(fr->decwin, b0l, b0r, block, bo1);
+	clip = dither_s16_s_x86_64(samples, block, fr->dithernoise+fr->ditherindex);
+	fr->ditherindex += 32;
+
+	fr->buffer.fill += 128;
+
+	return clip;
+}
+#endif
+
 #ifdef OPT_AVX
 #ifdef ACCURATE_ROUNDING
 /* Assembler routines. */
@@ -461,9 +513,6 @@ int synth_1to1_avx(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -503,13 +552,6 @@ int synth_1to1_stereo_avx(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -552,9 +594,6 @@ int synth_1to1_avx(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	short *b0, **buf;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -593,13 +632,6 @@ int synth_1to1_stereo_avx(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 	short *b0l, *b0r, **bufl, **bufr;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->short_buffs[0];
@@ -643,9 +675,6 @@ int synth_1to1_arm(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -688,9 +717,6 @@ int synth_1to1_arm(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -739,9 +765,6 @@ int synth_1to1_neon(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -781,13 +804,6 @@ int synth_1to1_stereo_neon(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -828,9 +844,6 @@ int synth_1to1_neon(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	short *b0, **buf;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -869,13 +882,6 @@ int synth_1to1_stereo_neon(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 	short *b0l, *b0r, **bufl, **bufr;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->short_buffs[0];
@@ -921,9 +927,6 @@ int synth_1to1_neon64(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -963,13 +966,6 @@ int synth_1to1_stereo_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -1010,9 +1006,6 @@ int synth_1to1_neon64(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	short *b0, **buf;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -1051,13 +1044,6 @@ int synth_1to1_stereo_neon64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 	short *b0l, *b0r, **bufl, **bufr;
 	int clip; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->short_buffs[0];
@@ -1098,15 +1084,19 @@ int synth_1to1_stereo_neon64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x20 /* One decoding block is 32 samples. */
 
 #define SYNTH_NAME synth_2to1
+#define STEREO_NAME synth_2to1_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 #ifdef OPT_DITHER /* Used for generic_dither and as fallback for i586_dither. */
 #define SYNTH_NAME synth_2to1_dither
+#define STEREO_NAME synth_2to1_dither_stereo
 #define USE_DITHER
 #include "synth.h"
 #undef USE_DITHER
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #endif
 
 #define SYNTH_NAME       fr->synths.plain[r_2to1][f_16]
@@ -1135,15 +1125,19 @@ int synth_1to1_stereo_neon64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x10 /* One decoding block is 16 samples. */
 
 #define SYNTH_NAME synth_4to1
+#define STEREO_NAME synth_4to1_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 #ifdef OPT_DITHER
 #define SYNTH_NAME synth_4to1_dither
+#define STEREO_NAME synth_4to1_dither_stereo
 #define USE_DITHER
 #include "synth.h"
 #undef USE_DITHER
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #endif
 
 #define SYNTH_NAME       fr->synths.plain[r_4to1][f_16] /* This is just for the _i386 one... gotta check if it is really useful... */
@@ -1175,10 +1169,12 @@ int synth_1to1_stereo_neon64(real *bandPtr_l,real *bandPtr_r, mpg123_handle *fr)
 
 /* These are all in one header, there's no flexibility to gain. */
 #define SYNTH_NAME       synth_ntom
+#define STEREO_NAME      synth_ntom_stereo
 #define MONO_NAME        synth_ntom_mono
 #define MONO2STEREO_NAME synth_ntom_m2s
 #include "synth_ntom.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #undef MONO_NAME
 #undef MONO2STEREO_NAME
 
@@ -8,6 +8,7 @@
 	This header is used multiple times to create different variants of these functions.
 	See decode.c and friends.
 	Hint: BLOCK, MONO_NAME, MONO2STEREO_NAME, SYNTH_NAME and SAMPLE_T as well as WRITE_SAMPLE do vary.
+	With STEREO_NAME defined, a variant that does both channels at once is added.
 
 	Thomas looked closely at the decode_1to1, decode_2to1 and decode_4to1 contents, seeing that they are too similar to be separate files.
 	This is what resulted...
@@ -36,9 +37,6 @@ int SYNTH_NAME(real *bandPtr, int channel, mpg123_handle *fr, int final)
 	real *b0, **buf; /* (*buf)[0x110]; */
 	int clip = 0; 
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -194,3 +192,171 @@ int SYNTH_NAME(real *bandPtr, int channel, mpg123_handle *fr, int final)
 #undef BACKPEDAL
 #undef MY_DCT64
 }
+
+#ifdef STEREO_NAME
+/*
+	Both channels in one go: The window coefficients are loaded once for the left
+	and right sums. Same sum order as two calls of SYNTH_NAME in the source, but
+	with -ffast-math the compiler is free to group the sums differently here.
+	Integer output does not notice; float output differs by rounding, up to about
+	1e-6 of full scale (which is a few 1e-3 relative to very quiet samples).
+*/
+int STEREO_NAME(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	static const int step = 2;
+	SAMPLE_T *samples = (SAMPLE_T *) (fr->buffer.data + fr->buffer.fill);
+
+	real *b0l, *b0r, **bufl, **bufr;
+	int clip = 0; 
+	int bo1;
+	fr->bo--;
+	fr->bo &= 0xf;
+	bufl = fr->real_buffs[0];
+	bufr = fr->real_buffs[1];
+#ifdef USE_DITHER
+	/* Both channels get the same noise, just like with SYNTH_NAME going back for the right one. */
+	if(DITHERSIZE-fr->ditherindex < 32) fr->ditherindex = 0;
+	#define ADD_DITHER(fr,suml,sumr) suml+=fr->dithernoise[fr->ditherindex]; sumr+=fr->dithernoise[fr->ditherindex]; fr->ditherindex += 64/BLOCK;
+#else
+	#define ADD_DITHER(fr,suml,sumr)
+#endif
+
+	if(fr->bo & 0x1)
+	{
+		b0l = bufl[0];
+		b0r = bufr[0];
+		bo1 = fr->bo;
+		dct64(bufl[1]+((fr->bo+1)&0xf),bufl[0]+fr->bo,bandPtr_l);
+		dct64(bufr[1]+((fr->bo+1)&0xf),bufr[0]+fr->bo,bandPtr_r);
+	}
+	else
+	{
+		b0l = bufl[1];
+		b0r = bufr[1];
+		bo1 = fr->bo+1;
+		dct64(bufl[0]+fr->bo,bufl[1]+fr->bo+1,bandPtr_l);
+		dct64(bufr[0]+fr->bo,bufr[1]+fr->bo+1,bandPtr_r);
+	}
+
+	{
+		register int j;
+		real *window = fr->decwin + 16 - bo1;
+
+		for(j=(BLOCK/4); j; j--, b0l+=0x400/BLOCK, b0r+=0x400/BLOCK, window+=0x800/BLOCK, samples+=step)
+		{
+			real suml, sumr;
+			suml = REAL_MUL_SYNTH(window[0x0], b0l[0x0]);
+			sumr = REAL_MUL_SYNTH(window[0x0], b0r[0x0]);
+			suml -= REAL_MUL_SYNTH(window[0x1], b0l[0x1]);
+			sumr -= REAL_MUL_SYNTH(window[0x1], b0r[0x1]);
+			suml += REAL_MUL_SYNTH(window[0x2], b0l[0x2]);
+			sumr += REAL_MUL_SYNTH(window[0x2], b0r[0x2]);
+			suml -= REAL_MUL_SYNTH(window[0x3], b0l[0x3]);
+			sumr -= REAL_MUL_SYNTH(window[0x3], b0r[0x3]);
+			suml += REAL_MUL_SYNTH(window[0x4], b0l[0x4]);
+			sumr += REAL_MUL_SYNTH(window[0x4], b0r[0x4]);
+			suml -= REAL_MUL_SYNTH(window[0x5], b0l[0x5]);
+			sumr -= REAL_MUL_SYNTH(window[0x5], b0r[0x5]);
+			suml += REAL_MUL_SYNTH(window[0x6], b0l[0x6]);
+			sumr += REAL_MUL_SYNTH(window[0x6], b0r[0x6]);
+			suml -= REAL_MUL_SYNTH(window[0x7], b0l[0x7]);
+			sumr -= REAL_MUL_SYNTH(window[0x7], b0r[0x7]);
+			suml += REAL_MUL_SYNTH(window[0x8], b0l[0x8]);
+			sumr += REAL_MUL_SYNTH(window[0x8], b0r[0x8]);
+			suml -= REAL_MUL_SYNTH(window[0x9], b0l[0x9]);
+			sumr -= REAL_MUL_SYNTH(window[0x9], b0r[0x9]);
+			suml += REAL_MUL_SYNTH(window[0xA], b0l[0xA]);
+			sumr += REAL_MUL_SYNTH(window[0xA], b0r[0xA]);
+			suml -= REAL_MUL_SYNTH(window[0xB], b0l[0xB]);
+			sumr -= REAL_MUL_SYNTH(window[0xB], b0r[0xB]);
+			suml += REAL_MUL_SYNTH(window[0xC], b0l[0xC]);
+			sumr += REAL_MUL_SYNTH(window[0xC], b0r[0xC]);
+			suml -= REAL_MUL_SYNTH(window[0xD], b0l[0xD]);
+			sumr -= REAL_MUL_SYNTH(window[0xD], b0r[0xD]);
+			suml += REAL_MUL_SYNTH(window[0xE], b0l[0xE]);
+			sumr += REAL_MUL_SYNTH(window[0xE], b0r[0xE]);
+			suml -= REAL_MUL_SYNTH(window[0xF], b0l[0xF]);
+			sumr -= REAL_MUL_SYNTH(window[0xF], b0r[0xF]);
+
+			ADD_DITHER(fr,suml,sumr)
+			WRITE_SAMPLE(samples,suml,clip);
+			WRITE_SAMPLE(samples+1,sumr,clip);
+		}
+
+		{
+			real suml, sumr;
+			suml = REAL_MUL_SYNTH(window[0x0], b0l[0x0]);
+			sumr = REAL_MUL_SYNTH(window[0x0], b0r[0x0]);
+			suml += REAL_MUL_SYNTH(window[0x2], b0l[0x2]);
+			sumr += REAL_MUL_SYNTH(window[0x2], b0r[0x2]);
+			suml += REAL_MUL_SYNTH(window[0x4], b0l[0x4]);
+			sumr += REAL_MUL_SYNTH(window[0x4], b0r[0x4]);
+			suml += REAL_MUL_SYNTH(window[0x6], b0l[0x6]);
+			sumr += REAL_MUL_SYNTH(window[0x6], b0r[0x6]);
+			suml += REAL_MUL_SYNTH(window[0x8], b0l[0x8]);
+			sumr += REAL_MUL_SYNTH(window[0x8], b0r[0x8]);
+			suml += REAL_MUL_SYNTH(window[0xA], b0l[0xA]);
+			sumr += REAL_MUL_SYNTH(window[0xA], b0r[0xA]);
+			suml += REAL_MUL_SYNTH(window[0xC], b0l[0xC]);
+			sumr += REAL_MUL_SYNTH(window[0xC], b0r[0xC]);
+			suml += REAL_MUL_SYNTH(window[0xE], b0l[0xE]);
+			sumr += REAL_MUL_SYNTH(window[0xE], b0r[0xE]);
+
+			ADD_DITHER(fr,suml,sumr)
+			WRITE_SAMPLE(samples,suml,clip);
+			WRITE_SAMPLE(samples+1,sumr,clip);
+			samples += step;
+			b0l-=0x400/BLOCK;
+			b0r-=0x400/BLOCK;
+			window-=0x800/BLOCK;
+		}
+		window += bo1<<1;
+
+		for(j=(BLOCK/4)-1; j; j--, b0l-=0x400/BLOCK, b0r-=0x400/BLOCK, window-=0x800/BLOCK, samples+=step)
+		{
+			real suml, sumr;
+			suml = -REAL_MUL_SYNTH(window[-0x1], b0l[0x0]);
+			sumr = -REAL_MUL_SYNTH(window[-0x1], b0r[0x0]);
+			suml -= REAL_MUL_SYNTH(window[-0x2], b0l[0x1]);
+			sumr -= REAL_MUL_SYNTH(window[-0x2], b0r[0x1]);
+			suml -= REAL_MUL_SYNTH(window[-0x3], b0l[0x2]);
+			sumr -= REAL_MUL_SYNTH(window[-0x3], b0r[0x2]);
+			suml -= REAL_MUL_SYNTH(window[-0x4], b0l[0x3]);
+			sumr -= REAL_MUL_SYNTH(window[-0x4], b0r[0x3]);
+			suml -= REAL_MUL_SYNTH(window[-0x5], b0l[0x4]);
+			sumr -= REAL_MUL_SYNTH(window[-0x5], b0r[0x4]);
+			suml -= REAL_MUL_SYNTH(window[-0x6], b0l[0x5]);
+			sumr -= REAL_MUL_SYNTH(window[-0x6], b0r[0x5]);
+			suml -= REAL_MUL_SYNTH(window[-0x7], b0l[0x6]);
+			sumr -= REAL_MUL_SYNTH(window[-0x7], b0r[0x6]);
+			suml -= REAL_MUL_SYNTH(window[-0x8], b0l[0x7]);
+			sumr -= REAL_MUL_SYNTH(window[-0x8], b0r[0x7]);
+			suml -= REAL_MUL_SYNTH(window[-0x9], b0l[0x8]);
+			sumr -= REAL_MUL_SYNTH(window[-0x9], b0r[0x8]);
+			suml -= REAL_MUL_SYNTH(window[-0xA], b0l[0x9]);
+			sumr -= REAL_MUL_SYNTH(window[-0xA], b0r[0x9]);
+			suml -= REAL_MUL_SYNTH(window[-0xB], b0l[0xA]);
+			sumr -= REAL_MUL_SYNTH(window[-0xB], b0r[0xA]);
+			suml -= REAL_MUL_SYNTH(window[-0xC], b0l[0xB]);
+			sumr -= REAL_MUL_SYNTH(window[-0xC], b0r[0xB]);
+			suml -= REAL_MUL_SYNTH(window[-0xD], b0l[0xC]);
+			sumr -= REAL_MUL_SYNTH(window[-0xD], b0r[0xC]);
+			suml -= REAL_MUL_SYNTH(window[-0xE], b0l[0xD]);
+			sumr -= REAL_MUL_SYNTH(window[-0xE], b0r[0xD]);
+			suml -= REAL_MUL_SYNTH(window[-0xF], b0l[0xE]);
+			sumr -= REAL_MUL_SYNTH(window[-0xF], b0r[0xE]);
+			suml -= REAL_MUL_SYNTH(window[-0x10], b0l[0xF]);
+			sumr -= REAL_MUL_SYNTH(window[-0x10], b0r[0xF]);
+
+			ADD_DITHER(fr,suml,sumr)
+			WRITE_SAMPLE(samples,suml,clip);
+			WRITE_SAMPLE(samples+1,sumr,clip);
+		}
+	}
+
+	fr->buffer.fill += BLOCK*sizeof(SAMPLE_T);
+
+	return clip;
+#undef ADD_DITHER
+}
+#endif
@@ -23,8 +23,10 @@
 #define BLOCK 0x40 /* One decoding block is 64 samples. */
 
 #define SYNTH_NAME synth_1to1_8bit
+#define STEREO_NAME synth_1to1_8bit_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_1to1_8bit (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_1to1][f_8]
@@ -48,12 +50,16 @@
    I suppose that is still faster than dropping the optimization altogether! */
 
 #define BASE_SYNTH_NAME  fr->synths.plain[r_1to1][f_16]
+#define BASE_STEREO_NAME fr->synths.stereo[r_1to1][f_16]
 #define SYNTH_NAME       synth_1to1_8bit_wrap
+#define STEREO_NAME      synth_1to1_8bit_wrap_stereo
 #define MONO_NAME        synth_1to1_8bit_wrap_mono
 #define MONO2STEREO_NAME synth_1to1_8bit_wrap_m2s
 #include "synth_8bit.h"
 #undef BASE_SYNTH_NAME
+#undef BASE_STEREO_NAME
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #undef MONO_NAME
 #undef MONO2STEREO_NAME
 
@@ -67,8 +73,10 @@
 #define BLOCK 0x20 /* One decoding block is 32 samples. */
 
 #define SYNTH_NAME synth_2to1_8bit
+#define STEREO_NAME synth_2to1_8bit_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_2to1_8bit (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_2to1][f_8]
@@ -96,8 +104,10 @@
 #define BLOCK 0x10 /* One decoding block is 16 samples. */
 
 #define SYNTH_NAME synth_4to1_8bit
+#define STEREO_NAME synth_4to1_8bit_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_4to1_8bit (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_4to1][f_8]
@@ -129,10 +139,12 @@
 
 /* These are all in one header, there's no flexibility to gain. */
 #define SYNTH_NAME       synth_ntom_8bit
+#define STEREO_NAME      synth_ntom_8bit_stereo
 #define MONO_NAME        synth_ntom_8bit_mono
 #define MONO2STEREO_NAME synth_ntom_8bit_m2s
 #include "synth_ntom.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #undef MONO_NAME
 #undef MONO2STEREO_NAME
 
@@ -8,6 +8,7 @@
 	Only variable is the BLOCK size to choose 1to1, 2to1 or 4to1.
 	Oh, and the names: BASE_SYNTH_NAME, SYNTH_NAME, MONO_NAME, MONO2STEREO_NAME
 	(p.ex. opt_synth_1to1(fr), synth_1to1_8bit, synth_1to1_8bit_mono, ...).
+	With BASE_STEREO_NAME and STEREO_NAME, there is also a wrapper over a stereo synth.
 */
 
 int SYNTH_NAME(real *bandPtr, int channel, mpg123_handle *fr, int final)
@@ -84,3 +85,26 @@ int MONO2STEREO_NAME(real *bandPtr, mpg123_handle *fr)
 	return ret;
 }
 
+#ifdef STEREO_NAME
+int STEREO_NAME(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	short samples_tmp[BLOCK];
+	short *tmp1 = samples_tmp;
+	int i,ret;
+
+	unsigned char *samples = fr->buffer.data;
+	int pnt = fr->buffer.fill;
+	fr->buffer.data = (unsigned char*) samples_tmp;
+	fr->buffer.fill = 0;
+	ret = BASE_STEREO_NAME(bandPtr_l, bandPtr_r, fr);
+	fr->buffer.data = samples;
+
+	samples += pnt;
+	for(i=0;i<BLOCK;i++)
+	*samples++ = fr->conv16to8[*tmp1++>>AUSHIFT];
+
+	fr->buffer.fill = pnt + BLOCK;
+
+	return ret;
+}
+#endif
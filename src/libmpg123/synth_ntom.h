@@ -3,6 +3,7 @@
 
 	This header is used multiple times to create different variants of this function.
 	Hint: MONO_NAME, MONO2STEREO_NAME, SYNTH_NAME and SAMPLE_T as well as WRITE_SAMPLE do vary.
+	With STEREO_NAME defined, a variant that does both channels at once is added.
 
 	copyright 1995-2008 by the mpg123 project - free software under the terms of the LGPL 2.1
 	see COPYING and AUTHORS files in distribution or http://mpg123.org
@@ -72,9 +73,6 @@ int SYNTH_NAME(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	int clip = 0; 
 	int bo1;
 	int ntom;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -211,3 +209,179 @@ int SYNTH_NAME(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	return clip;
 }
 
+#ifdef STEREO_NAME
+/* Both channels in one go, same sum order as two calls of SYNTH_NAME. */
+int STEREO_NAME(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
+{
+	static const int step = 2;
+	SAMPLE_T *samples = (SAMPLE_T *) (fr->buffer.data + fr->buffer.fill);
+
+	real *b0l, *b0r, **bufl, **bufr;
+	int clip = 0; 
+	int bo1;
+	int ntom;
+	fr->bo--;
+	fr->bo &= 0xf;
+	bufl = fr->real_buffs[0];
+	bufr = fr->real_buffs[1];
+	ntom = fr->ntom_val[0];
+
+	if(fr->bo & 0x1)
+	{
+		b0l = bufl[0];
+		b0r = bufr[0];
+		bo1 = fr->bo;
+		dct64(bufl[1]+((fr->bo+1)&0xf),bufl[0]+fr->bo,bandPtr_l);
+		dct64(bufr[1]+((fr->bo+1)&0xf),bufr[0]+fr->bo,bandPtr_r);
+	}
+	else
+	{
+		b0l = bufl[1];
+		b0r = bufr[1];
+		bo1 = fr->bo+1;
+		dct64(bufl[0]+fr->bo,bufl[1]+fr->bo+1,bandPtr_l);
+		dct64(bufr[0]+fr->bo,bufr[1]+fr->bo+1,bandPtr_r);
+	}
+
+	{
+		register int j;
+		real *window = fr->decwin + 16 - bo1;
+
+		for (j=16;j;j--,b0l+=0x10,b0r+=0x10,window+=0x20)
+		{
+			real suml, sumr;
+
+			ntom += fr->ntom_step;
+			if(ntom < NTOM_MUL) continue;
+
+			suml = REAL_MUL_SYNTH(window[0x0], b0l[0x0]);
+			sumr = REAL_MUL_SYNTH(window[0x0], b0r[0x0]);
+			suml -= REAL_MUL_SYNTH(window[0x1], b0l[0x1]);
+			sumr -= REAL_MUL_SYNTH(window[0x1], b0r[0x1]);
+			suml += REAL_MUL_SYNTH(window[0x2], b0l[0x2]);
+			sumr += REAL_MUL_SYNTH(window[0x2], b0r[0x2]);
+			suml -= REAL_MUL_SYNTH(window[0x3], b0l[0x3]);
+			sumr -= REAL_MUL_SYNTH(window[0x3], b0r[0x3]);
+			suml += REAL_MUL_SYNTH(window[0x4], b0l[0x4]);
+			sumr += REAL_MUL_SYNTH(window[0x4], b0r[0x4]);
+			suml -= REAL_MUL_SYNTH(window[0x5], b0l[0x5]);
+			sumr -= REAL_MUL_SYNTH(window[0x5], b0r[0x5]);
+			suml += REAL_MUL_SYNTH(window[0x6], b0l[0x6]);
+			sumr += REAL_MUL_SYNTH(window[0x6], b0r[0x6]);
+			suml -= REAL_MUL_SYNTH(window[0x7], b0l[0x7]);
+			sumr -= REAL_MUL_SYNTH(window[0x7], b0r[0x7]);
+			suml += REAL_MUL_SYNTH(window[0x8], b0l[0x8]);
+			sumr += REAL_MUL_SYNTH(window[0x8], b0r[0x8]);
+			suml -= REAL_MUL_SYNTH(window[0x9], b0l[0x9]);
+			sumr -= REAL_MUL_SYNTH(window[0x9], b0r[0x9]);
+			suml += REAL_MUL_SYNTH(window[0xA], b0l[0xA]);
+			sumr += REAL_MUL_SYNTH(window[0xA], b0r[0xA]);
+			suml -= REAL_MUL_SYNTH(window[0xB], b0l[0xB]);
+			sumr -= REAL_MUL_SYNTH(window[0xB], b0r[0xB]);
+			suml += REAL_MUL_SYNTH(window[0xC], b0l[0xC]);
+			sumr += REAL_MUL_SYNTH(window[0xC], b0r[0xC]);
+			suml -= REAL_MUL_SYNTH(window[0xD], b0l[0xD]);
+			sumr -= REAL_MUL_SYNTH(window[0xD], b0r[0xD]);
+			suml += REAL_MUL_SYNTH(window[0xE], b0l[0xE]);
+			sumr += REAL_MUL_SYNTH(window[0xE], b0r[0xE]);
+			suml -= REAL_MUL_SYNTH(window[0xF], b0l[0xF]);
+			sumr -= REAL_MUL_SYNTH(window[0xF], b0r[0xF]);
+
+			while(ntom >= NTOM_MUL)
+			{
+				WRITE_SAMPLE(samples,suml,clip);
+				WRITE_SAMPLE(samples+1,sumr,clip);
+				samples += step;
+				ntom -= NTOM_MUL;
+			}
+		}
+
+		ntom += fr->ntom_step;
+		if(ntom >= NTOM_MUL)
+		{
+			real suml, sumr;
+			suml = REAL_MUL_SYNTH(window[0x0], b0l[0x0]);
+			sumr = REAL_MUL_SYNTH(window[0x0], b0r[0x0]);
+			suml += REAL_MUL_SYNTH(window[0x2], b0l[0x2]);
+			sumr += REAL_MUL_SYNTH(window[0x2], b0r[0x2]);
+			suml += REAL_MUL_SYNTH(window[0x4], b0l[0x4]);
+			sumr += REAL_MUL_SYNTH(window[0x4], b0r[0x4]);
+			suml += REAL_MUL_SYNTH(window[0x6], b0l[0x6]);
+			sumr += REAL_MUL_SYNTH(window[0x6], b0r[0x6]);
+			suml += REAL_MUL_SYNTH(window[0x8], b0l[0x8]);
+			sumr += REAL_MUL_SYNTH(window[0x8], b0r[0x8]);
+			suml += REAL_MUL_SYNTH(window[0xA], b0l[0xA]);
+			sumr += REAL_MUL_SYNTH(window[0xA], b0r[0xA]);
+			suml += REAL_MUL_SYNTH(window[0xC], b0l[0xC]);
+			sumr += REAL_MUL_SYNTH(window[0xC], b0r[0xC]);
+			suml += REAL_MUL_SYNTH(window[0xE], b0l[0xE]);
+			sumr += REAL_MUL_SYNTH(window[0xE], b0r[0xE]);
+
+			while(ntom >= NTOM_MUL)
+			{
+				WRITE_SAMPLE(samples,suml,clip);
+				WRITE_SAMPLE(samples+1,sumr,clip);
+				samples += step;
+				ntom -= NTOM_MUL;
+			}
+		}
+
+		b0l-=0x10,b0r-=0x10,window-=0x20;
+		window += bo1<<1;
+
+		for (j=15;j;j--,b0l-=0x10,b0r-=0x10,window-=0x20)
+		{
+			real suml, sumr;
+
+			ntom += fr->ntom_step;
+			if(ntom < NTOM_MUL) continue;
+
+			suml = REAL_MUL_SYNTH(-window[-0x1], b0l[0x0]);
+			sumr = REAL_MUL_SYNTH(-window[-0x1], b0r[0x0]);
+			suml -= REAL_MUL_SYNTH(window[-0x2], b0l[0x1]);
+			sumr -= REAL_MUL_SYNTH(window[-0x2], b0r[0x1]);
+			suml -= REAL_MUL_SYNTH(window[-0x3], b0l[0x2]);
+			sumr -= REAL_MUL_SYNTH(window[-0x3], b0r[0x2]);
+			suml -= REAL_MUL_SYNTH(window[-0x4], b0l[0x3]);
+			sumr -= REAL_MUL_SYNTH(window[-0x4], b0r[0x3]);
+			suml -= REAL_MUL_SYNTH(window[-0x5], b0l[0x4]);
+			sumr -= REAL_MUL_SYNTH(window[-0x5], b0r[0x4]);
+			suml -= REAL_MUL_SYNTH(window[-0x6], b0l[0x5]);
+			sumr -= REAL_MUL_SYNTH(window[-0x6], b0r[0x5]);
+			suml -= REAL_MUL_SYNTH(window[-0x7], b0l[0x6]);
+			sumr -= REAL_MUL_SYNTH(window[-0x7], b0r[0x6]);
+			suml -= REAL_MUL_SYNTH(window[-0x8], b0l[0x7]);
+			sumr -= REAL_MUL_SYNTH(window[-0x8], b0r[0x7]);
+			suml -= REAL_MUL_SYNTH(window[-0x9], b0l[0x8]);
+			sumr -= REAL_MUL_SYNTH(window[-0x9], b0r[0x8]);
+			suml -= REAL_MUL_SYNTH(window[-0xA], b0l[0x9]);
+			sumr -= REAL_MUL_SYNTH(window[-0xA], b0r[0x9]);
+			suml -= REAL_MUL_SYNTH(window[-0xB], b0l[0xA]);
+			sumr -= REAL_MUL_SYNTH(window[-0xB], b0r[0xA]);
+			suml -= REAL_MUL_SYNTH(window[-0xC], b0l[0xB]);
+			sumr -= REAL_MUL_SYNTH(window[-0xC], b0r[0xB]);
+			suml -= REAL_MUL_SYNTH(window[-0xD], b0l[0xC]);
+			sumr -= REAL_MUL_SYNTH(window[-0xD], b0r[0xC]);
+			suml -= REAL_MUL_SYNTH(window[-0xE], b0l[0xD]);
+			sumr -= REAL_MUL_SYNTH(window[-0xE], b0r[0xD]);
+			suml -= REAL_MUL_SYNTH(window[-0xF], b0l[0xE]);
+			sumr -= REAL_MUL_SYNTH(window[-0xF], b0r[0xE]);
+			suml -= REAL_MUL_SYNTH(window[-0x10], b0l[0xF]);
+			sumr -= REAL_MUL_SYNTH(window[-0x10], b0r[0xF]);
+
+			while(ntom >= NTOM_MUL)
+			{
+				WRITE_SAMPLE(samples,suml,clip);
+				WRITE_SAMPLE(samples+1,sumr,clip);
+				samples += step;
+				ntom -= NTOM_MUL;
+			}
+		}
+	}
+
+	fr->ntom_val[0] = fr->ntom_val[1] = ntom;
+	fr->buffer.fill = ((unsigned char *) samples - fr->buffer.data);
+
+	return clip;
+}
+#endif
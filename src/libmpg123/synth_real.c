@@ -26,8 +26,10 @@
 #define BLOCK 0x40 /* One decoding block is 64 samples. */
 
 #define SYNTH_NAME synth_1to1_real
+#define STEREO_NAME synth_1to1_real_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_1to1_real (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_1to1][f_real]
@@ -62,9 +64,6 @@ int synth_1to1_real_x86_64(real *bandPtr,int channel, mpg123_handle *fr, int fin
 
 	real *b0, **buf;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -103,13 +102,6 @@ int synth_1to1_real_stereo_x86_64(real *bandPtr_l, real *bandPtr_r, mpg123_handl
 
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -154,9 +146,6 @@ int synth_1to1_real_avx(real *bandPtr,int channel, mpg123_handle *fr, int final)
 
 	real *b0, **buf;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -195,13 +184,6 @@ int synth_1to1_fltst_avx(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -244,9 +226,6 @@ int synth_1to1_real_sse(real *bandPtr,int channel, mpg123_handle *fr, int final)
 
 	real *b0, **buf;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -285,13 +264,6 @@ int synth_1to1_real_stereo_sse(real *bandPtr_l, real *bandPtr_r, mpg123_handle *
 
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -334,9 +306,6 @@ int synth_1to1_real_neon(real *bandPtr,int channel, mpg123_handle *fr, int final
 
 	real *b0, **buf;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -374,13 +343,6 @@ int synth_1to1_real_stereo_neon(real *bandPtr_l, real *bandPtr_r, mpg123_handle
 
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -423,9 +385,6 @@ int synth_1to1_real_neon64(real *bandPtr,int channel, mpg123_handle *fr, int fin
 
 	real *b0, **buf;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -463,13 +422,6 @@ int synth_1to1_fltst_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -508,8 +460,10 @@ int synth_1to1_fltst_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x20 /* One decoding block is 32 samples. */
 
 #define SYNTH_NAME synth_2to1_real
+#define STEREO_NAME synth_2to1_real_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_2to1_real (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_2to1][f_real]
@@ -537,8 +491,10 @@ int synth_1to1_fltst_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x10 /* One decoding block is 16 samples. */
 
 #define SYNTH_NAME synth_4to1_real
+#define STEREO_NAME synth_4to1_real_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_4to1_real (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_4to1][f_real]
@@ -570,10 +526,12 @@ int synth_1to1_fltst_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 
 /* These are all in one header, there's no flexibility to gain. */
 #define SYNTH_NAME       synth_ntom_real
+#define STEREO_NAME      synth_ntom_real_stereo
 #define MONO_NAME        synth_ntom_real_mono
 #define MONO2STEREO_NAME synth_ntom_real_m2s
 #include "synth_ntom.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #undef MONO_NAME
 #undef MONO2STEREO_NAME
 
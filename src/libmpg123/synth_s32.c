@@ -25,8 +25,10 @@
 #define BLOCK 0x40 /* One decoding block is 64 samples. */
 
 #define SYNTH_NAME synth_1to1_s32
+#define STEREO_NAME synth_1to1_s32_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_1to1_s32 (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_1to1][f_32]
@@ -59,9 +61,6 @@ int synth_1to1_s32_x86_64(real *bandPtr,int channel, mpg123_handle *fr, int fina
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -102,13 +101,6 @@ int synth_1to1_s32_stereo_x86_64(real *bandPtr_l, real *bandPtr_r, mpg123_handle
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -154,9 +146,6 @@ int synth_1to1_s32_avx(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -197,13 +186,6 @@ int synth_1to1_s32_stereo_avx(real *bandPtr_l, real *bandPtr_r, mpg123_handle *f
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -247,9 +229,6 @@ int synth_1to1_s32_sse(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -290,13 +269,6 @@ int synth_1to1_s32_stereo_sse(real *bandPtr_l, real *bandPtr_r, mpg123_handle *f
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -340,9 +312,6 @@ int synth_1to1_s32_neon(real *bandPtr,int channel, mpg123_handle *fr, int final)
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -382,13 +351,6 @@ int synth_1to1_s32_stereo_neon(real *bandPtr_l, real *bandPtr_r, mpg123_handle *
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -432,9 +394,6 @@ int synth_1to1_s32_neon64(real *bandPtr,int channel, mpg123_handle *fr, int fina
 	real *b0, **buf;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings) do_equalizer(bandPtr,channel,fr->equalizer);
-#endif
 	if(!channel)
 	{
 		fr->bo--;
@@ -474,13 +433,6 @@ int synth_1to1_s32st_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 	real *b0l, *b0r, **bufl, **bufr;
 	int bo1;
 	int clip;
-#ifndef NO_EQUALIZER
-	if(fr->have_eq_settings)
-	{
-		do_equalizer(bandPtr_l,0,fr->equalizer);
-		do_equalizer(bandPtr_r,1,fr->equalizer);
-	}
-#endif
 	fr->bo--;
 	fr->bo &= 0xf;
 	bufl = fr->real_buffs[0];
@@ -521,8 +473,10 @@ int synth_1to1_s32st_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x20 /* One decoding block is 32 samples. */
 
 #define SYNTH_NAME synth_2to1_s32
+#define STEREO_NAME synth_2to1_s32_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_2to1_s32 (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_2to1][f_32]
@@ -550,8 +504,10 @@ int synth_1to1_s32st_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 #define BLOCK 0x10 /* One decoding block is 16 samples. */
 
 #define SYNTH_NAME synth_4to1_s32
+#define STEREO_NAME synth_4to1_s32_stereo
 #include "synth.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 
 /* Mono-related synths; they wrap over _some_ synth_4to1_s32 (could be generic, could be i386). */
 #define SYNTH_NAME       fr->synths.plain[r_4to1][f_32]
@@ -583,10 +539,12 @@ int synth_1to1_s32st_neon64(real *bandPtr_l, real *bandPtr_r, mpg123_handle *fr)
 
 /* These are all in one header, there's no flexibility to gain. */
 #define SYNTH_NAME       synth_ntom_s32
+#define STEREO_NAME      synth_ntom_s32_stereo
 #define MONO_NAME        synth_ntom_s32_mono
 #define MONO2STEREO_NAME synth_ntom_s32_m2s
 #include "synth_ntom.h"
 #undef SYNTH_NAME
+#undef STEREO_NAME
 #undef MONO_NAME
 #undef MONO2STEREO_NAME
 
@@ -38,9 +38,15 @@ enum synth_format
 #	endif
 #	ifndef NO_32BIT
 	,f_32
+	,f_24 /* packed 24 bit, signed or unsigned according to fr->s24_flip */
 #	endif
 	,f_limit
 };
+#ifndef NO_32BIT
+/* The sample type of the f_24 synths. Compilers that pad this to 4 bytes do not
+   get these synths offered (see frame_cpu_opt()). */
+struct s24_sample { unsigned char b[3]; };
+#endif
 struct synth_s
 {
 	func_synth              plain[r_limit][f_limit];
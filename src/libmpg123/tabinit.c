@@ -243,6 +243,7 @@ void make_decode_tables(mpg123_handle *fr)
 	}
 #if defined(OPT_X86_64) || defined(OPT_ALTIVEC) || defined(OPT_SSE) || defined(OPT_SSE_VINTAGE) || defined(OPT_ARM) || defined(OPT_NEON) || defined(OPT_NEON64) || defined(OPT_AVX)
 	if(  fr->cpu_opts.type == x86_64
+	  || fr->cpu_opts.type == x86_64_dither
 	  || fr->cpu_opts.type == altivec
 	  || fr->cpu_opts.type == sse
 	  || fr->cpu_opts.type == sse_vintage
@@ -424,6 +424,51 @@ size_t buffer_write(out123_handle *ao, void *buffer, size_t bytes)
 	return written;
 }
 
+/* Free memory right at the write position, after waiting for the buffer to
+   make room. *mem stays NULL if that does not come in one piece, or if
+   waiting for it could keep the buffer from ever getting a burst to play. */
+int buffer_reserve(out123_handle *ao, size_t bytes, void **mem)
+{
+	txfermem *xf = ao->buffermem;
+
+	*mem = NULL;
+	if( bytes > xf->size/2 || bytes > xf->size - outburst
+	||  xf->size - xf->freeindex < bytes )
+		return 0;
+	while(xfermem_get_freespace(xf) < bytes)
+	{
+		int ret = xfermem_writer_block(xf);
+		if(ret)
+		{
+			if(!AOQUIET)
+				error1("waiting for buffer memory failed (%i)", ret);
+			if(ret == XF_CMD_ERROR)
+			{
+				if(!GOOD_READVAL(xf->fd[XF_WRITER], ao->errcode))
+					ao->errcode = OUT123_BUFFER_ERROR;
+			}
+			else
+				ao->errcode = OUT123_BUFFER_ERROR;
+			return -1;
+		}
+	}
+	*mem = xf->data+xf->freeindex;
+	return 0;
+}
+
+/* Hand over data written to the memory from buffer_reserve(). */
+size_t buffer_commit(out123_handle *ao, size_t bytes)
+{
+	txfermem *xf = ao->buffermem;
+
+	xf->freeindex = (xf->freeindex + bytes) % xf->size;
+	if(xfermem_putcmd(xf->fd[XF_WRITER], XF_CMD_DATA) < 0)
+	{
+		ao->errcode = OUT123_BUFFER_ERROR;
+		return 0;
+	}
+	return bytes;
+}
 
 /*
 	Code for the buffer process itself.
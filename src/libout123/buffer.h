@@ -50,6 +50,9 @@ void buffer_drop(out123_handle *ao);
 
 /* The actual work: Hand over audio data. */
 size_t buffer_write(out123_handle *ao, void *buffer, size_t bytes);
+/* Or let the caller write into the buffer memory directly. */
+int buffer_reserve(out123_handle *ao, size_t bytes, void **mem);
+size_t buffer_commit(out123_handle *ao, size_t bytes);
 
 /* Thin wrapper over xfermem giving the current buffer fill. */
 size_t buffer_fill(out123_handle *ao);
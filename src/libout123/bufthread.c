@@ -0,0 +1,614 @@
+/*
+	bufthread: output buffer in a thread of the calling process
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+
+	See bufthread.h for the idea. The operations mirror buffer.c, just that
+	the commands are plain function calls on the thread's own out123 handle
+	instead of messages over a pipe.
+
+	Audio data: The caller copies into the ring and advances the written
+	counter, the thread plays from the ring and advances the taken counter.
+	Each counter has only one writer and both only grow, written-taken is the
+	fill. Nobody takes the lock for that. Only a side that is about to sleep
+	takes the lock and announces how much it waits for, the other side looks
+	at that after moving its counter and signals if the wait is over.
+	The ring is used up to a multiple of the PCM frame size so that every
+	piece in it is whole frames, also around the wrap.
+*/
+
+#include "bufthread.h"
+#include <errno.h>
+#include "debug.h"
+
+#ifndef NOBUFTHREAD
+
+#include <pthread.h>
+
+/* Largest piece handed to the device at once. Commands wait for the current
+   piece, so this is the latency of out123_pause() and out123_drop(). */
+#define BUFTHREAD_BURST 16384
+
+/* Shared counters and the command word. Sequentially consistent, as the
+   sleep/wakeup handshake needs stores to be seen before following loads. */
+#define RING_LOAD(var)       __atomic_load_n(&(var), __ATOMIC_SEQ_CST)
+#define RING_STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_SEQ_CST)
+
+enum bufthread_cmd
+{
+	BT_CMD_NONE = 0
+,	BT_CMD_PARAM
+,	BT_CMD_OPEN
+,	BT_CMD_CLOSE
+,	BT_CMD_AUDIOCAP
+,	BT_CMD_AUDIOFMT
+,	BT_CMD_START
+,	BT_CMD_STOP
+,	BT_CMD_CONTINUE
+,	BT_CMD_DRAIN
+,	BT_CMD_NDRAIN
+,	BT_CMD_PAUSE
+,	BT_CMD_DROP
+,	BT_CMD_TERMINATE
+};
+
+struct bufthread
+{
+	out123_handle *ao; /* the actual output, only touched by the thread */
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake; /* signals the thread: command or enough data */
+	pthread_cond_t done; /* signals the caller: command finished or enough space */
+	unsigned char *data;
+	size_t size;
+	size_t limit;  /* used part of data, whole frames */
+	size_t inpos;  /* caller's position */
+	size_t outpos; /* thread's position */
+	size_t written;      /* bytes put into the ring, stored by the caller */
+	size_t taken;        /* bytes played from the ring, stored by the thread */
+	size_t reader_wants; /* fill the sleeping thread waits for, or 0 */
+	size_t writer_wants; /* space the sleeping caller waits for, or 0 */
+	/* Command and its arguments, handed over via the lock. */
+	int cmd;
+	int result;
+	int errcode;
+	out123_handle *from;
+	const char *driver;
+	const char *device;
+	long rate;
+	int channels;
+	int encoding;
+	const long *rates;
+	int ratecount;
+	int minchannels;
+	int maxchannels;
+	struct mpg123_fmt **fmtlist;
+	size_t bytes;
+	size_t oldfill;
+};
+
+static size_t ring_fill(struct bufthread *bt)
+{
+	return RING_LOAD(bt->written) - RING_LOAD(bt->taken);
+}
+
+/* Forget about the contents. Only while the caller waits for a command. */
+static void ring_reset(struct bufthread *bt)
+{
+	RING_STORE(bt->taken, RING_LOAD(bt->written));
+	bt->inpos = bt->outpos = 0;
+}
+
+/*
+	Code for the buffer thread itself.
+*/
+
+/* Same as in buffer.c: fill that much before starting to play. */
+static size_t preload_size(struct bufthread *bt)
+{
+	size_t preload = 0;
+	if(bt->ao->preload > 0.) preload = (size_t)(bt->ao->preload*bt->limit);
+	if(preload > bt->limit/2) preload = bt->limit/2;
+	return preload;
+}
+
+/* Not more than half the ring: a caller waiting for space then always
+   leaves enough data for the thread to get going again. */
+static size_t burst_size(struct bufthread *bt)
+{
+	return bt->limit/2 < BUFTHREAD_BURST ? bt->limit/2 : BUFTHREAD_BURST;
+}
+
+/* Play at most the given amount of bytes from the ring, return what the
+   device took. An error closes the device, ending playback. */
+static int bufthread_play(struct bufthread *bt, size_t bytes)
+{
+	out123_handle *ao = bt->ao;
+	size_t wants;
+	int written;
+
+	if(bytes > bt->limit - bt->outpos)
+		bytes = bt->limit - bt->outpos;
+	if(bytes > BUFTHREAD_BURST)
+		bytes = BUFTHREAD_BURST;
+	bytes -= bytes % ao->framesize;
+	if(!bytes)
+		return 0;
+	errno = 0;
+	written = ao->write(ao, bt->data+bt->outpos, (int)bytes);
+	debug2("buffer thread wrote %i B / %i B to device", written, (int)bytes);
+	if(written > 0)
+	{
+		bt->outpos = (bt->outpos + written) % bt->limit;
+		RING_STORE(bt->taken, bt->taken + written);
+		wants = RING_LOAD(bt->writer_wants);
+		if(wants && bt->limit - ring_fill(bt) >= wants)
+		{
+			pthread_mutex_lock(&bt->lock);
+			pthread_cond_signal(&bt->done);
+			pthread_mutex_unlock(&bt->lock);
+		}
+	}
+	else if(written < 0 && errno != EINTR)
+	{
+		pthread_mutex_lock(&bt->lock);
+		ao->errcode = OUT123_DEV_PLAY;
+		if(!AOQUIET)
+			error1("Error in writing audio (%s?)!", strerror(errno));
+		out123_close(ao);
+		/* A caller waiting for space would wait forever now. */
+		pthread_cond_signal(&bt->done);
+		pthread_mutex_unlock(&bt->lock);
+	}
+	return written;
+}
+
+/* Play until the ring is empty or the limit reached. */
+static void bufthread_flush(struct bufthread *bt, size_t limit)
+{
+	size_t played = 0;
+	while(bt->ao->state == play_live && played < limit)
+	{
+		size_t bytes = ring_fill(bt);
+		int written;
+		if(!bytes)
+			break;
+		written = bufthread_play( bt
+		,	bytes > limit-played ? limit-played : bytes );
+		if(written <= 0)
+			break;
+		played += written;
+	}
+}
+
+/* Execute the pending command, these are just the normal out123 calls.
+   Returns TRUE when the thread shall end. */
+static int bufthread_command(struct bufthread *bt, int *preloading)
+{
+	out123_handle *ao = bt->ao;
+	int cmd = RING_LOAD(bt->cmd);
+	int ret = 0;
+
+	debug1("buffer thread command %i", cmd);
+	switch(cmd)
+	{
+		case BT_CMD_PARAM:
+			ret = out123_param_from(ao, bt->from);
+		break;
+		case BT_CMD_OPEN:
+			ret = out123_open(ao, bt->driver, bt->device);
+		break;
+		case BT_CMD_CLOSE:
+			out123_close(ao);
+		break;
+		case BT_CMD_AUDIOCAP:
+			ret = out123_encodings(ao, bt->rate, bt->channels);
+		break;
+		case BT_CMD_AUDIOFMT:
+			ret = out123_formats( ao, bt->rates, bt->ratecount
+			,	bt->minchannels, bt->maxchannels, bt->fmtlist );
+		break;
+		case BT_CMD_START:
+			ret = out123_start(ao, bt->rate, bt->channels, bt->encoding);
+			if(!ret)
+			{
+				if(ao->framesize > 0)
+					bt->limit = bt->size - bt->size % ao->framesize;
+				ring_reset(bt);
+				*preloading = TRUE;
+			}
+		break;
+		case BT_CMD_STOP: /* Drain is implied! */
+			bufthread_flush(bt, (size_t)-1);
+			out123_stop(ao);
+		break;
+		case BT_CMD_CONTINUE:
+			out123_continue(ao);
+			*preloading = TRUE;
+		break;
+		case BT_CMD_DRAIN:
+			if(ao->state == play_live)
+			{
+				bufthread_flush(bt, (size_t)-1);
+				out123_drain(ao);
+			}
+		break;
+		case BT_CMD_NDRAIN:
+			if(ao->state == play_live)
+			{
+				/* Whatever got played since the caller looked counts, too. */
+				size_t fill = ring_fill(bt);
+				if(bt->oldfill >= fill && bt->oldfill-fill < bt->bytes)
+					bufthread_flush(bt, bt->bytes - (bt->oldfill-fill));
+				out123_drain(ao);
+			}
+		break;
+		case BT_CMD_PAUSE:
+			out123_pause(ao);
+		break;
+		case BT_CMD_DROP:
+			ring_reset(bt);
+			out123_drop(ao);
+		break;
+		case BT_CMD_TERMINATE:
+		break;
+		default:
+			if(!AOQUIET)
+				error1("Unknown buffer thread command %i.", cmd);
+			ret = OUT123_ERR;
+	}
+
+	pthread_mutex_lock(&bt->lock);
+	bt->result = ret;
+	bt->errcode = ao->errcode;
+	RING_STORE(bt->cmd, BT_CMD_NONE);
+	pthread_cond_signal(&bt->done);
+	pthread_mutex_unlock(&bt->lock);
+	return cmd == BT_CMD_TERMINATE;
+}
+
+static void *bufthread_loop(void *arg)
+{
+	struct bufthread *bt = arg;
+	out123_handle *ao = bt->ao;
+	int preloading = FALSE;
+
+	debug1("buffer thread with preload %g", ao->preload);
+	while(1)
+	{
+		/* Fill level to wait for, 0 if waiting for a command only. */
+		size_t need = 0;
+		int idle = TRUE;
+
+		/* If a device is opened and playing, it is our first duty to keep it playing. */
+		if(ao->state == play_live)
+		{
+			size_t fill = ring_fill(bt);
+			if(preloading)
+				preloading = (fill < preload_size(bt));
+			if(!preloading && fill < burst_size(bt))
+				preloading = TRUE;
+			if(preloading)
+			{
+				need = preload_size(bt);
+				if(need < burst_size(bt))
+					need = burst_size(bt);
+			}
+			else
+			{
+				bufthread_play(bt, fill);
+				idle = FALSE;
+			}
+		}
+		if(idle)
+		{
+			pthread_mutex_lock(&bt->lock);
+			RING_STORE(bt->reader_wants, need);
+			while(!RING_LOAD(bt->cmd) && (!need || ring_fill(bt) < need))
+				pthread_cond_wait(&bt->wake, &bt->lock);
+			RING_STORE(bt->reader_wants, 0);
+			pthread_mutex_unlock(&bt->lock);
+		}
+		if(RING_LOAD(bt->cmd) && bufthread_command(bt, &preloading))
+			break;
+	}
+	return NULL;
+}
+
+/*
+	Functions called from the controlling thread.
+*/
+
+/* Hand over a command and wait for it being done. */
+static int bufthread_cmd(out123_handle *ao, int cmd)
+{
+	struct bufthread *bt = ao->bufthread;
+	int result;
+
+	pthread_mutex_lock(&bt->lock);
+	RING_STORE(bt->cmd, cmd);
+	pthread_cond_signal(&bt->wake);
+	while(RING_LOAD(bt->cmd))
+		pthread_cond_wait(&bt->done, &bt->lock);
+	result = bt->result;
+	if(result < 0)
+		ao->errcode = bt->errcode != OUT123_OK ? bt->errcode : OUT123_BUFFER_ERROR;
+	pthread_mutex_unlock(&bt->lock);
+	return result;
+}
+
+int bufthread_init(out123_handle *ao, size_t bytes)
+{
+	struct bufthread *bt;
+
+	bufthread_exit(ao);
+	if(bytes < BUFTHREAD_BURST) bytes = 2*BUFTHREAD_BURST;
+
+	bt = malloc(sizeof(struct bufthread));
+	if(bt == NULL)
+	{
+		ao->errcode = OUT123_DOOM;
+		return OUT123_ERR;
+	}
+	bt->size = bt->limit = bytes;
+	bt->inpos = bt->outpos = 0;
+	bt->written = bt->taken = 0;
+	bt->reader_wants = bt->writer_wants = 0;
+	bt->cmd = BT_CMD_NONE;
+	bt->result = 0;
+	bt->errcode = OUT123_OK;
+	bt->data = malloc(bytes);
+	bt->ao = out123_new();
+	if(bt->data == NULL || bt->ao == NULL)
+		goto init_fail_mem;
+	out123_param_from(bt->ao, ao);
+
+	if(pthread_mutex_init(&bt->lock, NULL))
+		goto init_fail_mutex;
+	if(pthread_cond_init(&bt->wake, NULL))
+		goto init_fail_wake;
+	if(pthread_cond_init(&bt->done, NULL))
+		goto init_fail_done;
+	if(pthread_create(&bt->thread, NULL, bufthread_loop, bt))
+		goto init_fail_thread;
+
+	ao->bufthread = bt;
+	return 0;
+
+init_fail_thread:
+	pthread_cond_destroy(&bt->done);
+init_fail_done:
+	pthread_cond_destroy(&bt->wake);
+init_fail_wake:
+	pthread_mutex_destroy(&bt->lock);
+init_fail_mutex:
+	if(!AOQUIET)
+		error("cannot start buffer thread!");
+	ao->errcode = OUT123_BUFFER_ERROR;
+init_fail_mem:
+	out123_del(bt->ao);
+	free(bt->data);
+	free(bt);
+	if(ao->errcode == OUT123_OK)
+		ao->errcode = OUT123_DOOM;
+	return OUT123_ERR;
+}
+
+void bufthread_exit(out123_handle *ao)
+{
+	struct bufthread *bt = ao->bufthread;
+	if(bt == NULL) return;
+
+	debug("ending buffer thread");
+	bufthread_stop(ao);
+	bufthread_cmd(ao, BT_CMD_TERMINATE);
+	pthread_join(bt->thread, NULL);
+	/* Proper cleanup of output handle, including out123_close(). */
+	out123_del(bt->ao);
+
+	pthread_cond_destroy(&bt->done);
+	pthread_cond_destroy(&bt->wake);
+	pthread_mutex_destroy(&bt->lock);
+	free(bt->data);
+	free(bt);
+	ao->bufthread = NULL;
+}
+
+int bufthread_sync_param(out123_handle *ao)
+{
+	ao->bufthread->from = ao;
+	return bufthread_cmd(ao, BT_CMD_PARAM);
+}
+
+int bufthread_open(out123_handle *ao, const char* driver, const char* device)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	bt->driver = driver;
+	bt->device = device;
+	if(bufthread_cmd(ao, BT_CMD_OPEN))
+		return -1;
+	/* The thread is idle until the next command, its names can be copied. */
+	if(
+		(bt->ao->driver && !(ao->driver = strdup(bt->ao->driver)))
+	||	(bt->ao->device && !(ao->device = strdup(bt->ao->device)))
+	){
+		ao->errcode = OUT123_DOOM;
+		return -1;
+	}
+	ao->propflags = bt->ao->propflags;
+	return 0;
+}
+
+int bufthread_encodings(out123_handle *ao)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	bt->rate = ao->rate;
+	bt->channels = ao->channels;
+	return bufthread_cmd(ao, BT_CMD_AUDIOCAP);
+}
+
+int bufthread_formats( out123_handle *ao, const long *rates, int ratecount
+                     , int minchannels, int maxchannels
+                     , struct mpg123_fmt **fmtlist )
+{
+	struct bufthread *bt = ao->bufthread;
+
+	bt->rates = rates;
+	bt->ratecount = ratecount;
+	bt->minchannels = minchannels;
+	bt->maxchannels = maxchannels;
+	bt->fmtlist = fmtlist;
+	return bufthread_cmd(ao, BT_CMD_AUDIOFMT);
+}
+
+int bufthread_start(out123_handle *ao)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	bt->rate = ao->rate;
+	bt->channels = ao->channels;
+	bt->encoding = ao->format;
+	return bufthread_cmd(ao, BT_CMD_START);
+}
+
+void bufthread_ndrain(out123_handle *ao, size_t bytes)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	bt->bytes = bytes;
+	bt->oldfill = ring_fill(bt);
+	bufthread_cmd(ao, BT_CMD_NDRAIN);
+}
+
+#define BUFTHREAD_SIMPLE_CONTROL(name, cmd) \
+void name(out123_handle *ao) \
+{ \
+	bufthread_cmd(ao, cmd); \
+}
+
+BUFTHREAD_SIMPLE_CONTROL(bufthread_stop, BT_CMD_STOP)
+BUFTHREAD_SIMPLE_CONTROL(bufthread_close, BT_CMD_CLOSE)
+BUFTHREAD_SIMPLE_CONTROL(bufthread_continue, BT_CMD_CONTINUE)
+BUFTHREAD_SIMPLE_CONTROL(bufthread_drain, BT_CMD_DRAIN)
+BUFTHREAD_SIMPLE_CONTROL(bufthread_pause, BT_CMD_PAUSE)
+BUFTHREAD_SIMPLE_CONTROL(bufthread_drop, BT_CMD_DROP)
+
+size_t bufthread_fill(out123_handle *ao)
+{
+	return ring_fill(ao->bufthread);
+}
+
+/* Wait for the thread to make room, returns -1 if it stopped playing. */
+static int bufthread_wait_space(struct bufthread *bt, size_t need)
+{
+	int live;
+
+	pthread_mutex_lock(&bt->lock);
+	RING_STORE(bt->writer_wants, need);
+	while( (live = (bt->ao->state == play_live))
+	    && bt->limit - ring_fill(bt) < need )
+		pthread_cond_wait(&bt->done, &bt->lock);
+	RING_STORE(bt->writer_wants, 0);
+	pthread_mutex_unlock(&bt->lock);
+	return live ? 0 : -1;
+}
+
+/* Hand over the bytes at the write position, waking the thread if it
+   waits for them. */
+static void ring_advance(struct bufthread *bt, size_t bytes)
+{
+	size_t wants;
+
+	bt->inpos = (bt->inpos + bytes) % bt->limit;
+	RING_STORE(bt->written, bt->written + bytes);
+	wants = RING_LOAD(bt->reader_wants);
+	if(wants && ring_fill(bt) >= wants)
+	{
+		pthread_mutex_lock(&bt->lock);
+		pthread_cond_signal(&bt->wake);
+		pthread_mutex_unlock(&bt->lock);
+	}
+}
+
+/* Error from the thread's handle after it stopped playing. */
+static void bufthread_error(out123_handle *ao)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	pthread_mutex_lock(&bt->lock);
+	ao->errcode = bt->ao->errcode != OUT123_OK
+	?	bt->ao->errcode
+	:	OUT123_NOT_LIVE;
+	pthread_mutex_unlock(&bt->lock);
+	if(!AOQUIET)
+		error("buffer thread stopped playback");
+}
+
+/* The workhorse: Copy into the ring, in whole frames as out123_play()
+   already trimmed the count. */
+size_t bufthread_write(out123_handle *ao, void *buffer, size_t bytes)
+{
+	struct bufthread *bt = ao->bufthread;
+	unsigned char *in = buffer;
+	size_t written = 0;
+
+	while(bytes)
+	{
+		size_t piece = bt->limit - ring_fill(bt);
+
+		if(!piece)
+		{
+			/* Do not get woken up for each little piece the device takes. */
+			if(bufthread_wait_space(bt, bytes < bt->limit/2 ? bytes : bt->limit/2))
+			{
+				bufthread_error(ao);
+				break;
+			}
+			continue;
+		}
+		if(piece > bytes)
+			piece = bytes;
+		if(piece > bt->limit - bt->inpos)
+		{
+			size_t first = bt->limit - bt->inpos;
+			memcpy(bt->data+bt->inpos, in, first);
+			memcpy(bt->data, in+first, piece-first);
+		}
+		else
+			memcpy(bt->data+bt->inpos, in, piece);
+		ring_advance(bt, piece);
+		in      += piece;
+		bytes   -= piece;
+		written += piece;
+	}
+	return written;
+}
+
+/* Free ring memory right at the write position, after waiting for the
+   thread to make room. *mem stays NULL if that does not come in one piece. */
+int bufthread_reserve(out123_handle *ao, size_t bytes, void **mem)
+{
+	struct bufthread *bt = ao->bufthread;
+
+	*mem = NULL;
+	if(bytes > bt->limit/2 || bt->limit - bt->inpos < bytes)
+		return 0;
+	if(bt->limit - ring_fill(bt) < bytes && bufthread_wait_space(bt, bytes))
+	{
+		bufthread_error(ao);
+		return -1;
+	}
+	*mem = bt->data+bt->inpos;
+	return 0;
+}
+
+size_t bufthread_commit(out123_handle *ao, size_t bytes)
+{
+	ring_advance(ao->bufthread, bytes);
+	return bytes;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+	bufthread.h: output buffer in a thread of the calling process
+
+	copyright 2016 by the mpg123 project - free software under the terms of the LGPL 2.1
+	see COPYING and AUTHORS files in distribution or http://mpg123.org
+*/
+
+/*
+	Same job as buffer.[hc], same set of operations, but without fork():
+	A thread plays from a ring buffer into a private out123 handle, the
+	caller's handle is only a proxy. Audio data goes through a single-producer,
+	single-consumer ring that needs no locking, a command mailbox protected by
+	a mutex handles the rest.
+*/
+
+#ifndef _MPG123_BUFTHREAD_H_
+#define _MPG123_BUFTHREAD_H_
+
+#include "out123_int.h"
+
+#ifndef NOBUFTHREAD
+
+int  bufthread_init(out123_handle *ao, size_t bytes);
+void bufthread_exit(out123_handle *ao);
+
+int bufthread_sync_param(out123_handle *ao);
+int bufthread_open(out123_handle *ao, const char* driver, const char* device);
+int bufthread_encodings(out123_handle *ao);
+int bufthread_formats( out123_handle *ao, const long *rates, int ratecount
+                     , int minchannels, int maxchannels
+                     , struct mpg123_fmt **fmtlist );
+int bufthread_start(out123_handle *ao);
+void bufthread_ndrain(out123_handle *ao, size_t bytes);
+
+void bufthread_stop(out123_handle *ao);
+void bufthread_close(out123_handle *ao);
+void bufthread_continue(out123_handle *ao);
+void bufthread_drain(out123_handle *ao);
+void bufthread_pause(out123_handle *ao);
+void bufthread_drop(out123_handle *ao);
+
+/* Copy audio data into the ring, blocking while it is full. */
+size_t bufthread_write(out123_handle *ao, void *buffer, size_t bytes);
+/* Or let the caller write into the ring directly. */
+int bufthread_reserve(out123_handle *ao, size_t bytes, void **mem);
+size_t bufthread_commit(out123_handle *ao, size_t bytes);
+
+size_t bufthread_fill(out123_handle *ao);
+
+#endif
+
+#endif
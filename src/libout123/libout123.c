@@ -15,6 +15,13 @@ static int have_buffer(out123_handle *ao)
 	return (ao->buffer_pid != -1);
 }
 #endif
+#ifndef NOBUFTHREAD
+#include "bufthread.h"
+static int have_bufthread(out123_handle *ao)
+{
+	return (ao->bufthread != NULL);
+}
+#endif
 #include "stringlists.h"
 
 #include "debug.h"
@@ -60,6 +67,9 @@ out123_handle* attribute_align_arg out123_new(void)
 	ao->buffer_fd[1] = -1;
 	ao->buffermem = NULL;
 #endif
+#ifndef NOBUFTHREAD
+	ao->bufthread = NULL;
+#endif
 
 	out123_clear_module(ao);
 	ao->driver = NULL;
@@ -76,6 +86,10 @@ out123_handle* attribute_align_arg out123_new(void)
 	ao->preload = 0.;
 	ao->verbose = 0;
 	ao->device_buffer = 0.;
+	ao->scratch = NULL;
+	ao->scratchsize = 0;
+	ao->reserved = NULL;
+	ao->reserved_bytes = 0;
 	return ao;
 }
 
@@ -89,6 +103,8 @@ void attribute_align_arg out123_del(out123_handle *ao)
 #ifndef NOXFERMEM
 	if(have_buffer(ao)) buffer_exit(ao);
 #endif
+	if(ao->scratch)
+		free(ao->scratch);
 	free(ao);
 }
 
@@ -156,9 +172,25 @@ out123_set_buffer(out123_handle *ao, size_t buffer_bytes)
 	   then start new buffer process with newly allocated storage if given
 	   size is non-zero. */
 	out123_close(ao);
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_exit(ao);
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_exit(ao);
+#endif
+	if(buffer_bytes && ao->flags & OUT123_BUFFER_THREAD)
+	{
+#ifndef NOBUFTHREAD
+		return bufthread_init(ao, buffer_bytes);
+#else
+		if(!AOQUIET)
+			error("no buffer thread support in this build");
+		return out123_seterr(ao, OUT123_BUFFER_ERROR);
+#endif
+	}
+#ifndef NOXFERMEM
 	if(buffer_bytes)
 		return buffer_init(ao, buffer_bytes);
 #endif
@@ -202,6 +234,10 @@ out123_param( out123_handle *ao, enum out123_parms code
 			if(!AOQUIET) error1("bad parameter code %i", (int)code);
 			ret = OUT123_ERR;
 	}
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_sync_param(ao);
+#endif
 #ifndef NOXFERMEM
 	/* If there is a buffer, it needs to update its copy of parameters. */
 	if(have_buffer(ao))
@@ -331,6 +367,14 @@ out123_open(out123_handle *ao, const char* driver, const char* device)
 	ao->channels = -1;
 	ao->format = -1;
 
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+	{
+		if(bufthread_open(ao, driver, device))
+			return OUT123_ERR;
+	}
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 	{
@@ -411,6 +455,11 @@ void attribute_align_arg out123_close(out123_handle *ao)
 
 	out123_drain(ao);
 
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_close(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_close(ao);
@@ -468,6 +517,19 @@ out123_start(out123_handle *ao, long rate, int channels, int encoding)
 	ao->format    = encoding;
 	ao->framesize = mpg123_samplesize(encoding)*channels;
 
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+	{
+		if(!bufthread_start(ao))
+		{
+			ao->state = play_live;
+			return OUT123_OK;
+		}
+		else
+			return OUT123_ERR;
+	}
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 	{
@@ -494,6 +556,9 @@ void attribute_align_arg out123_pause(out123_handle *ao)
 	debug1("out123_pause(%p)", (void*)ao);
 	if(ao && ao->state == play_live)
 	{
+#ifndef NOBUFTHREAD
+		if(have_bufthread(ao)) bufthread_pause(ao);
+#endif
 #ifndef NOXFERMEM
 		if(have_buffer(ao)) buffer_pause(ao);
 #endif
@@ -507,6 +572,9 @@ void attribute_align_arg out123_continue(out123_handle *ao)
 	debug1("out123_continue(%p)", (void*)ao);
 	if(ao && ao->state == play_paused)
 	{
+#ifndef NOBUFTHREAD
+		if(have_bufthread(ao)) bufthread_continue(ao);
+#endif
 #ifndef NOXFERMEM
 		if(have_buffer(ao)) buffer_continue(ao);
 #endif
@@ -521,8 +589,14 @@ void attribute_align_arg out123_stop(out123_handle *ao)
 	if(!ao)
 		return;
 	ao->errcode = 0;
+	ao->reserved = NULL;
 	if(!(ao->state == play_paused || ao->state == play_live))
 		return;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_stop(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_stop(ao);
@@ -553,6 +627,11 @@ out123_play(out123_handle *ao, void *bytes, size_t count)
 	count -= count % ao->framesize;
 	if(!count) return 0;
 
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		return bufthread_write(ao, bytes, count);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		return buffer_write(ao, bytes, count);
@@ -575,6 +654,88 @@ out123_play(out123_handle *ao, void *bytes, size_t count)
 	return sum;
 }
 
+void* attribute_align_arg out123_reserve(out123_handle *ao, size_t bytes)
+{
+	void *mem = NULL;
+
+	debug2("out123_reserve(%p, %"SIZE_P")", (void*)ao, (size_p)bytes);
+	if(!ao)
+		return NULL;
+	ao->errcode = 0;
+	ao->reserved = NULL;
+	if(!bytes)
+	{
+		ao->errcode = OUT123_ARG_ERROR;
+		return NULL;
+	}
+
+	/* Without a buffer, there is nothing to gain: The device write takes
+	   what is in the scratch memory, just as out123_play() would. */
+	if(ao->state == play_live)
+	{
+#ifndef NOBUFTHREAD
+		if(have_bufthread(ao) && bufthread_reserve(ao, bytes, &mem))
+			return NULL;
+#endif
+#ifndef NOXFERMEM
+		if(have_buffer(ao) && buffer_reserve(ao, bytes, &mem))
+			return NULL;
+#endif
+	}
+	if(!mem)
+	{
+		if(ao->scratchsize < bytes)
+		{
+			unsigned char *scratch = realloc(ao->scratch, bytes);
+			if(!scratch)
+			{
+				ao->errcode = OUT123_DOOM;
+				return NULL;
+			}
+			ao->scratch = scratch;
+			ao->scratchsize = bytes;
+		}
+		mem = ao->scratch;
+	}
+	ao->reserved = mem;
+	ao->reserved_bytes = bytes;
+	return mem;
+}
+
+size_t attribute_align_arg out123_commit(out123_handle *ao, size_t bytes)
+{
+	unsigned char *mem;
+
+	debug2("out123_commit(%p, %"SIZE_P")", (void*)ao, (size_p)bytes);
+	if(!ao)
+		return 0;
+	ao->errcode = 0;
+	mem = ao->reserved;
+	ao->reserved = NULL;
+	if(!bytes)
+		return 0;
+	if(!mem || bytes > ao->reserved_bytes)
+	{
+		ao->errcode = OUT123_ARG_ERROR;
+		return 0;
+	}
+	if(mem == ao->scratch)
+		return out123_play(ao, mem, bytes);
+
+	/* Data is in the buffer already, only the count is to be handed over. */
+	bytes -= bytes % ao->framesize;
+	if(!bytes) return 0;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		return bufthread_commit(ao, bytes);
+#endif
+#ifndef NOXFERMEM
+	if(have_buffer(ao))
+		return buffer_commit(ao, bytes);
+#endif
+	return 0;
+}
+
 /* Drop means to flush it down. Quickly. */
 void attribute_align_arg out123_drop(out123_handle *ao)
 {
@@ -582,6 +743,12 @@ void attribute_align_arg out123_drop(out123_handle *ao)
 	if(!ao)
 		return;
 	ao->errcode = 0;
+	ao->reserved = NULL;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_drop(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_drop(ao);
@@ -601,6 +768,11 @@ void attribute_align_arg out123_drain(out123_handle *ao)
 	ao->errcode = 0;
 	if(ao->state != play_live)
 		return;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_drain(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_drain(ao);
@@ -618,6 +790,11 @@ void attribute_align_arg out123_ndrain(out123_handle *ao, size_t bytes)
 	ao->errcode = 0;
 	if(ao->state != play_live)
 		return;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		bufthread_ndrain(ao, bytes);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		buffer_ndrain(ao, bytes);
@@ -884,6 +1061,11 @@ out123_encodings(out123_handle *ao, long rate, int channels)
 
 	ao->channels = channels;
 	ao->rate     = rate;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		return bufthread_encodings(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		return buffer_encodings(ao);
@@ -934,6 +1116,12 @@ int out123_formats( out123_handle *ao, const long *rates, int ratecount
 		return out123_seterr(ao, OUT123_ARG_ERROR);
 	*fmtlist = NULL; /* Initialize so free(fmtlist) is always allowed. */
 
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		return bufthread_formats( ao, rates, ratecount
+		                        , minchannels, maxchannels, fmtlist );
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		return buffer_formats( ao, rates, ratecount
@@ -1002,6 +1190,11 @@ size_t attribute_align_arg out123_buffered(out123_handle *ao)
 	if(!ao)
 		return 0;
 	ao->errcode = 0;
+#ifndef NOBUFTHREAD
+	if(have_bufthread(ao))
+		return bufthread_fill(ao);
+	else
+#endif
 #ifndef NOXFERMEM
 	if(have_buffer(ao))
 		return buffer_fill(ao);
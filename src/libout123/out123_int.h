@@ -20,6 +20,12 @@
 #include "xfermem.h"
 #endif
 
+/* The buffer thread needs POSIX threads and the atomic builtins of
+   gcc >= 4.7 or clang. */
+#if defined(NO_THREADS) || !defined(__ATOMIC_SEQ_CST)
+#define NOBUFTHREAD
+#endif
+
 /* 3% rate tolerance */
 #define AUDIO_RATE_TOLERANCE	  3
 
@@ -57,6 +63,10 @@ struct out123_struct
 	int buffer_fd[2];
 	txfermem *buffermem;
 #endif
+#ifndef NOBUFTHREAD
+	/* Same for the buffer thread, see bufthread.c. */
+	struct bufthread *bufthread;
+#endif
 
 	int fn;			/* filenumber */
 	void *userptr;	/* driver specific pointer */
@@ -87,6 +97,11 @@ struct out123_struct
 	double preload;	/* buffer fraction to preload before play */
 	int verbose;	/* verbosity to stderr */
 	double device_buffer; /* device buffer in seconds */
+	/* Memory for out123_reserve() if the buffer cannot offer it. */
+	unsigned char *scratch;
+	size_t scratchsize;
+	unsigned char *reserved; /* what out123_reserve() handed out, or NULL */
+	size_t reserved_bytes;
 /* TODO int intflag;   ... is it really useful/necessary from the outside? */
 };
 
@@ -34,6 +34,26 @@
 #define buffer_drop IOT123_buffer_drop
 #define buffer_write IOT123_buffer_write
 #define buffer_fill IOT123_buffer_fill
+#define buffer_reserve IOT123_buffer_reserve
+#define buffer_commit IOT123_buffer_commit
+#define bufthread_init IOT123_bufthread_init
+#define bufthread_exit IOT123_bufthread_exit
+#define bufthread_sync_param IOT123_bufthread_sync_param
+#define bufthread_open IOT123_bufthread_open
+#define bufthread_encodings IOT123_bufthread_encodings
+#define bufthread_formats IOT123_bufthread_formats
+#define bufthread_start IOT123_bufthread_start
+#define bufthread_ndrain IOT123_bufthread_ndrain
+#define bufthread_stop IOT123_bufthread_stop
+#define bufthread_close IOT123_bufthread_close
+#define bufthread_continue IOT123_bufthread_continue
+#define bufthread_drain IOT123_bufthread_drain
+#define bufthread_pause IOT123_bufthread_pause
+#define bufthread_drop IOT123_bufthread_drop
+#define bufthread_write IOT123_bufthread_write
+#define bufthread_fill IOT123_bufthread_fill
+#define bufthread_reserve IOT123_bufthread_reserve
+#define bufthread_commit IOT123_bufthread_commit
 #define read_buf IOT123_read_buf
 #define xfermem_init IOT123_xfermem_init
 #define xfermem_init_writer IOT123_xfermem_init_writer
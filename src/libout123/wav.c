@@ -15,6 +15,8 @@
 
 	ThOr: The usage of stdio streams means we loose control over what data is actually written. On a full disk, fwrite() happily suceeds for ages, only a fflush fails.
 	Now: Do we want to fflush() after every write? That defeats the purpose of buffered I/O. So, switching to good old write() is an option (kernel doing disk buffering anyway).
+	Did that now: Data is collected in a big buffer of our own and goes out via
+	write()/writev() in large pieces, the header gets patched at the end.
 
 	ThOr: Again reworked things for libout123, with non-static state.
 	This set of builtin "modules" is what we can use in automated tests
@@ -28,8 +30,16 @@
 #include "wav.h"
 
 #include <errno.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #include "debug.h"
 
+/* Big writes are what file systems (network ones especially) like best,
+   so data is collected and written in pieces of that size, at least. */
+#define WAV_BUFSIZE (1024*1024)
+#define WAV_ALIGN   4096
+
 /* Create the two WAV headers. */
 
 #define WAVE_FORMAT 1
@@ -63,7 +73,7 @@ struct auhead {
 
 struct wavdata
 {
-	FILE *wavfp;
+	int fd;
 	long datalen;
 	int flipendian;
 	int bytes_per_sample;
@@ -76,6 +86,10 @@ struct wavdata
 	*/
 	void *the_header;
 	size_t the_header_size;
+	/* Output buffer, allocated on first write. */
+	unsigned char *rbuf;
+	unsigned char *buf; /* aligned inside rbuf */
+	size_t fill;
 };
 
 static struct wavdata* wavdata_new(void)
@@ -83,13 +97,16 @@ static struct wavdata* wavdata_new(void)
 	struct wavdata *wdat = malloc(sizeof(struct wavdata));
 	if(wdat)
 	{
-		wdat->wavfp = NULL;
+		wdat->fd = -1;
 		wdat->datalen = 0;
 		wdat->flipendian = 0;
 		wdat->bytes_per_sample = -1;
 		wdat->floatwav = 0;
 		wdat->the_header = NULL;
 		wdat->the_header_size = 0;
+		wdat->rbuf = NULL;
+		wdat->buf = NULL;
+		wdat->fill = 0;
 	}
 	return wdat;
 }
@@ -97,10 +114,12 @@ static struct wavdata* wavdata_new(void)
 static void wavdata_del(struct wavdata *wdat)
 {
 	if(!wdat) return;
-	if(wdat->wavfp && wdat->wavfp != stdout)
-		compat_fclose(wdat->wavfp);
+	if(wdat->fd >= 0 && wdat->fd != STDOUT_FILENO)
+		compat_close(wdat->fd);
 	if(wdat->the_header)
 		free(wdat->the_header);
+	if(wdat->rbuf)
+		free(wdat->rbuf);
 	free(wdat);
 }
 
@@ -176,20 +195,22 @@ static int open_file(struct wavdata *wdat, char *filename)
 #endif
 	if(!filename || !strcmp("-",filename) || !strcmp("", filename))
 	{
-		wdat->wavfp = stdout;
+		/* Anything the program put into the stdio stream goes first. */
+		fflush(stdout);
+		wdat->fd = STDOUT_FILENO;
 #ifdef WIN32
 		_setmode(STDOUT_FILENO, _O_BINARY);
 #endif
 		/* If stdout is redirected to a file, seeks suddenly can work.
 		Doing one here to ensure that such a file has the same output
 		it had when opening directly as such. */
-		fseek(wdat->wavfp, 0L, SEEK_SET);
+		lseek(wdat->fd, 0, SEEK_SET);
 		return 0;
 	}
 	else
 	{
-		wdat->wavfp = compat_fopen(filename, "wb");
-		if(!wdat->wavfp)
+		wdat->fd = compat_open(filename, O_CREAT|O_WRONLY|O_TRUNC);
+		if(wdat->fd < 0)
 			return -1;
 		else
 			return 0;
@@ -204,9 +225,9 @@ static int close_file(out123_handle *ao)
 	struct wavdata *wdat = ao->userptr;
 	int ret = 0;
 
-	if(wdat->wavfp != NULL && wdat->wavfp != stdout)
+	if(wdat->fd >= 0 && wdat->fd != STDOUT_FILENO)
 	{
-		if(compat_fclose(wdat->wavfp))
+		if(compat_close(wdat->fd))
 		{
 			if(!AOQUIET)
 				error1("problem closing the audio file, probably because of flushing to disk: %s\n", strerror(errno));
@@ -215,14 +236,105 @@ static int close_file(out123_handle *ao)
 	}
 
 	/* Always cleanup here. */
-	wdat->wavfp = NULL;
+	wdat->fd = -1;
 	wavdata_del(wdat);
 	ao->userptr = NULL;
 	return ret;
 }
 
-/* return: 0 is good, -1 is bad */
-static int write_header(out123_handle *ao)
+/* Write out the buffered data, followed by the given extra bytes, in one
+   go if possible.
+   return: 0 is good, -1 is bad */
+static int write_out(struct wavdata *wdat, unsigned char *extra, size_t extralen)
+{
+#ifdef HAVE_WRITEV
+	struct iovec iov[2];
+	struct iovec *v = iov;
+	int count = 0;
+
+	if(wdat->fill)
+	{
+		iov[count].iov_base = wdat->buf;
+		iov[count].iov_len  = wdat->fill;
+		++count;
+	}
+	if(extralen)
+	{
+		iov[count].iov_base = extra;
+		iov[count].iov_len  = extralen;
+		++count;
+	}
+	while(count)
+	{
+		ssize_t part = writev(wdat->fd, v, count);
+		if(part <= 0)
+		{
+			if(part < 0 && errno == EINTR)
+				continue;
+			return -1;
+		}
+		for(; count && (size_t)part >= v->iov_len; ++v, --count)
+			part -= v->iov_len;
+		if(count)
+		{
+			v->iov_base = (char*)v->iov_base + part;
+			v->iov_len -= part;
+		}
+	}
+#else
+	if(
+		unintr_write(wdat->fd, wdat->buf, wdat->fill) != wdat->fill
+	||	unintr_write(wdat->fd, extra, extralen) != extralen
+	)
+		return -1;
+#endif
+	wdat->fill = 0;
+	return 0;
+}
+
+/* Queue data for writing, actually writing whenever the buffer is full.
+   Big pieces go out directly together with what is buffered.
+   return: 0 is good, -1 is bad */
+static int write_data(struct wavdata *wdat, unsigned char *data, size_t len)
+{
+	size_t piece;
+
+	if(!wdat->buf)
+	{
+		/* Without memory, things still work, only slower. */
+		if(!(wdat->rbuf = malloc(WAV_BUFSIZE+WAV_ALIGN-1)))
+			return write_out(wdat, data, len);
+		wdat->buf = wdat->rbuf + (WAV_ALIGN - (uintptr_t)wdat->rbuf % WAV_ALIGN) % WAV_ALIGN;
+	}
+	if(len < WAV_BUFSIZE - wdat->fill)
+	{
+		memcpy(wdat->buf+wdat->fill, data, len);
+		wdat->fill += len;
+		return 0;
+	}
+	if(len >= WAV_BUFSIZE/2)
+		return write_out(wdat, data, len);
+	/* Top up to keep the writes to full buffers. */
+	piece = WAV_BUFSIZE - wdat->fill;
+	memcpy(wdat->buf+wdat->fill, data, piece);
+	wdat->fill = WAV_BUFSIZE;
+	if(write_out(wdat, NULL, 0))
+		return -1;
+	memcpy(wdat->buf, data+piece, len-piece);
+	wdat->fill = len-piece;
+	return 0;
+}
+
+/* Get the buffered data out, also to see errors now rather than later.
+   return: 0 is good, -1 is bad */
+static int flush_data(struct wavdata *wdat)
+{
+	return wdat->fill ? write_out(wdat, NULL, 0) : 0;
+}
+
+/* The header before the first data, later directly at the file start.
+   return: 0 is good, -1 is bad */
+static int write_header(out123_handle *ao, int rewrite)
 {
 	struct wavdata *wdat = ao->userptr;
 
@@ -231,9 +343,10 @@ static int write_header(out123_handle *ao)
 
 	if(
 		wdat->the_header_size > 0
-	&&	(
-			fwrite(wdat->the_header, wdat->the_header_size, 1, wdat->wavfp) != 1
-		|| fflush(wdat->wavfp)
+	&&	(	rewrite
+		?	unintr_write(wdat->fd, wdat->the_header, wdat->the_header_size)
+			!= wdat->the_header_size
+		:	write_data(wdat, wdat->the_header, wdat->the_header_size) < 0
 		)
 	)
 	{
@@ -550,13 +663,12 @@ wav_open_bad:
 int wav_write(out123_handle *ao, unsigned char *buf, int len)
 {
 	struct wavdata *wdat = ao->userptr;
-	int temp;
 	int i;
 
-	if(!wdat || !wdat->wavfp)
+	if(!wdat || wdat->fd < 0 || len <= 0)
 		return 0; /* Really? Zero? */
 
-	if(wdat->datalen == 0 && write_header(ao) < 0)
+	if(wdat->datalen == 0 && write_header(ao, FALSE) < 0)
 		return -1;
 
 	/* Endianess conversion. Not fancy / optimized. */
@@ -595,20 +707,15 @@ int wav_write(out123_handle *ao, unsigned char *buf, int len)
 		}
 	}
 
-	temp = fwrite(buf, 1, len, wdat->wavfp);
-	if(temp <= 0) return temp;
-/* That would kill it of early when running out of disk space. */
-#if 0
-if(fflush(wdat->wavfp))
-{
-	if(!AOQUIET)
-		error1("flushing failed: %s\n", strerror(errno));
-	return -1;
-}
-#endif
-	wdat->datalen += temp;
+	if(write_data(wdat, buf, len) < 0)
+	{
+		if(!AOQUIET)
+			error1("cannot write audio data: %s", strerror(errno));
+		return -1;
+	}
+	wdat->datalen += len;
 
-	return temp;
+	return len;
 }
 
 int wav_close(out123_handle *ao)
@@ -618,17 +725,18 @@ int wav_close(out123_handle *ao)
 	if(!wdat) /* Special case: Opened only for format query. */
 		return 0;
 
-	if(!wdat || !wdat->wavfp)
+	if(!wdat || wdat->fd < 0)
 		return -1;
 
 	/* flush before seeking to catch out-of-disk explicitly at least at the end */
-	if(fflush(wdat->wavfp))
+	if(flush_data(wdat))
 	{
 		if(!AOQUIET)
 			error1("cannot flush WAV stream: %s", strerror(errno));
-		return close_file(ao);
+		close_file(ao);
+		return -1;
 	}
-	if(fseek(wdat->wavfp, 0L, SEEK_SET) >= 0)
+	if(lseek(wdat->fd, 0, SEEK_SET) >= 0)
 	{
 		if(wdat->floatwav)
 		{
@@ -656,8 +764,8 @@ int wav_close(out123_handle *ao)
 			,	sizeof(inthead->WAVElen));
 		}
 		/* Always (over)writing the header here; also for stdout, when
-		   fseek worked, this overwrite works. */
-		write_header(ao);
+		   lseek worked, this overwrite works. */
+		write_header(ao, TRUE);
 	}
 	else if(!AOQUIET)
 		warning("Cannot rewind WAV file. File-format isn't fully conform now.");
@@ -672,23 +780,24 @@ int au_close(out123_handle *ao)
 	if(!wdat) /* Special case: Opened only for format query. */
 		return 0;
 
-	if(!wdat->wavfp)
+	if(wdat->fd < 0)
 		return -1;
 
 	/* flush before seeking to catch out-of-disk explicitly at least at the end */
-	if(fflush(wdat->wavfp))
+	if(flush_data(wdat))
 	{
 		if(!AOQUIET)
-			error1("cannot flush WAV stream: %s", strerror(errno));
-		return close_file(ao);
+			error1("cannot flush AU stream: %s", strerror(errno));
+		close_file(ao);
+		return -1;
 	}
-	if(fseek(wdat->wavfp, 0L, SEEK_SET) >= 0)
+	if(lseek(wdat->fd, 0, SEEK_SET) >= 0)
 	{
 		struct auhead *auhead = wdat->the_header;
 		long2bigendian(wdat->datalen, auhead->datalen, sizeof(auhead->datalen));
 		/* Always (over)writing the header here; also for stdout, when
-		   fseek worked, this overwrite works. */
-		write_header(ao);
+		   lseek worked, this overwrite works. */
+		write_header(ao, TRUE);
 	}
 	else if(!AOQUIET)
 		warning("Cannot rewind AU file. File-format isn't fully conform now.");
@@ -704,9 +813,16 @@ int raw_close(out123_handle *ao)
 	if(!wdat) /* Special case: Opened only for format query. */
 		return 0;
 
-	if(!wdat->wavfp)
+	if(wdat->fd < 0)
 		return -1;
 
+	if(flush_data(wdat))
+	{
+		if(!AOQUIET)
+			error1("cannot flush raw stream: %s", strerror(errno));
+		close_file(ao);
+		return -1;
+	}
 	return close_file(ao);
 }
 
@@ -740,7 +856,7 @@ int wav_formats(out123_handle *ao)
 	|	MPG123_ENC_SIGNED_32;
 }
 
-/* Draining is flushing to disk. Words do suck at times.
+/* Draining is flushing to disk (well, to the kernel). Words do suck at times.
    One could call fsync(), too, but to be safe, that would need to
    be called on the directory, too. Also, apps randomly calling
    fsync() can cause annoying issues in a system. */
@@ -748,9 +864,9 @@ void wav_drain(out123_handle *ao)
 {
 	struct wavdata *wdat = ao->userptr;
 
-	if(!wdat)
+	if(!wdat || wdat->fd < 0)
 		return;
 
-	if(fflush(wdat->wavfp) && !AOQUIET)
+	if(flush_data(wdat) && !AOQUIET)
 		error1("flushing failed: %s\n", strerror(errno));
 }
@@ -722,13 +722,33 @@ void close_track(void)
 int play_frame(void)
 {
 	unsigned char *audio;
+	unsigned char *mem;
+	size_t block;
 	int mc;
 	long new_header = 0;
 	size_t bytes;
+	size_t played;
 	debug("play_frame");
+	/* Decode right into the output buffer's memory if possible. */
+	block = mpg123_outblock(mh);
+	if(!(mem = out123_reserve(ao, block)))
+	{
+		if(intflag) return 1;
+		error1("Deep trouble! Cannot get output memory: %s", out123_strerror(ao));
+		safe_exit(133);
+	}
+	mpg123_replace_buffer(mh, mem, block);
 	/* The first call will not decode anything but return MPG123_NEW_FORMAT! */
 	mc = mpg123_decode_frame(mh, &framenum, &audio, &bytes);
 	mpg123_getstate(mh, MPG123_FRESH_DECODER, &new_header, NULL);
+	/* After a decoder update, the data is in libmpg123's own buffer. */
+	if(audio == mem)
+		played = out123_commit(ao, bytes);
+	else
+	{
+		out123_commit(ao, 0);
+		played = bytes ? out123_play(ao, audio, bytes) : 0;
+	}
 
 	/* Play what is there to play (starting with second decode_frame call!) */
 	if(bytes)
@@ -741,7 +761,7 @@ int play_frame(void)
 		/* Interrupt here doesn't necessarily interrupt out123_play().
 		   I wonder if that makes us miss errors. Actual issues should
 		   just be postponed. */
-		if(out123_play(ao, audio, bytes) < bytes && !intflag)
+		if(played < bytes && !intflag)
 		{
 			error("Deep trouble! Cannot flush to my output anymore!");
 			safe_exit(133);
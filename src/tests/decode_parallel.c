@@ -0,0 +1,170 @@
+#include "compat.h"
+#include <mpg123.h>
+#include "debug.h"
+#include "testfile.h"
+
+/* Decode the whole file with a plain mpg123_read() loop.
+   After a scan, like mpg123_decode_parallel() does, which may correct the
+   gapless information of a damaged stream. */
+static unsigned char* decode_serial(int fd, size_t *bytes)
+{
+	int err = MPG123_OK;
+	mpg123_handle* mh = NULL;
+	unsigned char *out = NULL;
+	size_t fill = 0, size = 0;
+
+	mh = mpg123_new(NULL, &err);
+	if(mh == NULL) return NULL;
+	if(  lseek(fd, 0, SEEK_SET) != 0 || mpg123_open_fd(mh, fd) != MPG123_OK
+	  || mpg123_scan(mh) != MPG123_OK )
+	goto serial_end;
+	do
+	{
+		size_t got = 0;
+		if(size - fill < 65536)
+		{
+			unsigned char *nout = realloc(out, size += 1024*1024);
+			if(nout == NULL){ free(out); out = NULL; goto serial_end; }
+			out = nout;
+		}
+		err = mpg123_read(mh, out+fill, size-fill, &got);
+		fill += got;
+	} while(err == MPG123_OK || err == MPG123_NEW_FORMAT);
+	if(err != MPG123_DONE){ error1("serial decode failed: %s", mpg123_strerror(mh)); free(out); out = NULL; }
+
+serial_end:
+	mpg123_close(mh);
+	mpg123_delete(mh);
+	*bytes = fill;
+	return out;
+}
+
+static int test_parallel(int fd, int threads, unsigned char *ref, size_t refbytes)
+{
+	int err = MPG123_OK;
+	mpg123_handle* mh = NULL;
+	long rate;
+	int channels, enc;
+	off_t length;
+	size_t size, done = 0;
+	unsigned char *out;
+
+	mh = mpg123_new(NULL, &err);
+	if(mh == NULL) return -1;
+	/* Force a coarse index to have ranges at index steps > 1,
+	   but still more than two of them for a track of some minutes. */
+	mpg123_param(mh, MPG123_INDEX_SIZE, 256, 0.);
+	if(  lseek(fd, 0, SEEK_SET) != 0 || mpg123_open_fd(mh, fd) != MPG123_OK
+	  || mpg123_getformat(mh, &rate, &channels, &enc) != MPG123_OK
+	  || (length = mpg123_length(mh)) < 0 )
+	{
+		error1("cannot open: %s", mpg123_strerror(mh));
+		return -1;
+	}
+	size = length*channels*mpg123_encsize(enc);
+	/* mpg123_length() before the scan is an estimate. */
+	if(size < refbytes) size = refbytes;
+	out = malloc(size);
+	if(out == NULL) return -1;
+	/* Scribble over the buffer, or gaps might get filled with output of a previous run. */
+	memset(out, 0x55, size);
+	err = mpg123_decode_parallel(mh, threads, out, size, &done);
+	if(err != MPG123_OK) error1("parallel decode failed: %s", mpg123_strerror(mh));
+	mpg123_close(mh);
+	mpg123_delete(mh);
+
+	fprintf(stdout, "%i threads: %"SIZE_P" vs. %"SIZE_P" bytes ", threads, (size_p)done, (size_p)refbytes);
+	err = (err == MPG123_OK && done == refbytes && !memcmp(out, ref, refbytes)) ? 0 : -1;
+	free(out);
+	return err;
+}
+
+/* Compare serial and parallel decoding of the file with 1, 2 and 4 threads. */
+static int test_file(int fd)
+{
+	int err = 0, errsum = 0;
+	int threads;
+	size_t refbytes;
+	unsigned char *ref;
+
+	ref = decode_serial(fd, &refbytes);
+	if(ref == NULL) return -1;
+	for(threads=1; threads<=4; threads*=2)
+	{
+		err = test_parallel(fd, threads, ref, refbytes);
+		fprintf(stdout, "%s\n", err == 0 ? "PASS" : "FAIL");
+		errsum += err;
+	}
+	free(ref);
+	return errsum;
+}
+
+/*
+	A copy of the file with the sync of every 13th frame header broken.
+	Decoding has to resync there, which a worker in feeder mode does not
+	necessarily do like the serial decoder on the seekable file. Workers that
+	come across that have to leave the track to serial decoding.
+	Returns a descriptor of a temporary file or -1.
+*/
+static int damaged_copy(const char *path, FILE **tmp)
+{
+	int err = MPG123_OK;
+	mpg123_handle *mh = NULL;
+	unsigned char *data;
+	off_t *offsets, step;
+	size_t size, fill, i;
+	int fd = -1;
+
+	*tmp = NULL;
+	data = slurp(path, &size);
+	if(data == NULL) return -1;
+	mh = mpg123_new(NULL, &err);
+	if(mh == NULL) goto damaged_end;
+	/* A growing index has every frame in it. */
+	mpg123_param(mh, MPG123_INDEX_SIZE, -1000, 0.);
+	if(  mpg123_open(mh, path) != MPG123_OK || mpg123_scan(mh) != MPG123_OK
+	  || mpg123_index(mh, &offsets, &step, &fill) != MPG123_OK )
+	{
+		error1("cannot index: %s", mpg123_strerror(mh));
+		goto damaged_end;
+	}
+	for(i=13; i<fill; i+=13)
+	{
+		size_t pos = (size_t)offsets[i];
+		if(pos+4 > size) break;
+		data[pos+1] = 0;
+	}
+	if(  (*tmp = tmpfile()) != NULL
+	  && fwrite(data, 1, size, *tmp) == size && fflush(*tmp) == 0 )
+	fd = fileno(*tmp);
+
+damaged_end:
+	mpg123_close(mh);
+	mpg123_delete(mh);
+	free(data);
+	return fd;
+}
+
+int main(int argc, char **argv)
+{
+	int errsum = 0;
+	int fd;
+	FILE *tmp;
+	if(argc < 2)
+	{
+		printf("Gimme a MPEG file name...\n");
+		return 0;
+	}
+	mpg123_init();
+	fd = compat_open(argv[1], O_RDONLY);
+	if(fd < 0) return -1;
+	errsum += test_file(fd);
+	compat_close(fd);
+	printf("damaged copy:\n");
+	fd = damaged_copy(argv[1], &tmp);
+	errsum += fd < 0 ? -1 : test_file(fd);
+	if(tmp != NULL) fclose(tmp);
+	mpg123_exit();
+	printf("%s\n", errsum ? "FAIL" : "PASS");
+	return errsum;
+}
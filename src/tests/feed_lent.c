@@ -0,0 +1,101 @@
+#include "compat.h"
+#include <mpg123.h>
+#include "debug.h"
+#include "testfile.h"
+
+static size_t lent_count = 0;
+
+/* Scribble over released buffers so that any later use shows in the output. */
+static void release_chunk(void *handle, const unsigned char *data, size_t size)
+{
+	memset(handle, 0x55, size);
+	free(handle);
+	--lent_count;
+}
+
+/* Feed the file in pieces of chunk bytes (copied or lent), decode all there is after each. */
+static unsigned char* decode_feed(unsigned char *in, size_t inbytes, size_t chunk, int lend, size_t *bytes)
+{
+	int err = MPG123_OK;
+	mpg123_handle* mh = NULL;
+	unsigned char *out = NULL;
+	size_t fill = 0, size = 0, inpos = 0;
+
+	mh = mpg123_new(NULL, &err);
+	if(mh == NULL) return NULL;
+	if(mpg123_open_feed(mh) != MPG123_OK) goto feed_end;
+	while(inpos < inbytes)
+	{
+		size_t piece = inbytes-inpos < chunk ? inbytes-inpos : chunk;
+		if(lend)
+		{
+			unsigned char *copy = malloc(piece);
+			if(copy == NULL){ free(out); out = NULL; goto feed_end; }
+			memcpy(copy, in+inpos, piece);
+			++lent_count;
+			err = mpg123_feed_lent(mh, copy, piece, release_chunk, copy);
+		}
+		else err = mpg123_feed(mh, in+inpos, piece);
+		if(err != MPG123_OK){ error1("feeding failed: %s", mpg123_strerror(mh)); free(out); out = NULL; goto feed_end; }
+		inpos += piece;
+		do
+		{
+			size_t got = 0;
+			if(size - fill < 65536)
+			{
+				unsigned char *nout = realloc(out, size += 1024*1024);
+				if(nout == NULL){ free(out); out = NULL; goto feed_end; }
+				out = nout;
+			}
+			err = mpg123_read(mh, out+fill, size-fill, &got);
+			fill += got;
+		} while(err == MPG123_OK || err == MPG123_NEW_FORMAT);
+		if(err != MPG123_NEED_MORE)
+		{
+			error1("decoding failed: %s", mpg123_strerror(mh));
+			free(out);
+			out = NULL;
+			goto feed_end;
+		}
+	}
+
+feed_end:
+	mpg123_close(mh);
+	mpg123_delete(mh);
+	*bytes = fill;
+	return out;
+}
+
+int main(int argc, char **argv)
+{
+	int errsum = 0;
+	size_t inbytes, refbytes, i;
+	unsigned char *in, *ref;
+	size_t chunks[] = { 500, 4096, 65536, 1<<30 };
+	if(argc < 2)
+	{
+		printf("Gimme a MPEG file name...\n");
+		return 0;
+	}
+	mpg123_init();
+	in = slurp(argv[1], &inbytes);
+	if(in == NULL) return -1;
+	ref = decode_feed(in, inbytes, inbytes, 0, &refbytes);
+	if(ref == NULL) return -1;
+	for(i=0; i<sizeof(chunks)/sizeof(*chunks); ++i)
+	{
+		size_t bytes;
+		int err;
+		unsigned char *out = decode_feed(in, inbytes, chunks[i], 1, &bytes);
+		err = (out != NULL && bytes == refbytes && !memcmp(out, ref, refbytes) && !lent_count) ? 0 : -1;
+		fprintf(stdout, "%"SIZE_P" B chunks: %"SIZE_P" vs. %"SIZE_P" bytes, %"SIZE_P" unreleased %s\n"
+		,	(size_p)chunks[i], (size_p)bytes, (size_p)refbytes, (size_p)lent_count, err == 0 ? "PASS" : "FAIL");
+		errsum += err;
+		free(out);
+	}
+	free(ref);
+	free(in);
+	mpg123_exit();
+	printf("%s\n", errsum ? "FAIL" : "PASS");
+	return errsum;
+}
@@ -0,0 +1,106 @@
+#include "compat.h"
+#include <mpg123.h>
+#include "debug.h"
+
+/* Open the file, import the given index data if any, report the import result. */
+mpg123_handle* open_with(const char *path, const unsigned char *data, size_t size, int *err)
+{
+	mpg123_handle *mh = mpg123_new(NULL, err);
+	if(mh == NULL) return NULL;
+	if(mpg123_open(mh, path) != MPG123_OK)
+	{
+		error1("cannot open: %s", mpg123_strerror(mh));
+		mpg123_delete(mh);
+		return NULL;
+	}
+	*err = data != NULL ? mpg123_import_index(mh, data, size) : MPG123_OK;
+	if(*err == MPG123_ERR) *err = mpg123_errcode(mh);
+	return mh;
+}
+
+/* Same length, same index, same samples after a seek? */
+int compare(mpg123_handle *a, mpg123_handle *b)
+{
+	off_t *ia, *ib;
+	off_t sa, sb;
+	size_t fa, fb, ga, gb;
+	unsigned char bufa[4608], bufb[4608];
+
+	if(mpg123_length(a) != mpg123_length(b)) return -1;
+	if(  mpg123_index(a, &ia, &sa, &fa) != MPG123_OK
+	  || mpg123_index(b, &ib, &sb, &fb) != MPG123_OK
+	  || sa != sb || fa != fb || memcmp(ia, ib, fa*sizeof(off_t)) )
+	return -1;
+	if(  mpg123_seek(a, mpg123_length(a)/2, SEEK_SET) < 0
+	  || mpg123_seek(b, mpg123_length(b)/2, SEEK_SET) < 0 )
+	return -1;
+	mpg123_read(a, bufa, sizeof(bufa), &ga);
+	mpg123_read(b, bufb, sizeof(bufb), &gb);
+	return (ga == gb && !memcmp(bufa, bufb, ga)) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	int errsum = 0;
+	int err;
+	mpg123_handle *ref, *mh;
+	unsigned char *data;
+	size_t size = 0;
+
+	if(argc < 2)
+	{
+		printf("Gimme a MPEG file name...\n");
+		return 0;
+	}
+	mpg123_init();
+	ref = open_with(argv[1], NULL, 0, &err);
+	if(ref == NULL || mpg123_scan(ref) != MPG123_OK) return -1;
+	if(  mpg123_export_index(ref, NULL, &size) != MPG123_OK
+	  || (data = malloc(size)) == NULL
+	  || mpg123_export_index(ref, data, &size) != MPG123_OK )
+	{
+		error1("export failed: %s", mpg123_strerror(ref));
+		return -1;
+	}
+	printf("index data: %"SIZE_P" bytes\n", (size_p)size);
+
+	mh = open_with(argv[1], data, size, &err);
+	err = (mh != NULL && err == MPG123_OK && !compare(ref, mh)) ? 0 : -1;
+	printf("import: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	mpg123_delete(mh);
+
+	/* Damage must be noticed. */
+	data[size/2] ^= 0x10;
+	mh = open_with(argv[1], data, size, &err);
+	err = (mh != NULL && err == MPG123_BAD_INDEX_DATA) ? 0 : -1;
+	printf("damaged: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	mpg123_delete(mh);
+	data[size/2] ^= 0x10;
+
+	mh = open_with(argv[1], data, size-8, &err);
+	err = (mh != NULL && err == MPG123_BAD_INDEX_DATA) ? 0 : -1;
+	printf("truncated: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	mpg123_delete(mh);
+
+	/* Also with a different stream. */
+	mh = mpg123_new(NULL, &err);
+	if(mh != NULL && mpg123_open(mh, argv[1]) == MPG123_OK)
+	{
+		mpg123_set_filesize(mh, 12345);
+		err = mpg123_import_index(mh, data, size) == MPG123_ERR
+			&& mpg123_errcode(mh) == MPG123_BAD_INDEX_DATA ? 0 : -1;
+	}
+	else err = -1;
+	printf("other stream: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	mpg123_delete(mh);
+
+	free(data);
+	mpg123_delete(ref);
+	mpg123_exit();
+	printf("%s\n", errsum ? "FAIL" : "PASS");
+	return errsum;
+}
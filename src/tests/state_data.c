@@ -0,0 +1,142 @@
+#include "compat.h"
+#include <mpg123.h>
+#include "debug.h"
+#include "testfile.h"
+
+/* Hand the decoding over to a new handle, via exported state data. */
+static mpg123_handle* migrate(mpg123_handle *mh)
+{
+	int err = MPG123_OK;
+	unsigned char *data = NULL;
+	size_t size = 0;
+	mpg123_handle *nh = NULL;
+
+	if(  mpg123_export_state(mh, NULL, &size) != MPG123_OK
+	  || (data = malloc(size)) == NULL
+	  || mpg123_export_state(mh, data, &size) != MPG123_OK )
+	{
+		error1("export failed: %s", mpg123_strerror(mh));
+		goto migrate_end;
+	}
+	nh = mpg123_new(NULL, &err);
+	if(nh == NULL || mpg123_open_feed(nh) != MPG123_OK) goto migrate_end;
+	if(mpg123_import_state(nh, data, size) != MPG123_OK)
+	{
+		error1("import failed: %s", mpg123_strerror(nh));
+		mpg123_delete(nh);
+		nh = NULL;
+	}
+migrate_end:
+	free(data);
+	mpg123_delete(mh);
+	return nh;
+}
+
+/* Feed the file in pieces of chunk bytes, decode all there is after each.
+   Move to a new handle after feeding the piece that reaches switchpos. */
+static unsigned char* decode_feed(unsigned char *in, size_t inbytes, size_t chunk, size_t switchpos, size_t *bytes)
+{
+	int err = MPG123_OK;
+	mpg123_handle* mh = NULL;
+	unsigned char *out = NULL;
+	size_t fill = 0, size = 0, inpos = 0;
+
+	mh = mpg123_new(NULL, &err);
+	if(mh == NULL) return NULL;
+	if(mpg123_open_feed(mh) != MPG123_OK) goto feed_end;
+	while(inpos < inbytes)
+	{
+		size_t piece = inbytes-inpos < chunk ? inbytes-inpos : chunk;
+		if(mpg123_feed(mh, in+inpos, piece) != MPG123_OK)
+		{
+			error1("feeding failed: %s", mpg123_strerror(mh));
+			free(out); out = NULL; goto feed_end;
+		}
+		inpos += piece;
+		do
+		{
+			size_t got = 0;
+			if(size - fill < 65536)
+			{
+				unsigned char *nout = realloc(out, size += 1024*1024);
+				if(nout == NULL){ free(out); out = NULL; goto feed_end; }
+				out = nout;
+			}
+			err = mpg123_read(mh, out+fill, size-fill, &got);
+			fill += got;
+		} while(err == MPG123_OK || err == MPG123_NEW_FORMAT);
+		if(err != MPG123_NEED_MORE)
+		{
+			error1("decoding failed: %s", mpg123_strerror(mh));
+			free(out); out = NULL; goto feed_end;
+		}
+		if(inpos >= switchpos && inpos-piece < switchpos)
+		{
+			mh = migrate(mh);
+			if(mh == NULL){ free(out); out = NULL; goto feed_end; }
+		}
+	}
+	*bytes = fill;
+feed_end:
+	mpg123_delete(mh);
+	return out;
+}
+
+int main(int argc, char **argv)
+{
+	int errsum = 0;
+	int err;
+	size_t inbytes = 0, refbytes = 0, bytes = 0, size = 0;
+	unsigned char *in, *ref, *out, *data;
+	mpg123_handle *mh;
+
+	if(argc < 2)
+	{
+		printf("Gimme a MPEG file name...\n");
+		return 0;
+	}
+	mpg123_init();
+	in = slurp(argv[1], &inbytes);
+	if(in == NULL) return -1;
+	ref = decode_feed(in, inbytes, 4096, inbytes, &refbytes);
+	if(ref == NULL) return -1;
+
+	/* Odd chunk sizes to stop at different points inside frames. */
+	out = decode_feed(in, inbytes, 1000, inbytes/3, &bytes);
+	err = (out != NULL && bytes == refbytes && !memcmp(out, ref, bytes)) ? 0 : -1;
+	printf("migrated: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	free(out);
+
+	/* Damage must be noticed, and only a fresh feed takes a state. */
+	mh = mpg123_new(NULL, &err);
+	if(mh != NULL && mpg123_open_feed(mh) == MPG123_OK && mpg123_feed(mh, in, inbytes/2) == MPG123_OK)
+	{
+		do err = mpg123_read(mh, ref, refbytes, &bytes);
+		while(err == MPG123_OK || err == MPG123_NEW_FORMAT);
+		if(  mpg123_export_state(mh, NULL, &size) == MPG123_OK
+		  && (data = malloc(size)) != NULL )
+		{
+			mpg123_export_state(mh, data, &size);
+			err = (mpg123_import_state(mh, data, size) == MPG123_ERR
+				&& mpg123_errcode(mh) == MPG123_NO_STATE) ? 0 : -1;
+			mpg123_open_feed(mh);
+			data[size/2] ^= 0x10;
+			if(  mpg123_import_state(mh, data, size) != MPG123_ERR
+			  || mpg123_errcode(mh) != MPG123_BAD_STATE_DATA )
+			err = -1;
+			free(data);
+		}
+		else err = -1;
+	}
+	else err = -1;
+	printf("rejected: %s\n", err ? "FAIL" : "PASS");
+	errsum += err;
+	mpg123_delete(mh);
+
+	free(ref);
+	free(in);
+	mpg123_exit();
+	printf("%s\n", errsum ? "FAIL" : "PASS");
+	return errsum;
+}
@@ -0,0 +1,23 @@
+/* Helper for the tests that work on the file contents in memory. */
+
+/* Read the whole file, return malloc()ed data or NULL. */
+static unsigned char* slurp(const char *path, size_t *bytes)
+{
+	FILE *f = fopen(path, "rb");
+	unsigned char *data = NULL;
+	size_t size = 0, fill = 0;
+	if(f == NULL) return NULL;
+	while(!feof(f) && !ferror(f))
+	{
+		if(size - fill < 65536)
+		{
+			unsigned char *ndata = realloc(data, size += 1024*1024);
+			if(ndata == NULL){ free(data); fclose(f); return NULL; }
+			data = ndata;
+		}
+		fill += fread(data+fill, 1, size-fill, f);
+	}
+	fclose(f);
+	*bytes = fill;
+	return data;
+}